@@ -0,0 +1,775 @@
+#include <asio/connect.hpp>
+#include <asio/io_context.hpp>
+#include <asio/ip/tcp.hpp>
+#include <asio/ip/udp.hpp>
+#include <asio/read_until.hpp>
+#include <asio/ssl.hpp>
+#include <asio/steady_timer.hpp>
+#include <asio/write.hpp>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "common.h"
+
+#define BENCH_DEF_CLIENTS 100				// Default number of TCP clients
+#define BENCH_DEF_SENDERS 10				// Default number of sending TCP/SSL clients
+#define BENCH_DEF_DURATION 10				// Default seconds of load
+#define BENCH_DEF_PAYLOAD 32				// Default broadcast payload size
+#define BENCH_DRAIN_TIME 1					// Seconds to wait for in-flight deliveries after the load
+#define BENCH_UDP_TIMEOUT 1000				// Milliseconds before an unanswered UDP command is lost
+#define BENCH_SUB_BITS 5					// Sub-buckets per power of two of the latency histograms
+#define BENCH_MAX_BITS 40					// Largest latency in the histograms (2^40 ns)
+
+/*******************************************************************************************
+* @brief Operations a sending client can issue
+*
+* @details
+* BROADCAST			broadcast to the client's tag in its BG
+* MESSAGE			message (with the sender SAP) to the client's tag in its BG
+* PING				ping
+* LISTEN			leave the BG and listen to another one (stream clients only)
+********************************************************************************************/
+enum class BenchOp
+{
+	BROADCAST,
+	MESSAGE,
+	PING,
+	LISTEN
+};
+#define BENCH_OP_COUNT 4
+
+static const char* const BENCH_OP_NAME[] = { "broadcast", "message", "ping", "listen" };
+
+typedef std::int64_t BenchTick;				// Steady clock time in nanoseconds (shared by all local processes)
+
+static BenchTick benchNow()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/*******************************************************************************************
+* @brief Settings of a benchmark run, given as -x<value> arguments
+********************************************************************************************/
+struct BenchSettings
+{
+	std::string host = "127.0.0.1";			// -a Server address
+	unsigned short port = RDTS_DEF_PORT;	// -p RTDS port (SSL on port + 1)
+	int tcpClients = BENCH_DEF_CLIENTS;		// -t TCP clients (all listen)
+	int sslClients = 0;						// -s SSL clients (all listen)
+	int udpClients = 0;						// -u UDP clients (all send)
+	int senders = BENCH_DEF_SENDERS;		// -n TCP/SSL clients that also send
+	int groups = 1;							// -g Number of BGs
+	int duration = BENCH_DEF_DURATION;		// -d Seconds of load
+	int rate = 0;							// -r Operations per second per sender (0 = closed loop)
+	int payload = BENCH_DEF_PAYLOAD;		// -b Broadcast payload size
+	int threads = 0;						// -T Client threads (0 = hardware concurrency)
+	int mix[BENCH_OP_COUNT] = { 100, 0, 0, 0 };	// -m Weight of each operation
+	std::string handshakes;					// -h SSL connect scenario instead of the load (full or resume)
+	int concurrency = 1;					// -c SSL connections handshaking at the same time (-h)
+};
+
+/*******************************************************************************************
+* @brief Log-linear latency histogram (same bucket layout as the server histograms)
+********************************************************************************************/
+class BenchHistogram
+{
+	static constexpr std::size_t SUB_COUNT = std::size_t(1) << BENCH_SUB_BITS;
+	static constexpr std::size_t BUCKET_COUNT = SUB_COUNT * (BENCH_MAX_BITS - BENCH_SUB_BITS + 1);
+
+	std::vector<std::uint64_t> mCounts;		// Count of each bucket
+	std::uint64_t mTotal;					// Number of recorded latencies
+	std::uint64_t mMax;						// Highest recorded latency
+
+	static std::size_t mBucket(std::uint64_t value)
+	{
+		if (value < SUB_COUNT)
+			return (std::size_t)value;
+		std::size_t exponent = 0;
+		while ((value >> (exponent + 1)) != 0)
+			exponent++;
+		if (exponent >= BENCH_MAX_BITS)
+			return BUCKET_COUNT - 1;
+		auto shift = exponent - BENCH_SUB_BITS;
+		return SUB_COUNT * (shift + 1) + ((value >> shift) & (SUB_COUNT - 1));
+	}
+	static std::uint64_t mBucketMax(const std::size_t bucket)
+	{
+		if (bucket < SUB_COUNT)
+			return bucket;
+		auto shift = bucket / SUB_COUNT - 1;
+		auto lowest = (SUB_COUNT + bucket % SUB_COUNT) << shift;
+		return lowest + (std::uint64_t(1) << shift) - 1;
+	}
+
+public:
+	BenchHistogram() : mCounts(BUCKET_COUNT, 0), mTotal(0), mMax(0) {}
+
+	void record(BenchTick latency)
+	{
+		auto value = (std::uint64_t)std::max<BenchTick>(latency, 0);
+		mCounts[mBucket(value)]++;
+		mTotal++;
+		mMax = std::max(mMax, value);
+	}
+	void merge(const BenchHistogram& other)
+	{
+		for (std::size_t bucket = 0; bucket < BUCKET_COUNT; bucket++)
+			mCounts[bucket] += other.mCounts[bucket];
+		mTotal += other.mTotal;
+		mMax = std::max(mMax, other.mMax);
+	}
+	std::uint64_t total() const
+	{
+		return mTotal;
+	}
+/*******************************************************************************************
+* @brief Get the latency below which a fraction of the recorded latencies fall (ns)
+********************************************************************************************/
+	std::uint64_t percentile(const double fraction) const
+	{
+		auto rank = (std::uint64_t)(fraction * mTotal);
+		std::uint64_t seen = 0;
+		for (std::size_t bucket = 0; bucket < BUCKET_COUNT; bucket++)
+		{
+			seen += mCounts[bucket];
+			if (seen > rank)
+				return std::min(mBucketMax(bucket), mMax);
+		}
+		return mMax;
+	}
+/*******************************************************************************************
+* @brief Write the histogram as a JSON object (microseconds)
+********************************************************************************************/
+	std::string json() const
+	{
+		char jsonStr[256];
+		std::snprintf(jsonStr, sizeof(jsonStr),
+			"{\"count\": %llu, \"p50_us\": %.1f, \"p90_us\": %.1f, \"p99_us\": %.1f, \"p999_us\": %.1f, \"max_us\": %.1f}",
+			(unsigned long long)mTotal, percentile(0.5) / 1e3, percentile(0.9) / 1e3, percentile(0.99) / 1e3,
+			percentile(0.999) / 1e3, mMax / 1e3);
+		return jsonStr;
+	}
+};
+
+/*******************************************************************************************
+* @brief One client thread with its own io_context, counters and histograms
+*
+* @details
+* All clients of a worker run on its thread, so the counters need no synchronization.
+********************************************************************************************/
+struct BenchWorker
+{
+	asio::io_context ioContext;
+	std::thread thread;
+	BenchHistogram commandLatency;			// Command sent to response received
+	BenchHistogram fanoutLatency;			// Broadcast sent to delivered (per receiver)
+	std::uint64_t ops[BENCH_OP_COUNT] = {};	// Completed operations
+	std::uint64_t failures = 0;				// Responses other than success (or lost UDP commands)
+	std::uint64_t deliveries = 0;			// Broadcasts and messages received
+	std::uint64_t bytesOut = 0;				// Bytes written by the clients
+	std::uint64_t bytesIn = 0;				// Bytes read by the clients
+	BenchHistogram handshakeLatency;		// Connect started to SSL handshake completed
+	std::uint64_t handshakes = 0;			// Completed SSL handshakes
+	std::uint64_t resumed = 0;				// Handshakes that resumed the previous session
+};
+
+class BenchClient
+{
+protected:
+	BenchWorker& mWorker;					// Worker running this client
+	const BenchSettings& mSettings;			// Benchmark settings
+	std::atomic_bool& mRunning;				// False once the load phase is over
+	std::mt19937 mRandom;					// Operation and BG chooser
+	std::string mBgID;						// BG the client listens or sends to
+	std::string mCommand;					// Command being written
+	BenchOp mOp;							// Operation in flight
+	int mOpStep;							// Responses still expected for mOp
+	BenchTick mSentTick;					// Time the operation was sent
+	BenchTick mNextTick;					// Earliest time of the next operation (rate limit)
+	asio::steady_timer mTimer;				// Rate limit and UDP timeout timer
+	bool mIsSender;							// True if the client sends operations
+
+	BenchClient(BenchWorker& worker, const BenchSettings& settings, std::atomic_bool& running, const int index, const bool isSender) :
+		mWorker(worker), mSettings(settings), mRunning(running), mRandom(index), mOp(BenchOp::PING), mOpStep(0),
+		mSentTick(0), mNextTick(0), mTimer(worker.ioContext), mIsSender(isSender)
+	{
+		mBgID = "bg" + std::to_string(index % settings.groups);
+	}
+
+/*******************************************************************************************
+* @brief Choose the next operation from the mix
+********************************************************************************************/
+	BenchOp mChooseOp(const bool canListen)
+	{
+		int total = 0;
+		for (int op = 0; op < BENCH_OP_COUNT; op++)
+			total += (op == (int)BenchOp::LISTEN && !canListen) ? 0 : mSettings.mix[op];
+		if (total == 0)
+			return BenchOp::PING;
+		auto pick = (int)(mRandom() % total);
+		for (int op = 0; op < BENCH_OP_COUNT; op++)
+		{
+			auto weight = (op == (int)BenchOp::LISTEN && !canListen) ? 0 : mSettings.mix[op];
+			if (pick < weight)
+				return (BenchOp)op;
+			pick -= weight;
+		}
+		return BenchOp::PING;
+	}
+/*******************************************************************************************
+* @brief Build a payload starting with the send time, padded to the payload size
+********************************************************************************************/
+	std::string mPayload(const BenchTick tick)
+	{
+		auto payload = std::to_string(tick);
+		if ((int)payload.size() < mSettings.payload)
+			payload.append(mSettings.payload - payload.size(), 'x');
+		return payload;
+	}
+/*******************************************************************************************
+* @brief Process a line from the server
+*
+* @return			True if the line is the response of the operation in flight
+********************************************************************************************/
+	bool mProcessLine(const std::string_view& line)
+	{
+		mWorker.bytesIn += line.size() + 1;
+		if (line.rfind("[R]", 0) == 0)
+		{
+			if (mOpStep == 0)
+				return false;
+			auto isSuccess = line.find("\tsuccess") != std::string_view::npos || mOp == BenchOp::PING;
+			if (!isSuccess && mOp != BenchOp::LISTEN)
+				mWorker.failures++;
+			return true;
+		}
+		if (line.rfind("[B", 0) == 0 || line.rfind("[M", 0) == 0)
+		{
+			auto payload = line.substr(line.rfind('\t') + 1);
+			auto tick = std::strtoll(std::string(payload.substr(0, payload.find('x'))).c_str(), nullptr, 10);
+			if (tick > 0)
+				mWorker.fanoutLatency.record(benchNow() - tick);
+			mWorker.deliveries++;
+		}
+		return false;
+	}
+/*******************************************************************************************
+* @brief Count a completed operation
+********************************************************************************************/
+	void mCompleteOp()
+	{
+		if (mRunning)
+		{
+			mWorker.ops[(int)mOp]++;
+			mWorker.commandLatency.record(benchNow() - mSentTick);
+		}
+		mOpStep = 0;
+	}
+
+public:
+	virtual ~BenchClient() = default;
+/*******************************************************************************************
+* @brief Start receiving and, for senders, sending operations
+********************************************************************************************/
+	virtual void start() = 0;
+};
+
+/*******************************************************************************************
+* @brief TCP or SSL client that listens to a BG and optionally sends operations
+********************************************************************************************/
+template<typename Socket>
+class BenchStreamClient : public BenchClient
+{
+	Socket mSocket;							// Connection to RTDS
+	std::string mReadBuffer;				// Received data not processed yet
+
+	asio::ip::tcp::socket& mLowest()
+	{
+		if constexpr (std::is_same_v<Socket, asio::ip::tcp::socket>)
+			return mSocket;
+		else
+			return mSocket.next_layer();
+	}
+
+	void mRead()
+	{
+		asio::async_read_until(mSocket, asio::dynamic_buffer(mReadBuffer), '\n',
+			[this](const asio::error_code& ec, std::size_t lineSize)
+		{
+			if (ec)
+				return;
+			auto responded = mProcessLine(std::string_view(mReadBuffer.data(), lineSize - 1));
+			mReadBuffer.erase(0, lineSize);
+			if (responded && --mOpStep == 0)
+			{
+				mCompleteOp();
+				mScheduleNext();
+			}
+			else if (responded && mOp == BenchOp::LISTEN)
+			{
+				mBgID = "bg" + std::to_string(mRandom() % mSettings.groups);
+				mWrite("listen\t" + mBgID + "\tt1\n");
+			}
+			mRead();
+		});
+	}
+
+	void mWrite(std::string command)
+	{
+		mCommand = std::move(command);
+		mWorker.bytesOut += mCommand.size();
+		asio::async_write(mSocket, asio::buffer(mCommand), [](const asio::error_code&, std::size_t) {});
+	}
+
+	void mScheduleNext()
+	{
+		if (!mRunning)
+			return;
+		auto now = benchNow();
+		if (mSettings.rate > 0 && mNextTick > now)
+		{
+			mTimer.expires_after(std::chrono::nanoseconds(mNextTick - now));
+			mTimer.async_wait([this](const asio::error_code& ec) { if (!ec) mSendOp(); });
+		}
+		else
+			mSendOp();
+	}
+
+	void mSendOp()
+	{
+		if (!mRunning)
+			return;
+		mSentTick = benchNow();
+		if (mSettings.rate > 0)
+			mNextTick = std::max(mNextTick, mSentTick) + BenchTick(1000000000) / mSettings.rate;
+		mOp = mChooseOp(true);
+		mOpStep = 1;
+		if (mOp == BenchOp::BROADCAST)
+			mWrite("broadcast\t" + mPayload(mSentTick) + "\n");
+		else if (mOp == BenchOp::MESSAGE)
+			mWrite("message\t" + mPayload(mSentTick) + "\n");
+		else if (mOp == BenchOp::PING)
+			mWrite("ping\n");
+		else
+		{
+			mOpStep = 2;
+			mWrite("leave\n");
+		}
+	}
+
+public:
+	template<typename... SocketArgs>
+	BenchStreamClient(BenchWorker& worker, const BenchSettings& settings, std::atomic_bool& running, const int index,
+		const bool isSender, SocketArgs&&... socketArgs) : BenchClient(worker, settings, running, index, isSender),
+		mSocket(worker.ioContext, std::forward<SocketArgs>(socketArgs)...)
+	{}
+/*******************************************************************************************
+* @brief Connect, handshake (SSL) and listen to the client's BG (blocking)
+*
+* @details
+* Throws asio::system_error on failure.
+********************************************************************************************/
+	void connect(const asio::ip::tcp::endpoint& endpoint)
+	{
+		mLowest().connect(endpoint);
+		mLowest().set_option(asio::ip::tcp::no_delay(true));
+		if constexpr (!std::is_same_v<Socket, asio::ip::tcp::socket>)
+			mSocket.handshake(asio::ssl::stream_base::client);
+
+		auto listen = "listen\t" + mBgID + "\tt1\n";
+		asio::write(mSocket, asio::buffer(listen));
+		while (true)
+		{
+			auto lineSize = asio::read_until(mSocket, asio::dynamic_buffer(mReadBuffer), '\n');
+			auto isResponse = mReadBuffer.rfind("[R]", 0) == 0;
+			mReadBuffer.erase(0, lineSize);
+			if (isResponse)
+				break;
+		}
+	}
+
+	void start() override
+	{
+		mRead();
+		if (mIsSender)
+			mScheduleNext();
+	}
+};
+
+/*******************************************************************************************
+* @brief UDP client that sends operations to a BG
+********************************************************************************************/
+class BenchUDPclient : public BenchClient
+{
+	asio::ip::udp::socket mSocket;			// Connected UDP socket
+	std::array<char, DEF_BUFF_SIZE> mReadBuffer;	// Received datagram
+
+	void mRead()
+	{
+		mSocket.async_receive(asio::buffer(mReadBuffer), [this](const asio::error_code& ec, std::size_t dataSize)
+		{
+			if (ec)
+				return;
+			std::string_view datagram(mReadBuffer.data(), dataSize);
+			if (!datagram.empty() && datagram.back() == '\n')
+				datagram.remove_suffix(1);
+			if (mProcessLine(datagram))
+			{
+				mTimer.cancel();
+				mCompleteOp();
+				mSendOp();
+			}
+			mRead();
+		});
+	}
+
+	void mSendOp()
+	{
+		if (!mRunning)
+			return;
+		mSentTick = benchNow();
+		mOp = mChooseOp(false);
+		mOpStep = 1;
+		if (mOp == BenchOp::BROADCAST)
+			mCommand = "broadcast\t" + mPayload(mSentTick) + "\t" + mBgID + "\tt1\n";
+		else if (mOp == BenchOp::MESSAGE)
+			mCommand = "message\t" + mPayload(mSentTick) + "\t" + mBgID + "\tt1\n";
+		else
+			mCommand = "ping\n";
+		mWorker.bytesOut += mCommand.size();
+
+		asio::error_code ec;
+		mSocket.send(asio::buffer(mCommand), 0, ec);
+		mTimer.expires_after(std::chrono::milliseconds(BENCH_UDP_TIMEOUT));
+		mTimer.async_wait([this](const asio::error_code& ec)
+		{
+			if (ec)
+				return;
+			mWorker.failures++;
+			mOpStep = 0;
+			mSendOp();
+		});
+	}
+
+public:
+	BenchUDPclient(BenchWorker& worker, const BenchSettings& settings, std::atomic_bool& running, const int index,
+		const asio::ip::udp::endpoint& endpoint) : BenchClient(worker, settings, running, index, true),
+		mSocket(worker.ioContext)
+	{
+		mSocket.connect(endpoint);
+	}
+
+	void start() override
+	{
+		mRead();
+		mSendOp();
+	}
+};
+
+/*******************************************************************************************
+* @brief SSL client that connects, handshakes, pings and disconnects in a loop
+*
+* @details
+* With resume, each connection offers the session (ticket) of the previous one, so the
+* handshake rate and latency of resumed and full handshakes can be compared.
+********************************************************************************************/
+class BenchHandshaker
+{
+	typedef asio::ssl::stream<asio::ip::tcp::socket> SSLsocket;
+
+	BenchWorker& mWorker;					// Worker running this client
+	std::atomic_bool& mRunning;				// False once the load phase is over
+	asio::ssl::context& mSSLcontext;		// Client SSL context
+	asio::ip::tcp::endpoint mEndpoint;		// SSL endpoint of RTDS
+	bool mResume;							// True to resume the previous session
+	std::unique_ptr<SSLsocket> mSocket;		// Connection in progress
+	SSL_SESSION* mSession;					// Session offered by the next connection (nullptr for a full handshake)
+	std::string mReadBuffer;				// Ping response
+	BenchTick mStartTick;					// Time the connect started
+
+	void mConnect()
+	{
+		if (!mRunning)
+			return;
+		mSocket = std::make_unique<SSLsocket>(mWorker.ioContext, mSSLcontext);
+		if (mSession != nullptr)
+			::SSL_set_session(mSocket->native_handle(), mSession);
+		mStartTick = benchNow();
+		mSocket->next_layer().async_connect(mEndpoint, [this](const asio::error_code& ec)
+		{
+			if (ec)
+				return mFail();
+			mSocket->next_layer().set_option(asio::ip::tcp::no_delay(true));
+			mSocket->async_handshake(asio::ssl::stream_base::client, [this](const asio::error_code& ec)
+			{
+				if (ec)
+					return mFail();
+				if (mRunning)
+				{
+					mWorker.handshakeLatency.record(benchNow() - mStartTick);
+					mWorker.handshakes++;
+					if (::SSL_session_reused(mSocket->native_handle()))
+						mWorker.resumed++;
+				}
+				mPing();
+			});
+		});
+	}
+/*******************************************************************************************
+* @brief Ping and wait for the response (the TLS 1.3 session ticket arrives before it)
+********************************************************************************************/
+	void mPing()
+	{
+		static const std::string PING = "ping\n";
+		asio::async_write(*mSocket, asio::buffer(PING), [](const asio::error_code&, std::size_t) {});
+		mReadBuffer.clear();
+		asio::async_read_until(*mSocket, asio::dynamic_buffer(mReadBuffer), '\n',
+			[this](const asio::error_code& ec, std::size_t)
+		{
+			if (ec)
+				return mFail();
+			if (mResume)
+			{
+				if (mSession != nullptr)
+					::SSL_SESSION_free(mSession);
+				mSession = ::SSL_get1_session(mSocket->native_handle());
+			}
+			mClose();
+			mConnect();
+		});
+	}
+	void mFail()
+	{
+		if (mRunning)
+			mWorker.failures++;
+		mClose();
+		mConnect();
+	}
+/*******************************************************************************************
+* @brief Close without close_notify (marked as shut down so the session stays resumable)
+********************************************************************************************/
+	void mClose()
+	{
+		::SSL_set_shutdown(mSocket->native_handle(), SSL_SENT_SHUTDOWN | SSL_RECEIVED_SHUTDOWN);
+		asio::error_code ec;
+		mSocket->next_layer().close(ec);
+	}
+
+public:
+	BenchHandshaker(BenchWorker& worker, std::atomic_bool& running, asio::ssl::context& sslContext,
+		const asio::ip::tcp::endpoint& endpoint, const bool resume) : mWorker(worker), mRunning(running),
+		mSSLcontext(sslContext), mEndpoint(endpoint), mResume(resume), mSession(nullptr), mStartTick(0)
+	{}
+	~BenchHandshaker()
+	{
+		if (mSession != nullptr)
+			::SSL_SESSION_free(mSession);
+	}
+
+	void start()
+	{
+		mWorker.ioContext.post([this]() { mConnect(); });
+	}
+};
+
+/*******************************************************************************************
+* @brief Parse the operation mix (ex: broadcast:70,message:10,ping:20,listen:0)
+********************************************************************************************/
+static bool parseMix(const std::string& mixStr, int mix[BENCH_OP_COUNT])
+{
+	std::fill(mix, mix + BENCH_OP_COUNT, 0);
+	std::size_t start = 0;
+	while (start < mixStr.size())
+	{
+		auto end = mixStr.find(',', start);
+		if (end == std::string::npos)
+			end = mixStr.size();
+		auto item = mixStr.substr(start, end - start);
+		auto colon = item.find(':');
+		if (colon == std::string::npos)
+			return false;
+		auto op = std::find_if(BENCH_OP_NAME, BENCH_OP_NAME + BENCH_OP_COUNT,
+			[&item, colon](const char* name) { return item.compare(0, colon, name) == 0; }) - BENCH_OP_NAME;
+		if (op == BENCH_OP_COUNT)
+			return false;
+		mix[op] = std::atoi(item.c_str() + colon + 1);
+		start = end + 1;
+	}
+	return true;
+}
+
+static bool parseArgument(const std::string& arg, BenchSettings& settings)
+{
+	if (arg.size() < 3 || arg[0] != '-')
+		return false;
+	auto value = arg.substr(2);
+	auto number = std::atoi(value.c_str());
+	switch (arg[1])
+	{
+	case 'a': settings.host = value; return true;
+	case 'p': settings.port = (unsigned short)number; return number > 0 && number < 65535;
+	case 't': settings.tcpClients = number; return number >= 0;
+	case 's': settings.sslClients = number; return number >= 0;
+	case 'u': settings.udpClients = number; return number >= 0;
+	case 'n': settings.senders = number; return number >= 0;
+	case 'g': settings.groups = number; return number > 0;
+	case 'd': settings.duration = number; return number > 0;
+	case 'r': settings.rate = number; return number >= 0;
+	case 'b': settings.payload = number; return number > 0 && number <= DEF_MAX_BROADCAST_SIZE;
+	case 'T': settings.threads = number; return number > 0;
+	case 'm': return parseMix(value, settings.mix);
+	case 'h': settings.handshakes = value; return value == "full" || value == "resume";
+	case 'c': settings.concurrency = number; return number > 0;
+	default: return false;
+	}
+}
+
+int main(int argCount, const char* args[])
+{
+	BenchSettings settings;
+	for (auto i = 1; i < argCount; i++)
+	{
+		if (!parseArgument(args[i], settings))
+		{
+			std::cerr << "Invalid argument " << args[i] << "\n"
+				"Usage: rtds-bench [-a<host>] [-p<port>] [-t<TCP clients>] [-s<SSL clients>] [-u<UDP clients>]\n"
+				"       [-n<senders>] [-g<BGs>] [-d<seconds>] [-r<ops/s per sender>] [-b<payload size>]\n"
+				"       [-T<threads>] [-m<broadcast:N,message:N,ping:N,listen:N>] [-h<full|resume>] [-c<concurrent handshakes>]\n";
+			return 1;
+		}
+	}
+	if (settings.threads == 0)
+		settings.threads = std::max(1u, std::thread::hardware_concurrency());
+
+	std::atomic_bool running(true);
+	std::vector<std::unique_ptr<BenchWorker>> workers;
+	for (int thread = 0; thread < settings.threads; thread++)
+		workers.push_back(std::make_unique<BenchWorker>());
+
+	asio::ssl::context sslContext(asio::ssl::context::tls_client);
+	sslContext.set_verify_mode(asio::ssl::verify_none);
+	std::vector<std::unique_ptr<BenchClient>> clients;
+	std::vector<std::unique_ptr<BenchHandshaker>> handshakers;
+	try
+	{
+		auto address = asio::ip::make_address(settings.host);
+		asio::ip::tcp::endpoint tcpEndpoint(address, settings.port);
+		asio::ip::tcp::endpoint sslEndpoint(address, settings.port + 1);
+		asio::ip::udp::endpoint udpEndpoint(address, settings.port);
+
+		for (int handshaker = 0; handshaker < settings.concurrency && !settings.handshakes.empty(); handshaker++)
+			handshakers.push_back(std::make_unique<BenchHandshaker>(*workers[handshaker % settings.threads], running,
+				sslContext, sslEndpoint, settings.handshakes == "resume"));
+
+		int index = 0;
+		for (int client = 0; client < settings.tcpClients && handshakers.empty(); client++, index++)
+		{
+			auto tcpClient = std::make_unique<BenchStreamClient<asio::ip::tcp::socket>>(*workers[index % settings.threads],
+				settings, running, index, index < settings.senders);
+			tcpClient->connect(tcpEndpoint);
+			clients.push_back(std::move(tcpClient));
+		}
+		for (int client = 0; client < settings.sslClients && handshakers.empty(); client++, index++)
+		{
+			auto sslClient = std::make_unique<BenchStreamClient<asio::ssl::stream<asio::ip::tcp::socket>>>(
+				*workers[index % settings.threads], settings, running, index, index < settings.senders, sslContext);
+			sslClient->connect(sslEndpoint);
+			clients.push_back(std::move(sslClient));
+		}
+		for (int client = 0; client < settings.udpClients && handshakers.empty(); client++, index++)
+			clients.push_back(std::make_unique<BenchUDPclient>(*workers[index % settings.threads], settings, running, index, udpEndpoint));
+	}
+	catch (const std::exception& ec)
+	{
+		std::cerr << "Cannot connect client " << clients.size() << " - " << ec.what() << "\n";
+		return 1;
+	}
+
+	for (auto& client : clients)
+		client->start();
+	for (auto& handshaker : handshakers)
+		handshaker->start();
+	auto startTick = benchNow();
+	for (auto& worker : workers)
+		worker->thread = std::thread([&worker]() { worker->ioContext.run(); });
+
+	std::this_thread::sleep_for(std::chrono::seconds(settings.duration));
+	running = false;
+	auto loadTime = (benchNow() - startTick) / 1e9;
+	std::this_thread::sleep_for(std::chrono::seconds(BENCH_DRAIN_TIME));
+	for (auto& worker : workers)
+		worker->ioContext.stop();
+	for (auto& worker : workers)
+		worker->thread.join();
+
+	BenchWorker total;
+	for (auto& worker : workers)
+	{
+		total.commandLatency.merge(worker->commandLatency);
+		total.fanoutLatency.merge(worker->fanoutLatency);
+		for (int op = 0; op < BENCH_OP_COUNT; op++)
+			total.ops[op] += worker->ops[op];
+		total.failures += worker->failures;
+		total.deliveries += worker->deliveries;
+		total.bytesOut += worker->bytesOut;
+		total.bytesIn += worker->bytesIn;
+		total.handshakeLatency.merge(worker->handshakeLatency);
+		total.handshakes += worker->handshakes;
+		total.resumed += worker->resumed;
+	}
+
+	if (!handshakers.empty())
+	{
+		std::printf("{\n"
+			"  \"config\": {\"host\": \"%s\", \"port\": %u, \"handshakes\": \"%s\", \"concurrency\": %d, \"duration_s\": %d},\n"
+			"  \"load_time_s\": %.3f,\n"
+			"  \"handshakes\": %llu,\n"
+			"  \"resumed\": %llu,\n"
+			"  \"handshakes_per_s\": %.1f,\n"
+			"  \"failures\": %llu,\n"
+			"  \"handshake_latency\": %s\n"
+			"}\n",
+			settings.host.c_str(), settings.port, settings.handshakes.c_str(), settings.concurrency, settings.duration, loadTime,
+			(unsigned long long)total.handshakes, (unsigned long long)total.resumed, total.handshakes / loadTime,
+			(unsigned long long)total.failures, total.handshakeLatency.json().c_str());
+		return 0;
+	}
+
+	std::uint64_t opCount = 0;
+	std::string opsJson;
+	for (int op = 0; op < BENCH_OP_COUNT; op++)
+	{
+		opCount += total.ops[op];
+		opsJson += std::string(op == 0 ? "" : ", ") + "\"" + BENCH_OP_NAME[op] + "\": " + std::to_string(total.ops[op]);
+	}
+	std::printf("{\n"
+		"  \"config\": {\"host\": \"%s\", \"port\": %u, \"tcp_clients\": %d, \"ssl_clients\": %d, \"udp_clients\": %d,"
+		" \"senders\": %d, \"groups\": %d, \"duration_s\": %d, \"rate\": %d, \"payload\": %d, \"threads\": %d},\n"
+		"  \"load_time_s\": %.3f,\n"
+		"  \"ops\": {%s},\n"
+		"  \"ops_per_s\": %.1f,\n"
+		"  \"failures\": %llu,\n"
+		"  \"deliveries\": %llu,\n"
+		"  \"deliveries_per_s\": %.1f,\n"
+		"  \"bytes_out\": %llu,\n"
+		"  \"bytes_in\": %llu,\n"
+		"  \"command_latency\": %s,\n"
+		"  \"fanout_latency\": %s\n"
+		"}\n",
+		settings.host.c_str(), settings.port, settings.tcpClients, settings.sslClients, settings.udpClients,
+		settings.senders, settings.groups, settings.duration, settings.rate, settings.payload, settings.threads,
+		loadTime, opsJson.c_str(), opCount / loadTime, (unsigned long long)total.failures,
+		(unsigned long long)total.deliveries, total.deliveries / loadTime, (unsigned long long)total.bytesOut,
+		(unsigned long long)total.bytesIn, total.commandLatency.json().c_str(), total.fanoutLatency.json().c_str());
+	return 0;
+}
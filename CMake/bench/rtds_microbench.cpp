@@ -0,0 +1,181 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+#include <asio/ip/tcp.hpp>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#include "cmd_processor.h"
+#include "message.h"
+#include "bg_controller.h"
+
+#define MICROBENCH_MIN_TIME 100000000		// Nanoseconds each benchmark runs at least (100 ms)
+#define MICROBENCH_MAX_ITERATIONS 1000000	// Iterations per run at most (messages are kept DEF_MSG_KEEP_TIME)
+
+static std::atomic<std::uint64_t> allocationCount;	// Number of operator new calls
+
+void* operator new(std::size_t size)
+{
+	allocationCount.fetch_add(1, std::memory_order_relaxed);
+	if (auto memory = std::malloc(size != 0 ? size : 1))
+		return memory;
+	throw std::bad_alloc();
+}
+void* operator new[](std::size_t size)
+{
+	return operator new(size);
+}
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+	allocationCount.fetch_add(1, std::memory_order_relaxed);
+	return std::malloc(size != 0 ? size : 1);
+}
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept
+{
+	return operator new(size, tag);
+}
+void operator delete(void* memory) noexcept
+{
+	std::free(memory);
+}
+void operator delete[](void* memory) noexcept
+{
+	std::free(memory);
+}
+void operator delete(void* memory, std::size_t) noexcept
+{
+	std::free(memory);
+}
+void operator delete[](void* memory, std::size_t) noexcept
+{
+	std::free(memory);
+}
+void operator delete(void* memory, const std::nothrow_t&) noexcept
+{
+	std::free(memory);
+}
+void operator delete[](void* memory, const std::nothrow_t&) noexcept
+{
+	std::free(memory);
+}
+
+/*******************************************************************************************
+* @brief Keep a value alive so the compiler can not remove the benchmarked code
+********************************************************************************************/
+template<typename T>
+static void keep(const T& value)
+{
+#ifdef _MSC_VER
+	static const volatile void* sink;
+	sink = &value;
+	_ReadWriteBarrier();
+#else
+	asm volatile("" : : "r,m"(value) : "memory");
+#endif
+}
+
+/*******************************************************************************************
+* @brief Stream peer without a socket, counts the messages it is sent
+********************************************************************************************/
+class MockPeer : public StreamPeer
+{
+public:
+	std::uint64_t received = 0;				// Number of messages sent to this peer
+
+	MockPeer()
+	{
+		mPeerType = PeerType::TCP;
+		mSApair = "v4\t127.0.0.1\t40000";
+	}
+	void sendMessage(const Message* message) override
+	{
+		keep(message);
+		received++;
+	}
+};
+
+/*******************************************************************************************
+* @brief Run an operation until MICROBENCH_MIN_TIME and print ns/op and allocations/op
+*
+* @param[in]			Benchmark name
+* @param[in]			Operation (called with the iteration number)
+********************************************************************************************/
+static void run(const char* name, const std::function<void(std::uint64_t)>& operation)
+{
+	for (std::uint64_t warmup = 0; warmup < 1000; warmup++)
+		operation(warmup);
+
+	std::uint64_t iterations = 1000;
+	while (true)
+	{
+		auto allocations = allocationCount.load(std::memory_order_relaxed);
+		auto start = std::chrono::steady_clock::now();
+		for (std::uint64_t iteration = 0; iteration < iterations; iteration++)
+			operation(iteration);
+		auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+		allocations = allocationCount.load(std::memory_order_relaxed) - allocations;
+
+		if (elapsed >= MICROBENCH_MIN_TIME || iterations >= MICROBENCH_MAX_ITERATIONS)
+		{
+			std::printf("%-36s %10llu %12.1f %12.2f\n", name, (unsigned long long)iterations,
+				(double)elapsed / iterations, (double)allocations / iterations);
+			return;
+		}
+		iterations = std::min<std::uint64_t>(iterations * 4, MICROBENCH_MAX_ITERATIONS);
+	}
+}
+
+static void fanout(const std::size_t peerCount)
+{
+	std::vector<std::unique_ptr<MockPeer>> peers;
+	BGroup* group = nullptr;
+	auto bgID = "fanout" + std::to_string(peerCount);
+	for (std::size_t peer = 0; peer < peerCount; peer++)
+	{
+		peers.push_back(std::make_unique<MockPeer>());
+		group = BGcontroller::addToBG(peers.back().get(), bgID);
+	}
+	auto message = Message::makeBrdMsg(std::string_view("payload"), std::string_view("tag1"), PeerType::TCP);
+
+	auto name = "BGroup::broadcast (" + std::to_string(peerCount) + " peers)";
+	run(name.c_str(), [&](std::uint64_t) { group->broadcast(peers.front().get(), message); });
+
+	for (auto& peer : peers)
+		BGcontroller::removeFromBG(peer.get(), bgID);
+}
+
+int main()
+{
+	std::printf("%-36s %10s %12s %12s\n", "benchmark", "iterations", "ns/op", "allocs/op");
+
+	const std::string command = "broadcast\tpayload of a typical size 0123456789\tgroup1\ttag1";
+	run("CmdProcessor::extractElement (x4)", [&](std::uint64_t)
+	{
+		std::string_view commandStr(command);
+		for (int element = 0; element < 4; element++)
+			keep(CmdProcessor::extractElement(commandStr));
+	});
+
+	const std::string_view payload("payload of a typical size 0123456789");
+	run("CmdProcessor::isBmessage", [&](std::uint64_t) { keep(CmdProcessor::isBmessage(payload)); });
+
+	asio::ip::tcp::endpoint endpoint4(asio::ip::make_address("::ffff:127.0.0.1"), 54321);	// Dual stack acceptor
+	asio::ip::tcp::endpoint endpoint6(asio::ip::make_address("2001:db8::1"), 54321);
+	run("CmdProcessor::getSAPstring (v4)", [&](std::uint64_t) { keep(CmdProcessor::getSAPstring(endpoint4)); });
+	run("CmdProcessor::getSAPstring (v6)", [&](std::uint64_t) { keep(CmdProcessor::getSAPstring(endpoint6)); });
+
+	const SAP sap = "v4\t127.0.0.1\t54321";
+	const std::string_view tag("tag1");
+	run("Message::makeMsg", [&](std::uint64_t) { keep(Message::makeMsg(sap, payload, tag, PeerType::TCP)); });
+	run("Message::makeBrdMsg", [&](std::uint64_t) { keep(Message::makeBrdMsg(payload, tag, PeerType::TCP)); });
+
+	for (auto peerCount : { 10, 100, 1000, 10000 })
+		fanout(peerCount);
+	return 0;
+}
@@ -0,0 +1,433 @@
+#include <asio/connect.hpp>
+#include <asio/io_context.hpp>
+#include <asio/ip/tcp.hpp>
+#include <asio/ip/udp.hpp>
+#include <asio/post.hpp>
+#include <asio/read_until.hpp>
+#include <asio/ssl.hpp>
+#include <asio/steady_timer.hpp>
+#include <asio/write.hpp>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "common.h"
+
+#define REPLAY_MAGIC "RTDSCAP1"				// First bytes of a capture file (CAPTURE_MAGIC)
+#define REPLAY_HEADER_SIZE 15				// Size of a record header (CAPTURE_HEADER_SIZE)
+#define REPLAY_DRAIN_TIME 1					// Seconds to wait for the last responses
+#define REPLAY_UDP_TIMEOUT 1000				// Milliseconds a UDP peer waits for a response at maximum speed
+
+typedef std::int64_t ReplayTick;			// Steady clock time in nanoseconds
+
+static ReplayTick replayNow()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/*******************************************************************************************
+* @brief Settings of a replay, given as -x<value> arguments
+********************************************************************************************/
+struct ReplaySettings
+{
+	std::string capturePath;				// -f Capture file (written by rtds -x)
+	std::string host = "127.0.0.1";			// -a Server address
+	unsigned short port = RDTS_DEF_PORT;	// -p RTDS port (SSL on port + 1)
+	double speed = 1;						// -s Replay speed (1 = as captured, 0 = as fast as possible)
+};
+
+/*******************************************************************************************
+* @brief A captured command
+********************************************************************************************/
+struct ReplayCommand
+{
+	ReplayTick time;						// Nanoseconds since the capture started
+	std::string command;					// Command without the newline
+};
+
+/*******************************************************************************************
+* @brief Counters of the replay (all peers run on one thread)
+********************************************************************************************/
+struct ReplayStats
+{
+	std::uint64_t sent = 0;					// Commands sent
+	std::uint64_t responses = 0;			// Responses received
+	std::uint64_t skipped = 0;				// Commands not sent because the peer lost its connection
+	std::uint64_t failures = 0;				// Peers that lost their connection before the last response
+	std::uint64_t timeouts = 0;				// UDP commands not answered within REPLAY_UDP_TIMEOUT
+	ReplayTick lagSum = 0;					// Sum of the send delays behind the captured time
+	ReplayTick lagMax = 0;					// Largest send delay behind the captured time
+};
+
+class ReplayPeer
+{
+protected:
+	asio::io_context& mIOcontext;			// ioContext of the replay
+	const ReplaySettings& mSettings;		// Replay settings
+	ReplayStats& mStats;					// Replay counters
+	std::vector<ReplayCommand> mCommands;	// Commands of this peer in capture order
+	std::size_t mNext;						// Next command to send
+	ReplayTick mStartTick;					// Time the replay started
+	asio::steady_timer mTimer;				// Timer of the next command
+
+	ReplayPeer(asio::io_context& ioContext, const ReplaySettings& settings, ReplayStats& stats) :
+		mIOcontext(ioContext), mSettings(settings), mStats(stats), mNext(0), mStartTick(0), mTimer(ioContext)
+	{}
+
+/*******************************************************************************************
+* @brief Wait until the next command is due, then send it
+*
+* @details
+* At maximum speed the command is sent at once. A command sent after its captured time
+* (waiting for the response to the previous one) is counted as lag.
+********************************************************************************************/
+	void mScheduleNext()
+	{
+		if (mNext == mCommands.size())
+			return;
+		if (mSettings.speed <= 0)
+		{
+			mSend();
+			return;
+		}
+		auto dueTick = mStartTick + (ReplayTick)(mCommands[mNext].time / mSettings.speed);
+		auto now = replayNow();
+		if (dueTick <= now)
+		{
+			mStats.lagSum += now - dueTick;
+			mStats.lagMax = std::max(mStats.lagMax, now - dueTick);
+			mSend();
+		}
+		else
+		{
+			mTimer.expires_after(std::chrono::nanoseconds(dueTick - now));
+			mTimer.async_wait([this](const asio::error_code& ec) { if (!ec) mSend(); });
+		}
+	}
+	virtual void mSend() = 0;
+
+public:
+	virtual ~ReplayPeer() = default;
+	void addCommand(ReplayCommand&& command)
+	{
+		mCommands.push_back(std::move(command));
+	}
+/*******************************************************************************************
+* @brief Connect to RTDS (blocking, throws asio::system_error on failure)
+********************************************************************************************/
+	virtual void connect(const asio::ip::address&) = 0;
+/*******************************************************************************************
+* @brief Start sending the commands relative to the replay start time
+********************************************************************************************/
+	virtual void start(const ReplayTick startTick) = 0;
+};
+
+/*******************************************************************************************
+* @brief TCP or SSL peer, sends a command once the previous one was answered
+*
+* @details
+* RTDS reads one command per receive, so the commands of a stream peer are never pipelined.
+********************************************************************************************/
+template<typename Socket>
+class ReplayStreamPeer : public ReplayPeer
+{
+	Socket mSocket;							// Connection to RTDS
+	std::string mReadBuffer;				// Received data not processed yet
+	std::string mCommand;					// Command being written
+	bool mAwaitingResponse;					// True while the last command is not answered
+
+	asio::ip::tcp::socket& mLowest()
+	{
+		if constexpr (std::is_same_v<Socket, asio::ip::tcp::socket>)
+			return mSocket;
+		else
+			return mSocket.next_layer();
+	}
+
+	void mRead()
+	{
+		asio::async_read_until(mSocket, asio::dynamic_buffer(mReadBuffer), '\n',
+			[this](const asio::error_code& ec, std::size_t lineSize)
+		{
+			if (ec)
+			{
+				if (mNext < mCommands.size() || mAwaitingResponse)
+					mStats.failures++;
+				mStats.skipped += mCommands.size() - mNext;
+				mNext = mCommands.size();
+				mTimer.cancel();
+				return;
+			}
+			auto isResponse = mReadBuffer.rfind("[R]", 0) == 0;
+			mReadBuffer.erase(0, lineSize);
+			if (isResponse && mAwaitingResponse)
+			{
+				mStats.responses++;
+				mAwaitingResponse = false;
+				mScheduleNext();
+			}
+			mRead();
+		});
+	}
+
+	void mSend() override
+	{
+		mCommand = mCommands[mNext++].command + "\n";
+		mAwaitingResponse = mCommand != "exit\n";
+		mStats.sent++;
+		asio::async_write(mSocket, asio::buffer(mCommand), [](const asio::error_code&, std::size_t) {});
+	}
+
+public:
+	template<typename... SocketArgs>
+	ReplayStreamPeer(asio::io_context& ioContext, const ReplaySettings& settings, ReplayStats& stats, SocketArgs&&... socketArgs) :
+		ReplayPeer(ioContext, settings, stats), mSocket(ioContext, std::forward<SocketArgs>(socketArgs)...), mAwaitingResponse(false)
+	{}
+
+	void connect(const asio::ip::address& address) override
+	{
+		auto isSSL = !std::is_same_v<Socket, asio::ip::tcp::socket>;
+		mLowest().connect(asio::ip::tcp::endpoint(address, mSettings.port + (isSSL ? 1 : 0)));
+		mLowest().set_option(asio::ip::tcp::no_delay(true));
+		if constexpr (!std::is_same_v<Socket, asio::ip::tcp::socket>)
+			mSocket.handshake(asio::ssl::stream_base::client);
+	}
+
+	void start(const ReplayTick startTick) override
+	{
+		mStartTick = startTick;
+		mRead();
+		mScheduleNext();
+	}
+};
+
+/*******************************************************************************************
+* @brief UDP peer, sends every command at its time
+*
+* @details
+* At maximum speed the next command waits for the response (or REPLAY_UDP_TIMEOUT), so the
+* datagrams are not dropped by an overrun socket buffer.
+********************************************************************************************/
+class ReplayUDPpeer : public ReplayPeer
+{
+	asio::ip::udp::socket mSocket;			// Connected UDP socket
+	std::array<char, DEF_BUFF_SIZE> mReadBuffer;	// Received datagram
+	bool mAwaitingResponse;					// True while the last command is not answered (maximum speed)
+
+	void mRead()
+	{
+		mSocket.async_receive(asio::buffer(mReadBuffer), [this](const asio::error_code& ec, std::size_t)
+		{
+			if (ec)
+				return;
+			mStats.responses++;
+			if (mAwaitingResponse)
+			{
+				mAwaitingResponse = false;
+				mTimer.cancel();
+				mScheduleNext();
+			}
+			mRead();
+		});
+	}
+
+	void mSend() override
+	{
+		auto command = mCommands[mNext++].command + "\n";
+		asio::error_code ec;
+		mSocket.send(asio::buffer(command), 0, ec);
+		mStats.sent++;
+		if (mSettings.speed > 0)
+		{
+			asio::post(mIOcontext, [this]() { mScheduleNext(); });
+			return;
+		}
+		mAwaitingResponse = true;
+		mTimer.expires_after(std::chrono::milliseconds(REPLAY_UDP_TIMEOUT));
+		mTimer.async_wait([this](const asio::error_code& ec)
+		{
+			if (ec || !mAwaitingResponse)
+				return;
+			mStats.timeouts++;
+			mAwaitingResponse = false;
+			mScheduleNext();
+		});
+	}
+
+public:
+	ReplayUDPpeer(asio::io_context& ioContext, const ReplaySettings& settings, ReplayStats& stats) :
+		ReplayPeer(ioContext, settings, stats), mSocket(ioContext), mAwaitingResponse(false)
+	{}
+
+	void connect(const asio::ip::address& address) override
+	{
+		mSocket.connect(asio::ip::udp::endpoint(address, mSettings.port));
+	}
+
+	void start(const ReplayTick startTick) override
+	{
+		mStartTick = startTick;
+		mRead();
+		mScheduleNext();
+	}
+};
+
+/*******************************************************************************************
+* @brief Read a little endian integer from the capture
+********************************************************************************************/
+template<typename T>
+static T readLittleEndian(const unsigned char* bytes)
+{
+	std::uint64_t value = 0;
+	for (std::size_t byte = 0; byte < sizeof(T); byte++)
+		value |= (std::uint64_t)bytes[byte] << (8 * byte);
+	return (T)value;
+}
+
+/*******************************************************************************************
+* @brief Load a capture file, grouping the commands by peer
+*
+* @return				False if the file can not be read or is not a capture
+*
+* @details
+* Peers are keyed by (UDP, peer ID): stream and UDP peer IDs are separate ID spaces.
+********************************************************************************************/
+static bool loadCapture(const std::string& path, std::map<std::pair<bool, std::uint32_t>, std::pair<PeerType, std::vector<ReplayCommand>>>& peers,
+	std::uint64_t& commandCount, ReplayTick& duration)
+{
+	std::ifstream captureFile(path, std::ios::binary);
+	char magic[sizeof(REPLAY_MAGIC) - 1];
+	if (!captureFile.read(magic, sizeof(magic)) || std::memcmp(magic, REPLAY_MAGIC, sizeof(magic)) != 0)
+		return false;
+
+	unsigned char header[REPLAY_HEADER_SIZE];
+	while (captureFile.read((char*)header, sizeof(header)))
+	{
+		ReplayCommand command;
+		command.time = readLittleEndian<ReplayTick>(header);
+		auto peerID = readLittleEndian<std::uint32_t>(header + 8);
+		auto peerType = (PeerType)header[12];
+		auto size = readLittleEndian<std::uint16_t>(header + 13);
+		command.command.resize(size);
+		if (!captureFile.read(&command.command[0], size) || peerType >= PeerType::ERR)
+			return false;
+
+		duration = std::max(duration, command.time);
+		auto& peer = peers[{ peerType == PeerType::UDP, peerID }];
+		peer.first = peerType;
+		peer.second.push_back(std::move(command));
+		commandCount++;
+	}
+	return true;
+}
+
+static bool parseArgument(const std::string& arg, ReplaySettings& settings)
+{
+	if (arg.size() < 3 || arg[0] != '-')
+		return false;
+	auto value = arg.substr(2);
+	auto number = std::atoi(value.c_str());
+	switch (arg[1])
+	{
+	case 'f': settings.capturePath = value; return true;
+	case 'a': settings.host = value; return true;
+	case 'p': settings.port = (unsigned short)number; return number > 0 && number < 65535;
+	case 's': settings.speed = std::atof(value.c_str()); return settings.speed >= 0;
+	default: return false;
+	}
+}
+
+int main(int argCount, const char* args[])
+{
+	ReplaySettings settings;
+	for (auto i = 1; i < argCount; i++)
+	{
+		if (!parseArgument(args[i], settings))
+		{
+			std::cerr << "Invalid argument " << args[i] << "\n"
+				"Usage: rtds-replay -f<capture file> [-a<host>] [-p<port>] [-s<speed, 1 = as captured, 0 = maximum>]\n";
+			return 1;
+		}
+	}
+
+	std::map<std::pair<bool, std::uint32_t>, std::pair<PeerType, std::vector<ReplayCommand>>> capturedPeers;
+	std::uint64_t commandCount = 0;
+	ReplayTick captureDuration = 0;
+	if (settings.capturePath.empty() || !loadCapture(settings.capturePath, capturedPeers, commandCount, captureDuration))
+	{
+		std::cerr << "Cannot read the capture file " << settings.capturePath << "\n";
+		return 1;
+	}
+
+	asio::io_context ioContext;
+	asio::ssl::context sslContext(asio::ssl::context::tls_client);
+	sslContext.set_verify_mode(asio::ssl::verify_none);
+	ReplayStats stats;
+	std::vector<std::unique_ptr<ReplayPeer>> peers;
+	std::uint64_t streamPeers = 0, udpPeers = 0;
+	try
+	{
+		auto address = asio::ip::make_address(settings.host);
+		for (auto& capturedPeer : capturedPeers)
+		{
+			std::unique_ptr<ReplayPeer> peer;
+			if (capturedPeer.second.first == PeerType::TCP)
+				peer = std::make_unique<ReplayStreamPeer<asio::ip::tcp::socket>>(ioContext, settings, stats);
+			else if (capturedPeer.second.first == PeerType::SSL)
+				peer = std::make_unique<ReplayStreamPeer<asio::ssl::stream<asio::ip::tcp::socket>>>(ioContext, settings, stats, sslContext);
+			else
+				peer = std::make_unique<ReplayUDPpeer>(ioContext, settings, stats);
+			(capturedPeer.second.first == PeerType::UDP ? udpPeers : streamPeers)++;
+
+			for (auto& command : capturedPeer.second.second)
+				peer->addCommand(std::move(command));
+			peer->connect(address);
+			peers.push_back(std::move(peer));
+		}
+	}
+	catch (const std::exception& ec)
+	{
+		std::cerr << "Cannot connect peer " << peers.size() << " - " << ec.what() << "\n";
+		return 1;
+	}
+	capturedPeers.clear();
+
+	auto startTick = replayNow();
+	for (auto& peer : peers)
+		peer->start(startTick);
+	while (stats.sent + stats.skipped < commandCount && ioContext.run_one() > 0);
+	auto replayTime = (replayNow() - startTick) / 1e9;
+	ioContext.run_for(std::chrono::seconds(REPLAY_DRAIN_TIME));
+
+	std::printf("{\n"
+		"  \"config\": {\"capture\": \"%s\", \"host\": \"%s\", \"port\": %u, \"speed\": %g},\n"
+		"  \"stream_peers\": %llu,\n"
+		"  \"udp_peers\": %llu,\n"
+		"  \"commands\": %llu,\n"
+		"  \"capture_time_s\": %.3f,\n"
+		"  \"replay_time_s\": %.3f,\n"
+		"  \"commands_per_s\": %.1f,\n"
+		"  \"sent\": %llu,\n"
+		"  \"responses\": %llu,\n"
+		"  \"skipped\": %llu,\n"
+		"  \"failures\": %llu,\n"
+		"  \"udp_timeouts\": %llu,\n"
+		"  \"lag_avg_us\": %.1f,\n"
+		"  \"lag_max_us\": %.1f\n"
+		"}\n",
+		settings.capturePath.c_str(), settings.host.c_str(), settings.port, settings.speed,
+		(unsigned long long)streamPeers, (unsigned long long)udpPeers, (unsigned long long)commandCount,
+		captureDuration / 1e9, replayTime, stats.sent / replayTime, (unsigned long long)stats.sent,
+		(unsigned long long)stats.responses, (unsigned long long)stats.skipped, (unsigned long long)stats.failures, (unsigned long long)stats.timeouts,
+		stats.sent > 0 ? stats.lagSum / 1e3 / stats.sent : 0.0, stats.lagMax / 1e3);
+	return stats.failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,353 @@
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <asio/detail/epoll_reactor.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "tcp_peer.h"
+
+#define SCALE_DEF_STEPS "10000,100000,500000"	// Default connection counts at which the RSS is sampled
+#define SCALE_DEF_GROUPS 1000				// Default number of BGs (join notices grow with the square of the BG size)
+#define SCALE_SETTLE_TIME 1000				// Milliseconds without received data before the RSS is sampled
+#define SCALE_ADDRESS_USE 0.9				// Fraction of the ephemeral ports used per source address
+#define SCALE_DRAIN_EVENTS 256				// Sockets drained per epoll_wait
+
+typedef std::int64_t ScaleTick;				// Steady clock time in nanoseconds
+
+static ScaleTick scaleNow()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/*******************************************************************************************
+* @brief Settings of a scale run, given as -x<value> arguments
+********************************************************************************************/
+struct ScaleSettings
+{
+	std::string host = "127.0.0.1";			// -a Server address (IPv4 loopback)
+	unsigned short port = RDTS_DEF_PORT;	// -p RTDS port
+	int pid = 0;							// -P Process ID of RTDS (for its RSS)
+	int groups = SCALE_DEF_GROUPS;			// -g Number of BGs
+	int addresses = 0;						// -A Source addresses (0 = enough for the ephemeral port range)
+	std::vector<int> steps;					// -c Connection counts at which the RSS is sampled
+};
+
+/*******************************************************************************************
+* @brief Estimated bytes per idle listening connection, by component
+*
+* @details
+* Estimated from the type sizes of this build; heap blocks are rounded the way glibc does.
+* Kernel socket memory is not part of the RSS and not counted.
+********************************************************************************************/
+struct ScaleBreakdown
+{
+	double tcpPeer = 0;						// TCPpeer slot (without the AdancedBuffer and SAP string)
+	double socket = 0;						// asio socket slot and its epoll descriptor state
+	double advancedBuffer = 0;				// AdancedBuffer (idle peers hold no data buffer)
+	double sapString = 0;					// SAP string and its heap block (longer than the SSO)
+	double bgListEntry = 0;					// Share of the BG peer list capacity
+};
+
+/*******************************************************************************************
+* @brief Size of the heap block malloc uses for an allocation
+********************************************************************************************/
+static std::size_t heapSize(const std::size_t size)
+{
+#ifdef __GLIBC__
+	return std::max<std::size_t>(32, (size + sizeof(std::size_t) + 15) & ~std::size_t(15));
+#else
+	return size;
+#endif
+}
+
+/*******************************************************************************************
+* @brief Read the resident set size of a process (kB), 0 on failure
+********************************************************************************************/
+static long readRSS(const int pid)
+{
+	std::ifstream status("/proc/" + std::to_string(pid) + "/status");
+	std::string line;
+	while (std::getline(status, line))
+	{
+		if (line.rfind("VmRSS:", 0) == 0)
+			return std::atol(line.c_str() + 6);
+	}
+	return 0;
+}
+
+/*******************************************************************************************
+* @brief Number of ephemeral ports the kernel uses for outgoing connections
+********************************************************************************************/
+static int ephemeralPorts()
+{
+	std::ifstream range("/proc/sys/net/ipv4/ip_local_port_range");
+	int low = 32768, high = 60999;
+	range >> low >> high;
+	return std::max(1, high - low + 1);
+}
+
+static ScaleBreakdown estimate(const int connections, const int groups, const std::size_t sapSize)
+{
+	ScaleBreakdown breakdown;
+	breakdown.advancedBuffer = sizeof(AdancedBuffer);
+	breakdown.sapString = sizeof(SAP) + (sapSize > SAP().capacity() ? heapSize(sapSize + 1) : 0);
+	breakdown.tcpPeer = (double)heapSize(sizeof(TCPpeer)) - sizeof(AdancedBuffer) - sizeof(SAP);
+	breakdown.socket = (double)heapSize(sizeof(asio::ip::tcp::socket)) +
+		heapSize(sizeof(asio::detail::epoll_reactor::descriptor_state));
+
+	// Clients are spread round robin, so the BGs differ by one peer at most
+	double listBytes = 0;
+	for (int group = 0; group < std::min(groups, connections); group++)
+	{
+		std::vector<StreamPeer*> peerList;
+		auto members = connections / groups + (group < connections % groups ? 1 : 0);
+		for (int member = 0; member < members; member++)
+			peerList.push_back(nullptr);
+		listBytes += heapSize(peerList.capacity() * sizeof(StreamPeer*));
+	}
+	breakdown.bgListEntry = listBytes / connections;
+	return breakdown;
+}
+
+/*******************************************************************************************
+* @brief Connect a client from a source address and listen to a BG (blocking)
+*
+* @return				Socket, or -1 on failure (errno is set)
+*
+* @details
+* IP_BIND_ADDRESS_NO_PORT lets the kernel pick the port at connect, so every source address
+* gets the whole ephemeral port range.
+********************************************************************************************/
+static int connectClient(const sockaddr_in& server, const std::uint32_t sourceAddress, const std::string& listen)
+{
+	auto fd = ::socket(AF_INET, SOCK_STREAM, 0);
+	if (fd < 0)
+		return -1;
+	sockaddr_in source = {};
+	source.sin_family = AF_INET;
+	source.sin_addr.s_addr = htonl(sourceAddress);
+	int enable = 1;
+	::setsockopt(fd, IPPROTO_IP, IP_BIND_ADDRESS_NO_PORT, &enable, sizeof(enable));
+	if (::bind(fd, (const sockaddr*)&source, sizeof(source)) != 0 ||
+		::connect(fd, (const sockaddr*)&server, sizeof(server)) != 0 ||
+		::write(fd, listen.data(), listen.size()) != (ssize_t)listen.size())
+	{
+		auto error = errno;
+		::close(fd);
+		errno = error;
+		return -1;
+	}
+
+	char response[DEF_BUFF_SIZE];
+	std::size_t received = 0;
+	while (received == 0 || response[received - 1] != '\n')
+	{
+		auto readSize = ::read(fd, response + received, sizeof(response) - received);
+		if (readSize <= 0 || (received += readSize) == sizeof(response))
+		{
+			::close(fd);
+			errno = readSize == 0 ? ECONNRESET : errno;
+			return -1;
+		}
+	}
+	if (std::strncmp(response, "[R]\tsuccess", 11) != 0)
+	{
+		::close(fd);
+		errno = EAGAIN;
+		return -1;
+	}
+	::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+	return fd;
+}
+
+static bool parseSteps(const std::string& stepsStr, std::vector<int>& steps)
+{
+	steps.clear();
+	std::size_t start = 0;
+	while (start < stepsStr.size())
+	{
+		auto end = stepsStr.find(',', start);
+		if (end == std::string::npos)
+			end = stepsStr.size();
+		auto step = std::atoi(stepsStr.substr(start, end - start).c_str());
+		if (step <= 0 || (!steps.empty() && step <= steps.back()))
+			return false;
+		steps.push_back(step);
+		start = end + 1;
+	}
+	return !steps.empty();
+}
+
+static bool parseArgument(const std::string& arg, ScaleSettings& settings)
+{
+	if (arg.size() < 3 || arg[0] != '-')
+		return false;
+	auto value = arg.substr(2);
+	auto number = std::atoi(value.c_str());
+	switch (arg[1])
+	{
+	case 'a': settings.host = value; return true;
+	case 'p': settings.port = (unsigned short)number; return number > 0 && number < 65535;
+	case 'P': settings.pid = number; return number > 0;
+	case 'g': settings.groups = number; return number > 0;
+	case 'A': settings.addresses = number; return number > 0 && number < 65535;
+	case 'c': return parseSteps(value, settings.steps);
+	default: return false;
+	}
+}
+
+int main(int argCount, const char* args[])
+{
+	ScaleSettings settings;
+	parseSteps(SCALE_DEF_STEPS, settings.steps);
+	for (auto i = 1; i < argCount; i++)
+	{
+		if (!parseArgument(args[i], settings))
+		{
+			std::cerr << "Invalid argument " << args[i] << "\n"
+				"Usage: rtds-scalebench -P<RTDS pid> [-a<IPv4 host>] [-p<port>] [-c<connections,...>] [-g<BGs>]\n"
+				"       [-A<source addresses>]\n";
+			return 1;
+		}
+	}
+	sockaddr_in server = {};
+	server.sin_family = AF_INET;
+	server.sin_port = htons(settings.port);
+	if (settings.pid == 0 || ::inet_pton(AF_INET, settings.host.c_str(), &server.sin_addr) != 1)
+	{
+		std::cerr << "RTDS pid (-P) and an IPv4 host (-a) are required\n";
+		return 1;
+	}
+	auto maxConnections = settings.steps.back();
+	if (settings.addresses == 0)
+		settings.addresses = (int)(maxConnections / (ephemeralPorts() * SCALE_ADDRESS_USE)) + 1;
+
+	rlimit fileLimit;
+	::getrlimit(RLIMIT_NOFILE, &fileLimit);
+	fileLimit.rlim_cur = fileLimit.rlim_max;
+	::setrlimit(RLIMIT_NOFILE, &fileLimit);
+	if (fileLimit.rlim_cur < (rlim_t)maxConnections + 16)
+		std::cerr << "Warning: open file limit " << fileLimit.rlim_cur << " is below " << maxConnections << " clients\n";
+
+	// Received data (join notices of the later clients) is read and dropped so the server never blocks
+	auto epollFd = ::epoll_create1(0);
+	std::atomic_bool running(true);
+	std::atomic<ScaleTick> lastReceived(scaleNow());
+	std::thread drainer([&]()
+	{
+		epoll_event events[SCALE_DRAIN_EVENTS];
+		char dropBuffer[64 * 1024];
+		while (running)
+		{
+			auto eventCount = ::epoll_wait(epollFd, events, SCALE_DRAIN_EVENTS, 100);
+			for (int event = 0; event < eventCount; event++)
+			{
+				while (::read(events[event].data.fd, dropBuffer, sizeof(dropBuffer)) > 0)
+					lastReceived = scaleNow();
+			}
+		}
+	});
+
+	auto baselineRSS = readRSS(settings.pid);
+	if (baselineRSS == 0)
+	{
+		std::cerr << "Cannot read the RSS of process " << settings.pid << "\n";
+		running = false;
+		drainer.join();
+		return 1;
+	}
+
+	std::vector<int> clients;
+	clients.reserve(maxConnections);
+	std::size_t sapSize = 0;
+	std::string stepsJson;
+	int failures = 0;
+	auto startTick = scaleNow();
+	for (auto step : settings.steps)
+	{
+		auto stepTick = scaleNow();
+		while ((int)clients.size() < step)
+		{
+			auto index = (int)clients.size();
+			auto sourceAddress = INADDR_LOOPBACK + 1 + (std::uint32_t)(index % settings.addresses);
+			auto fd = connectClient(server, sourceAddress, "listen\tbg" + std::to_string(index % settings.groups) + "\tt1\n");
+			if (fd < 0)
+			{
+				std::cerr << "Cannot connect client " << index << " - " << std::strerror(errno) << "\n";
+				if (++failures > 100)
+					break;
+				continue;
+			}
+			epoll_event event = {};
+			event.events = EPOLLIN;
+			event.data.fd = fd;
+			::epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+			clients.push_back(fd);
+
+			sockaddr_in local = {};
+			socklen_t localSize = sizeof(local);
+			::getsockname(fd, (sockaddr*)&local, &localSize);
+			char addressStr[INET_ADDRSTRLEN];
+			::inet_ntop(AF_INET, &local.sin_addr, addressStr, sizeof(addressStr));
+			sapSize = std::strlen("v4\t\t") + std::strlen(addressStr) + std::to_string(ntohs(local.sin_port)).size();
+		}
+		auto connectTime = (scaleNow() - stepTick) / 1e9;
+		if (clients.empty())
+			break;
+
+		while (scaleNow() - lastReceived < ScaleTick(SCALE_SETTLE_TIME) * 1000000)
+			std::this_thread::sleep_for(std::chrono::milliseconds(100));
+		auto rss = readRSS(settings.pid);
+		auto connections = (int)clients.size();
+		auto perConnection = (rss - baselineRSS) * 1024.0 / connections;
+		auto breakdown = estimate(connections, settings.groups, sapSize);
+		auto unattributed = perConnection - breakdown.tcpPeer - breakdown.socket - breakdown.advancedBuffer -
+			breakdown.sapString - breakdown.bgListEntry;
+
+		char stepJson[512];
+		std::snprintf(stepJson, sizeof(stepJson),
+			"    {\"connections\": %d, \"connect_s\": %.3f, \"rss_kb\": %ld, \"bytes_per_connection\": %.1f,\n"
+			"     \"breakdown\": {\"tcp_peer\": %.1f, \"socket\": %.1f, \"advanced_buffer\": %.1f, \"sap_string\": %.1f,"
+			" \"bg_list_entry\": %.1f, \"unattributed\": %.1f}}",
+			connections, connectTime, rss, perConnection, breakdown.tcpPeer, breakdown.socket,
+			breakdown.advancedBuffer, breakdown.sapString, breakdown.bgListEntry, unattributed);
+		stepsJson += std::string(stepsJson.empty() ? "" : ",\n") + stepJson;
+		if (connections < step)
+			break;
+	}
+	auto totalTime = (scaleNow() - startTick) / 1e9;
+
+	running = false;
+	drainer.join();
+	for (auto fd : clients)
+		::close(fd);
+	::close(epollFd);
+
+	std::printf("{\n"
+		"  \"config\": {\"host\": \"%s\", \"port\": %u, \"pid\": %d, \"groups\": %d, \"source_addresses\": %d},\n"
+		"  \"sizes\": {\"tcp_peer\": %zu, \"socket\": %zu, \"descriptor_state\": %zu, \"advanced_buffer\": %zu, \"sap\": %zu},\n"
+		"  \"baseline_rss_kb\": %ld,\n"
+		"  \"failures\": %d,\n"
+		"  \"time_s\": %.3f,\n"
+		"  \"steps\": [\n%s\n  ]\n"
+		"}\n",
+		settings.host.c_str(), settings.port, settings.pid, settings.groups, settings.addresses,
+		sizeof(TCPpeer), sizeof(asio::ip::tcp::socket), sizeof(asio::detail::epoll_reactor::descriptor_state),
+		sizeof(AdancedBuffer), sizeof(SAP), baselineRSS, failures, totalTime, stepsJson.c_str());
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,69 @@
+#ifndef ADMISSION_H
+#define ADMISSION_H
+
+#include <atomic>
+#include <cstdint>
+#include "common.h"
+#include "latency.h"
+#include "metrics.h"
+
+#define SHED_RESUME_PERCENT 50				// Shedding stops once the lag and queue are below this percent of the limits
+
+/*******************************************************************************************
+* @brief Admission control (load shedding) on event loop lag and queued deliveries
+*
+* @details
+* The state is updated every IO_PROBE_INTERVAL by the IO probe routine, so the command and
+* accept paths only read a flag. While shedding, new broadcast, message and listen commands
+* get WAIT_RETRY and the TCP and SSL accept routines pause. Ping, leave, change, exit and
+* CCM keep working.
+********************************************************************************************/
+class Admission
+{
+	static std::atomic_bool mShedding;			// True while shedding load
+	static std::atomic<LatencyTick> mMaxLag;	// Event loop lag limit in nanoseconds (0 if disabled)
+	static std::atomic<std::int64_t> mMaxPending;	// Queued deliveries limit (0 if disabled)
+
+public:
+/*******************************************************************************************
+* @brief Set the limits (also on a config reload)
+*
+* @param[in]			Event loop lag in milliseconds (0 to disable)
+* @param[in]			Queued deliveries (0 to disable)
+********************************************************************************************/
+	static void setLimits(const unsigned int, const unsigned int);
+/*******************************************************************************************
+* @brief Start or stop shedding
+*
+* @param[in]			Current event loop lag in nanoseconds
+* @param[in]			Current number of queued deliveries
+*
+* @details
+* Shedding starts when a limit is exceeded and stops once both are below
+* SHED_RESUME_PERCENT of the limits.
+********************************************************************************************/
+	static void update(const LatencyTick, const std::int64_t);
+/*******************************************************************************************
+* @brief Return true while shedding load
+********************************************************************************************/
+	static bool isShedding()
+	{
+		return mShedding.load(std::memory_order_relaxed);
+	}
+/*******************************************************************************************
+* @brief Return true if a command has to be answered with WAIT_RETRY (and count it)
+*
+* @param[in]			Index of the command
+********************************************************************************************/
+	static bool shedCommand(const short command)
+	{
+		if (!isShedding())
+			return false;
+		if (command != (short)Command::BROADCAST && command != (short)Command::MESSAGE && command != (short)Command::LISTEN)
+			return false;
+		Metrics::add(Metric::SHED_COMMANDS);
+		return true;
+	}
+};
+
+#endif
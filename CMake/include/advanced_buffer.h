@@ -6,13 +6,39 @@
 
 class AdancedBuffer
 {
-	std::array<char, RTDS_BUFF_SIZE> mBuffer;				// Actual data buffer
+	char* mBuffer;											// Data buffer borrowed from the BufferPool
 	std::size_t mVirtualSize;								// Virtual size of the buffer
+/*******************************************************************************************
+* @brief Borrow a data buffer from the BufferPool if not holding one
+********************************************************************************************/
+	void mAcquire();
 public:
 /*******************************************************************************************
+* @brief Constructor (no data buffer is held until it is needed)
+********************************************************************************************/
+	AdancedBuffer();
+/*******************************************************************************************
+* @brief Destructor [Return the data buffer to the BufferPool]
+********************************************************************************************/
+	~AdancedBuffer();
+	AdancedBuffer(const AdancedBuffer&) = delete;
+	AdancedBuffer& operator =(const AdancedBuffer&) = delete;
+/*******************************************************************************************
+* @brief Return the data buffer to the BufferPool
+*
+* @details
+* Idle peers hold no data buffer; the next read or response borrows one again.
+* Previously cooked data or assigned string is lost.
+********************************************************************************************/
+	void release();
+/*******************************************************************************************
 * @brief Copy a string to the buffer and set the virtual size for asio buffer
 *
 * @param[in]		Response string to the command
+*
+* @details
+* Peer responses are far shorter than MIN_BUFF_SIZE; a longer string is cut to the buffer
+* size (ending with a newline) instead of overrunning it. Long replies (CCM) use a string.
 ********************************************************************************************/
 	void operator =(const std::string&);
 /*******************************************************************************************
@@ -29,6 +55,9 @@ public:
 * @brief Get read buffer (Get the entire buffer for reading from peer)
 *
 * @return				Asio buffer of the underlying char array
+*
+* @details
+* Borrow a data buffer from the BufferPool if not holding one.
 ********************************************************************************************/
 	asio::mutable_buffer getReadBuffer();
 /*******************************************************************************************
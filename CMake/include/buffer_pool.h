@@ -0,0 +1,64 @@
+#ifndef BUFFER_POOL_H
+#define BUFFER_POOL_H
+
+#include <mutex>
+#include <vector>
+#include "common.h"
+
+#define BUFFER_CACHE_SIZE 64				// Maximum number of free buffers cached per thread
+#define BUFFER_BATCH_SIZE 32				// Buffers moved between a thread cache and the shared pool at once
+#define MAX_POOLED_BUFFERS 4096				// Maximum number of free buffers kept in the shared pool
+
+class BufferPool
+{
+	struct ThreadCache
+	{
+		std::vector<char*> freeBuffers;			// Free buffers of the thread
+		ThreadCache();
+		~ThreadCache();							// Hand the buffers to the shared pool
+	};
+
+	static thread_local ThreadCache mCache;		// Free buffers of the calling thread
+	static std::vector<char*> mFreeBuffers;		// Free buffers shared by all threads
+	static std::mutex mPoolLock;				// Mutex for the shared pool
+
+/*******************************************************************************************
+* @brief Move up to BUFFER_BATCH_SIZE buffers from the shared pool to the thread cache
+********************************************************************************************/
+	static void mRefill();
+/*******************************************************************************************
+* @brief Move buffers from the thread cache to the shared pool
+*
+* @param[in]			Number of buffers to move
+*
+* @details
+* Buffers beyond MAX_POOLED_BUFFERS are freed.
+********************************************************************************************/
+	static void mSpill(const std::size_t);
+
+public:
+/*******************************************************************************************
+* @brief Borrow a buffer of the configured buffer_size from the pool
+*
+* @return				Pointer to the buffer
+*
+* @details
+* Take the buffer from the cache of the calling thread, which is refilled in batches from
+* the shared pool (the only locked step). Allocate a new buffer if both are empty (throws
+* std::bad_alloc on failure).
+********************************************************************************************/
+	static char* acquire();
+/*******************************************************************************************
+* @brief Return a buffer to the pool
+*
+* @param[in]			Pointer to the buffer
+*
+* @details
+* The buffer is cached by the calling thread (not necessarily the borrowing thread).
+* Once the cache holds more than BUFFER_CACHE_SIZE buffers, a batch is moved to the
+* shared pool.
+********************************************************************************************/
+	static void release(char*);
+};
+
+#endif
@@ -0,0 +1,148 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "common.h"
+#include "latency.h"
+#include "runtime_limits.h"
+
+#define CAPTURE_RING_SIZE 2048				// Number of commands buffered per thread (power of two)
+#define CAPTURE_FLUSH_INTERVAL 10			// Milliseconds between the writes of the capture writer
+#define CAPTURE_MAGIC "RTDSCAP1"			// First bytes of a capture file
+#define CAPTURE_MAGIC_SIZE 8				// Size of CAPTURE_MAGIC
+#define CAPTURE_HEADER_SIZE 15				// Size of a record header in the capture file
+
+/*******************************************************************************************
+* @brief Records the commands of the TCP, SSL and UDP peers to a capture file
+*
+* @details
+* The file starts with CAPTURE_MAGIC followed by one record per command:
+* int64 time (nanoseconds since the capture started), uint32 peer ID, uint8 peer type
+* (PeerType), uint16 command size and the command without its newline.
+* Integers are little endian. CCM commands are not captured (they carry credentials).
+* Stream and UDP peer IDs are separate ID spaces, told apart by the peer type.
+* A command is kept up to the buffer_size limit (the size of the read buffers), so every
+* command read by a peer is captured whole (each capturing thread keeps CAPTURE_RING_SIZE
+* commands of buffer_size characters).
+********************************************************************************************/
+class Capture
+{
+	struct Record
+	{
+		LatencyTick time;						// Steady clock time the command was processed
+		std::uint32_t peerID;					// ID of the peer that sent the command
+		PeerType peerType;						// Type of the peer that sent the command
+		std::uint16_t size;						// Number of characters in the command
+		std::size_t offset;						// Position of the command in the batch (capture writer)
+	};
+
+	struct Ring
+	{
+		alignas(64) std::atomic<std::uint64_t> head;	// Next record written by the owning thread
+		alignas(64) std::atomic<std::uint64_t> tail;	// Next record read by the capture writer
+		alignas(64) std::atomic<std::uint64_t> dropped;	// Records dropped because the ring was full
+		Record records[CAPTURE_RING_SIZE];				// Records waiting to be written
+		std::unique_ptr<char[]> commands;				// Command of each record (mCommandSize characters each)
+	};
+
+	inline static thread_local Ring* mThreadRing = nullptr;	// Ring of the calling thread
+	static std::vector<std::unique_ptr<Ring>> mRings;	// Rings of all threads that captured
+	static std::mutex mRingLock;				// Mutex for registering a new ring
+	static std::atomic_bool mCapturing;			// True while the commands are captured
+	static std::atomic_bool mWriterRunning;		// True while the capture writer should keep running
+	static std::thread mWriter;					// Thread writing the records to the capture file
+	static std::FILE* mCaptureFile;				// Capture file
+	static LatencyTick mStartTick;				// Time the capture started
+	inline static std::size_t mCommandSize = 0;	// Characters kept per command (buffer_size at start)
+
+/*******************************************************************************************
+* @brief Create and register the ring of the calling thread
+********************************************************************************************/
+	static Ring* mRegisterRing();
+/*******************************************************************************************
+* @brief Write the buffered records of all threads to the capture file (in time order)
+*
+* @param[in,out]	Reused record batch
+* @param[in,out]	Reused buffer of the batch commands
+* @param[in,out]	Reused output buffer
+*
+* @details
+* Runs only on the capture writer thread (or after it stopped).
+********************************************************************************************/
+	static void mDrain(std::vector<Record>&, std::string&, std::string&);
+/*******************************************************************************************
+* @brief Capture writer thread, drain the rings every CAPTURE_FLUSH_INTERVAL milliseconds
+********************************************************************************************/
+	static void mWriterRoutine();
+
+public:
+/*******************************************************************************************
+* @brief Open the capture file and start the capture writer thread
+*
+* @param[in]		Path of the capture file (overwritten)
+*
+* @return			False if the file can not be opened or the writer can not be started
+********************************************************************************************/
+	static bool start(const std::string&);
+/*******************************************************************************************
+* @brief Stop the capture writer after writing the buffered records
+********************************************************************************************/
+	static void stop();
+/*******************************************************************************************
+* @brief Check if the commands are captured (one relaxed atomic load)
+********************************************************************************************/
+	static bool isCapturing()
+	{
+		return mCapturing.load(std::memory_order_relaxed);
+	}
+/*******************************************************************************************
+* @brief Get the number of commands dropped because a thread's ring was full
+********************************************************************************************/
+	static std::uint64_t droppedCount();
+/*******************************************************************************************
+* @brief Capture a command
+*
+* @param[in]		ID of the peer
+* @param[in]		Type of the peer
+* @param[in]		Command (without the newline)
+*
+* @details
+* The command is copied into the calling thread's ring (no lock, no syscall).
+* The record is dropped and counted if the ring is full.
+* A command longer than buffer_size (never read by a peer) is cut to buffer_size.
+********************************************************************************************/
+	static void record(const std::uint32_t peerID, const PeerType peerType, const std::string_view& command)
+	{
+		if (!isCapturing())
+			return;
+		if (mThreadRing == nullptr)
+			mThreadRing = mRegisterRing();
+
+		auto& ring = *mThreadRing;
+		auto head = ring.head.load(std::memory_order_relaxed);
+		if (head - ring.tail.load(std::memory_order_acquire) >= CAPTURE_RING_SIZE)
+		{
+			ring.dropped.store(ring.dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+			return;
+		}
+
+		auto& record = ring.records[head & (CAPTURE_RING_SIZE - 1)];
+		record.time = Latency::now();
+		record.peerID = peerID;
+		record.peerType = peerType;
+		record.size = (std::uint16_t)(command.size() < mCommandSize ? command.size() : mCommandSize);
+		std::memcpy(&ring.commands[(head & (CAPTURE_RING_SIZE - 1)) * mCommandSize], command.data(), record.size);
+		ring.head.store(head + 1, std::memory_order_release);
+	}
+};
+
+#endif
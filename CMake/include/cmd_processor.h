@@ -5,6 +5,12 @@
 #include "udp_peer.h"
 #include "ssl_ccm.h"
 #include "ssl_peer.h"
+#include "metrics.h"
+#include "admission.h"
+#include "udp_limiter.h"
+#include "runtime_limits.h"
+#include "capture.h"
+#include "trace.h"
 
 #define STR_V4 "v4"						// Version V4 in string
 #define STR_V6 "v6"						// Version V6 in string
@@ -24,27 +30,39 @@ struct CmdProcessor
 	static void processCommand(TSpeer& peer)
 	{
 		auto commandStr = peer.getCommandString();
-		auto command = extractElement(commandStr);
+		Capture::record(peer.peerID(), peer.peerType(), commandStr);
+		auto command = findCommand(extractElement(commandStr));
+		Metrics::countCommand(peer.peerType() == PeerType::SSL ? MetricSource::SSL : MetricSource::TCP, command);
+		RTDS_TRACE3(command, (int)peer.peerType(), command, peer.peerID());
 
-		if (command == COMM[(short)Command::BROADCAST])
+		if (Admission::shedCommand(command))
+			peer.respondWith(Response::WAIT_RETRY);
+		else if (command == (short)Command::BROADCAST)
 			mTCP_broadcast(peer, commandStr);
-		else if (command == COMM[(short)Command::MESSAGE])
+		else if (command == (short)Command::MESSAGE)
 			mTCP_message(peer, commandStr);
-		else if (command == COMM[(short)Command::CHANGE])
+		else if (command == (short)Command::CHANGE)
 			mTCP_change(peer, commandStr);
-		else if (command == COMM[(short)Command::LISTEN])
+		else if (command == (short)Command::LISTEN)
 			mTCP_listen(peer, commandStr);
-		else if (command == COMM[(short)Command::LEAVE])
+		else if (command == (short)Command::LEAVE)
 			mTCP_leave(peer, commandStr);
-		else if (command == COMM[(short)Command::PING])
+		else if (command == (short)Command::PING)
 			mTCP_ping(peer, commandStr);
-		else if (command == COMM[(short)Command::EXIT])
+		else if (command == (short)Command::EXIT)
 			mTCP_exit(peer, commandStr);
 		else
 			peer.respondWith(Response::BAD_COMMAND);
 	}
 
 /*******************************************************************************************
+* @brief Find the command
+*
+* @param[in]			The string view of the command.
+* @return				Index of the command in COMM (COMMAND_COUNT if unknown).
+********************************************************************************************/
+	static short findCommand(const std::string_view&);
+/*******************************************************************************************
 * @brief Return the tag type
 *
 * @param[in]			The string view of the Tag.
@@ -141,6 +159,22 @@ struct CmdProcessor
 ********************************************************************************************/
 	static bool isThreadCount(const std::string, short&);
 /*******************************************************************************************
+* @brief Check if the string is a warm pool size
+*
+* @param[in]			Pool size.
+* @param[out]			Pool size value if true.
+* @return				True if pool size.
+********************************************************************************************/
+	static bool isPoolSize(const std::string, unsigned int&);
+/*******************************************************************************************
+* @brief Check if the string is a load shedding or connection limit
+*
+* @param[in]			Limit.
+* @param[out]			Limit value if true.
+* @return				True if limit [0-MAX_LIMIT_VALUE].
+********************************************************************************************/
+	static bool isLimit(const std::string, unsigned int&);
+/*******************************************************************************************
 * @brief get SAP string
 *
 * @param[in]			Remote Endpoint.
@@ -195,6 +229,11 @@ private:
 	static void mCCM_exit(SSLccm&, std::string_view&);
 	static void mCCM_status(SSLccm&, std::string_view&);
 	static void mCCM_abort(SSLccm&, std::string_view&);
+	static void mCCM_reload(SSLccm&, std::string_view&);
+	static void mCCM_stats(SSLccm&, std::string_view&);
+	static void mCCM_latency(SSLccm&, std::string_view&);
+	static void mCCM_loglevel(SSLccm&, std::string_view&);
+	static void mCCM_dump(SSLccm&, std::string_view&);
 
 /*******************************************************************************************
 * @brief Respond to the request
@@ -9,31 +9,57 @@
 #define RTDS_DUAL_STACK					// Enable IPV6 support (use ::1 for local host)
 #define RDTS_DEF_PORT 321				// Default RTDS port number
 #define RTDS_DEF_CCM_PORT 333			// Default CCM port number
-#define MAX_THREAD_COUNT 28				// Maximum Thread Count
+#define DEF_MAX_THREAD_COUNT 28			// Default maximum Thread Count (max_threads in the config file)
+#define MAX_THREAD_LIMIT 1024			// Largest max_threads accepted
 #define MIN_THREAD_COUNT 2				// Minimum Thread Count
+#define DEF_METRICS_ADDRESS "127.0.0.1"	// Default address of the metrics HTTP listener (loopback only)
+#define DEF_WARM_POOL_SIZE 1024			// Default number of preallocated peers and sockets
+#define MAX_WARM_POOL_SIZE 1048576		// Maximum number of preallocated peers and sockets
+#define HANDSHAKE_THREAD_COUNT 2		// Number of threads doing the TLS handshakes
+#define MAX_PENDING_HANDSHAKES 1024		// Maximum number of SSL handshakes in progress
+#define MAX_PENDING_CCM_HANDSHAKES 16	// Maximum number of CCM handshakes in progress (separate budget)
+#define HANDSHAKE_TIMEOUT 10			// Seconds a TLS handshake may take before the socket is closed
+#define DEF_MAX_LOOP_LAG 100			// Default event loop lag in ms above which commands are shed (0 to disable)
+#define DEF_MAX_PENDING 1048576			// Default queued deliveries above which commands are shed (0 to disable)
+#define DEF_MAX_SOURCE_CONNECTIONS 0	// Default open connections allowed per source and listener (0 to disable)
+#define DEF_SOURCE_CONNECT_RATE 0		// Default connects per second allowed per source and listener (0 to disable)
+#define DEF_UDP_PING_RATE 0			// Default UDP pings (and other direct answers) per second allowed per source (0 to disable)
+#define DEF_UDP_FANOUT_RATE 0			// Default UDP broadcasts and messages per second allowed per source (0 to disable)
+#define MAX_LIMIT_VALUE 9999999		// Maximum value of the load shedding and connection limits
+#define TLS_WATCH_INTERVAL 10			// Seconds between checks for a changed certificate (0 to disable)
 #define MAX_PORT_NUM_VALUE 65535		// Maximum value for port number
 
+#ifndef _WIN32
+#define RTDS_HANDOVER					// Enable listening socket handover to a new RTDS process
+#endif
+#define MAX_DRAIN_TIME 30				// Maximum number of seconds to drain peers after handover
+
+#define PRINT_DEBUG_LOG					// Compile the debug logs (enabled at runtime, CCM "loglevel")
 #ifndef NDEBUG
-#define PRINT_DEBUG_LOG					// Print debug log to file
 #define OUTPUT_DEBUG_LOG				// Print debug log to screen
 #endif
-#define PRINT_LOG						// Print critical console logs
+#define PRINT_LOG						// Compile the critical logs
 
 #define ALL_TAG "*"						// Represent all tags in a BG
 #define UDP_TAG "$"						// Default BGT for UDP peers
 #define OWN_TAG "+"						// The same peer's tag
 
 
-#define MIN_BGID_SIZE 2					// Minimum size of BGID
-#define MAX_BGID_SIZE 128				// Maximum size of BGID
+#define DEF_MIN_BGID_SIZE 2				// Default minimum size of BGID
+#define DEF_MAX_BGID_SIZE 128			// Default maximum size of BGID
 
-#define MIN_TAG_SIZE 2					// Minimum size of Tag
-#define MAX_TAG_SIZE 32					// Maximum size of Tag
+#define DEF_MIN_TAG_SIZE 2				// Default minimum size of Tag
+#define DEF_MAX_TAG_SIZE 32				// Default maximum size of Tag
 
-#define RTDS_BUFF_SIZE 512				// Maximum size of the readBuffer
-#define MAX_BROADCAST_SIZE 256			// Maximum size of B data
-#define MAX_MSG_CACHE_SIZE 128			// Maximum number of messages to be cached
-#define MIN_MSG_KEEP_TIME 1				// Minimum number of minutes to keep the message
+#define DEF_BUFF_SIZE 512				// Default size of the readBuffer
+#define MIN_BUFF_SIZE 128				// Smallest buffer_size accepted
+#define MAX_BUFF_SIZE 65535				// Largest buffer_size accepted
+#define DEF_MAX_BROADCAST_SIZE 256		// Default maximum size of B data
+#define SSL_FLUSH_DELAY 200				// Microseconds a message may wait to be coalesced for an SSL peer
+#define SSL_COALESCE_SIZE 16384			// Pending size (one TLS record) written to an SSL peer without waiting
+#define SSL_MAX_PENDING_SIZE 1048576	// Pending size above which a slow SSL peer is disconnected
+#define DEF_MSG_CACHE_SIZE 128			// Default maximum number of messages to be cached
+#define DEF_MSG_KEEP_TIME 1				// Default minimum number of minutes to keep the message
 
 #define USRN_MAX_SIZE 15				// Maximum size of username
 #define PASS_MAX_SIZE 30				// Maximum size of password
@@ -82,6 +108,11 @@ enum class Response
 * login				[CCM] Login to RTDS CCM
 * abort				[CCM] Terminate the RTDS server
 * status			[CCM] Status of the RTDS server
+* reload			[CCM] Reload the TLS certificates
+* stats				[CCM] Counters and gauges of the RTDS server
+* latency			[CCM] Latency percentiles of the RTDS server
+* loglevel			[CCM] Get or set the runtime log levels
+* dump				[CCM] Dump the flight recorder events
 ********************************************************************************************/
 enum class Command
 {
@@ -94,8 +125,14 @@ enum class Command
 	EXIT,
 	LOGIN,
 	ABORT,
-	STATUS
+	STATUS,
+	RELOAD,
+	STATS,
+	LATENCY,
+	LOGLEVEL,
+	DUMP
 };
+#define COMMAND_COUNT 15				// Number of commands
 
 /*******************************************************************************************
 * @brief Enum class for Peer listening mode
@@ -0,0 +1,117 @@
+#ifndef CONNECTION_QUOTA_H
+#define CONNECTION_QUOTA_H
+
+#include <asio/ip/address.hpp>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include "handover.h"
+#include "latency.h"
+
+#define QUOTA_TABLE_BITS 16					// Entries in the source table (2^16, 32 bytes each)
+#define QUOTA_SHARD_BITS 6					// Shards of the source table, each with its own lock (2^6)
+#define QUOTA_PROBE_LIMIT 16				// Entries searched for a source (the least recently used is evicted if all hold connections)
+#define QUOTA_GENERATION_MASK 0x7FFF		// Generations of an entry told apart by its slots
+#define QUOTA_CACHE_LINE 64					// Size of a cache line (shard locks never share a line)
+#define QUOTA_UNTRACKED 0xFFFFFFFF			// Slot of a connection not counted in the table
+#define QUOTA_REJECTED 0xFFFFFFFE			// Slot returned for a rejected connection
+
+/*******************************************************************************************
+* @brief Per-source connection quota and connect rate for the TCP, SSL and CCM listeners
+*
+* @details
+* Sources are kept per listener in a fixed open addressing table (allocated once a limit is
+* set). IPv4 sources are counted by address, IPv6 sources by /64 prefix, hashed with a
+* random per-process seed so the slots of a source can not be predicted. The connect rate is
+* a token bucket holding one second of connects (kept as the time the bucket is full again).
+* Entries without connections and with a full bucket are reused by new sources. When none is
+* found within QUOTA_PROBE_LIMIT, the entry whose bucket fills up first (least recently used)
+* is reused, preferring one without connections; a table full of busy sources never locks
+* new sources out. An entry evicted with open connections starts a new generation, so the
+* connections of the evicted source are not released from the new one.
+* The table is split in shards of consecutive entries, each with its own lock; a source is
+* searched within the shard of its hash, so accepts from different sources rarely contend.
+********************************************************************************************/
+class ConnectionQuota
+{
+	struct Entry
+	{
+		std::array<unsigned char, 16> address;	// Source address (IPv4 mapped or IPv6 /64 prefix)
+		LatencyTick fullTick;				// Time the connect bucket is full again
+		std::uint32_t connections;			// Open connections of the source
+		std::uint16_t generation;			// Times the entry was evicted with open connections
+		std::uint8_t listener;				// Listener + 1 (0 if the entry was never used)
+	};
+
+	struct alignas(QUOTA_CACHE_LINE) Shard
+	{
+		std::mutex lock;					// Mutex for the entries of the shard
+	};
+
+	static std::vector<Entry> mTable;		// Source table (empty if no limit is set)
+	static std::atomic<bool> mHasTable;		// True once the table and its seed are set
+	static std::array<Shard, std::size_t(1) << QUOTA_SHARD_BITS> mShards;	// Locks of the table shards
+	static std::uint32_t mMaxConnections;	// Open connections allowed per source (0 if disabled)
+	static LatencyTick mConnectInterval;	// Nanoseconds per connect token (0 if disabled)
+	static LatencyTick mBurstTolerance;		// Nanoseconds the bucket may run ahead of now
+	static std::uint64_t mHashSeed;			// Seed of the source hash (set with the table)
+
+/*******************************************************************************************
+* @brief Count a connection of an entry if it is within the limits (shard lock held)
+*
+* @return				Slot of the entry (index and generation), or QUOTA_REJECTED
+********************************************************************************************/
+	static std::uint32_t mAdmit(const std::uint32_t, const LatencyTick);
+
+public:
+/*******************************************************************************************
+* @brief Set the limits
+*
+* @param[in]			Open connections allowed per source (0 to disable)
+* @param[in]			Connects per second allowed per source (0 to disable)
+*
+* @details
+* Takes all the shard locks, so the accepts see the old or the new limits, never a mix.
+********************************************************************************************/
+	static void setLimits(const unsigned int, const unsigned int);
+/*******************************************************************************************
+* @brief Count a connection accepted from a source
+*
+* @param[in]			Listener that accepted the connection
+* @param[in]			Source address
+* @return				Slot to release when the connection is closed (QUOTA_UNTRACKED if
+*						not counted), or QUOTA_REJECTED if the connection has to be closed
+********************************************************************************************/
+	static std::uint32_t acquire(const Listener, const asio::ip::address&);
+/*******************************************************************************************
+* @brief Release a connection counted by acquire()
+*
+* @param[in]			Slot returned by acquire()
+********************************************************************************************/
+	static void release(const std::uint32_t);
+/*******************************************************************************************
+* @brief Get the bytes a source is counted by
+*
+* @param[in]			Source address
+* @return				IPv4 mapped address, or the /64 prefix of an IPv6 address
+********************************************************************************************/
+	static std::array<unsigned char, 16> sourceBytes(const asio::ip::address&);
+/*******************************************************************************************
+* @brief Hash the bytes of a source
+*
+* @param[in]			Bytes returned by sourceBytes()
+* @param[in]			Seed of the table
+* @return				Hash (every bit depends on the seed and all source bytes)
+********************************************************************************************/
+	static std::uint64_t sourceHash(const std::array<unsigned char, 16>&, const std::uint64_t);
+/*******************************************************************************************
+* @brief Get a random seed for a source table
+*
+* @return				Value from std::random_device (the steady clock if none is available)
+********************************************************************************************/
+	static std::uint64_t randomSeed();
+};
+
+#endif
@@ -0,0 +1,163 @@
+#ifndef FLIGHT_RECORDER_H
+#define FLIGHT_RECORDER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+#define FLIGHT_RING_SIZE 1024				// Events kept per thread (power of two)
+#define FLIGHT_MAX_THREADS 64				// Threads that can record at a time (the ring of an exited thread is reused)
+#define FLIGHT_DETAIL_SIZE 40				// Characters of detail kept per event
+#define FLIGHT_SLOW_HANDLER 10000000		// Nanoseconds after which a command or delivery is slow (10 ms)
+#define FLIGHT_DUMP_FILE "flight.txt"		// File the events are dumped to
+#define FLIGHT_SIGNAL_STACK_SIZE 65536		// Bytes of the alternate stack the crash handler runs on
+
+/*******************************************************************************************
+* @brief Enum class for the flight recorder events
+*
+* @details
+* ACCEPT			Peer connected (value: peer type, detail: SAP)
+* JOIN				Peer joined a BG (detail: BGID)
+* LEAVE				Peer left a BG (detail: BGID)
+* DROP				Message not created or not delivered (detail: SAP or reason)
+* FAILURE			Socket or allocation error (value: error code, detail: message)
+* SLOW				Slow command or delivery (value: nanoseconds, detail: latency kind)
+* ABORT				RTDS aborted by CCM
+* DUMP				Events dumped on demand
+* SHED				Load shedding started (value: loop lag in ns or pending deliveries, detail: reason) or stopped
+********************************************************************************************/
+enum class FlightEvent : std::uint8_t
+{
+	ACCEPT,
+	JOIN,
+	LEAVE,
+	DROP,
+	FAILURE,
+	SLOW,
+	ABORT,
+	DUMP,
+	SHED
+};
+#define FLIGHT_EVENT_COUNT 9
+
+class FlightRecorder
+{
+	struct Event
+	{
+		std::int64_t time;						// System time of the event in microseconds
+		std::int64_t value;						// Event specific value
+		FlightEvent type;						// Event type
+		std::uint8_t detailSize;				// Number of characters in detail
+		char detail[FLIGHT_DETAIL_SIZE];		// Event specific text (not null terminated)
+	};
+
+	struct Ring
+	{
+		std::atomic<std::uint64_t> head;		// Number of events recorded by the owning threads
+		std::atomic<bool> isOwned;				// True while a running thread records to the ring
+		Event events[FLIGHT_RING_SIZE];			// Last FLIGHT_RING_SIZE events (oldest overwritten)
+	};
+
+	inline static thread_local Ring* mThreadRing = nullptr;	// Ring of the calling thread
+	static std::atomic<Ring*> mRings[FLIGHT_MAX_THREADS];	// Rings of all threads that recorded
+	static std::atomic<int> mRingCount;			// Number of registered rings
+	static std::atomic_flag mRingsFull;			// Set once the thread without a ring is logged
+	static std::atomic<bool> mDumping;			// True while a dump thread writes FLIGHT_DUMP_FILE
+	static const char* const NAME[];			// Name of the events
+
+/*******************************************************************************************
+* @brief Take the ring of an exited thread, or create and register one, for the calling thread
+*
+* @return				Ring, or nullptr if FLIGHT_MAX_THREADS running threads own a ring
+*
+* @details
+* The ring is released when the thread exits; its events are kept until the ring is reused.
+* The first thread left without a ring is logged.
+********************************************************************************************/
+	static Ring* mRegisterRing();
+/*******************************************************************************************
+* @brief Write the events of all rings to a file descriptor
+*
+* @param[in]			File descriptor
+*
+* @details
+* Only uses async-signal-safe calls, so it also runs in the fatal signal handler.
+* Events written by the other threads during the dump may be torn.
+********************************************************************************************/
+	static void mWriteEvents(int);
+/*******************************************************************************************
+* @brief Write the events of all rings to FLIGHT_DUMP_FILE (dump thread)
+********************************************************************************************/
+	static void mDumpRoutine();
+/*******************************************************************************************
+* @brief Dump the events and re-raise a fatal signal
+********************************************************************************************/
+	static void mSignalHandler(int);
+
+public:
+/*******************************************************************************************
+* @brief Record an event in the calling thread's ring
+*
+* @param[in]			Event
+* @param[in]			Event specific value
+* @param[in]			Event specific text (truncated to FLIGHT_DETAIL_SIZE)
+*
+* @details
+* Always on; the owning thread overwrites its oldest event, no lock and no allocation.
+********************************************************************************************/
+	static void record(const FlightEvent type, const std::int64_t value = 0, const std::string_view& detail = {})
+	{
+		if (mThreadRing == nullptr)
+		{
+			mThreadRing = mRegisterRing();
+			if (mThreadRing == nullptr)
+				return;
+		}
+		auto head = mThreadRing->head.load(std::memory_order_relaxed);
+		auto& event = mThreadRing->events[head & (FLIGHT_RING_SIZE - 1)];
+		event.time = std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::system_clock::now().time_since_epoch()).count();
+		event.value = value;
+		event.type = type;
+		event.detailSize = (std::uint8_t)(detail.size() < FLIGHT_DETAIL_SIZE ? detail.size() : FLIGHT_DETAIL_SIZE);
+		if (event.detailSize > 0)
+			std::memcpy(event.detail, detail.data(), event.detailSize);
+		mThreadRing->head.store(head + 1, std::memory_order_release);
+	}
+/*******************************************************************************************
+* @brief Dump the events of all threads to FLIGHT_DUMP_FILE on a separate thread
+*
+* @return				False if a dump is running or the thread can not be started
+*
+* @details
+* The file is written by a detached thread, so the calling IO thread does not block on the
+* file system. A failure to write the file is logged.
+********************************************************************************************/
+	static bool dump();
+/*******************************************************************************************
+* @brief Wait until a running dump is written (call before exiting)
+********************************************************************************************/
+	static void waitForDump();
+/*******************************************************************************************
+* @brief Dump the events to FLIGHT_DUMP_FILE on a fatal signal (SIGSEGV, SIGBUS, SIGFPE,
+* SIGILL, SIGABRT) [POSIX only]
+*
+* @details
+* The handler runs on an alternate signal stack, so a stack overflow is dumped as well.
+* The stack of the calling thread is installed here, the other threads install theirs
+* with installSignalStack (threads that record install it with their ring).
+********************************************************************************************/
+	static void installCrashHandler();
+/*******************************************************************************************
+* @brief Give the calling thread an alternate stack of FLIGHT_SIGNAL_STACK_SIZE bytes for
+* the crash handler [POSIX only]
+*
+* @details
+* Installed once per thread and released when the thread exits.
+********************************************************************************************/
+	static void installSignalStack();
+};
+
+#endif
@@ -0,0 +1,121 @@
+#ifndef HANDLER_ALLOCATOR_H
+#define HANDLER_ALLOCATOR_H
+
+#include <array>
+#include <cstddef>
+#include <utility>
+#include <type_traits>
+
+#define HANDLER_SLOT_SIZE 64				// Granularity of the recycled handler memory (in bytes)
+#define HANDLER_SLOT_CLASSES 16				// Number of size classes (upto 1024 bytes)
+#define MAX_RECYCLED_HANDLERS 64			// Maximum number of blocks cached per size class per thread
+
+class HandlerMemory
+{
+	struct FreeBlock
+	{
+		FreeBlock* next;						// Next free block of the same size class
+	};
+	struct ThreadCache
+	{
+		std::array<FreeBlock*, HANDLER_SLOT_CLASSES> freeList{};	// Free blocks of each size class
+		std::array<unsigned, HANDLER_SLOT_CLASSES> freeCount{};	// Number of free blocks of each size class
+		~ThreadCache();
+	};
+	static thread_local ThreadCache mCache;		// Recycled blocks of the calling thread
+
+public:
+/*******************************************************************************************
+* @brief Allocate memory for an asio completion handler
+*
+* @param[in]			Size in bytes
+* @return				Pointer to the memory
+*
+* @details
+* Reuse a block recycled by this thread if available, else allocate from the heap.
+* Sizes above the largest size class are always allocated from the heap.
+********************************************************************************************/
+	static void* allocate(std::size_t);
+/*******************************************************************************************
+* @brief Recycle the memory of an asio completion handler
+*
+* @param[in]			Pointer to the memory
+* @param[in]			Size in bytes (same as the allocation)
+*
+* @details
+* The block is cached by the calling thread (not necessarily the allocating thread).
+* Blocks beyond MAX_RECYCLED_HANDLERS are returned to the heap.
+********************************************************************************************/
+	static void deallocate(void*, std::size_t);
+};
+
+/*******************************************************************************************
+* @brief Allocator handing out recycled handler memory (associated with AllocHandler)
+********************************************************************************************/
+template<typename T>
+class HandlerAllocator
+{
+public:
+	typedef T value_type;
+
+	HandlerAllocator() noexcept = default;
+	template<typename U>
+	HandlerAllocator(const HandlerAllocator<U>&) noexcept {}
+
+	T* allocate(std::size_t count)
+	{
+		return static_cast<T*>(HandlerMemory::allocate(sizeof(T) * count));
+	}
+	void deallocate(T* pointer, std::size_t count)
+	{
+		HandlerMemory::deallocate(pointer, sizeof(T) * count);
+	}
+	template<typename U>
+	bool operator ==(const HandlerAllocator<U>&) const noexcept
+	{
+		return true;
+	}
+	template<typename U>
+	bool operator !=(const HandlerAllocator<U>&) const noexcept
+	{
+		return false;
+	}
+};
+
+/*******************************************************************************************
+* @brief Completion handler wrapper that makes asio use the HandlerAllocator
+********************************************************************************************/
+template<typename Handler>
+class AllocHandler
+{
+	Handler mHandler;							// Wrapped completion handler
+
+public:
+	typedef HandlerAllocator<Handler> allocator_type;
+
+	AllocHandler(Handler handler) : mHandler(std::move(handler)) {}
+
+	allocator_type get_allocator() const noexcept
+	{
+		return allocator_type();
+	}
+	template<typename... Args>
+	void operator ()(Args&&... args)
+	{
+		mHandler(std::forward<Args>(args)...);
+	}
+};
+
+/*******************************************************************************************
+* @brief Wrap a completion handler so that asio allocates its operation from HandlerMemory
+*
+* @param[in]			Completion handler
+* @return				Wrapped completion handler
+********************************************************************************************/
+template<typename Handler>
+inline AllocHandler<typename std::decay<Handler>::type> makeAllocHandler(Handler&& handler)
+{
+	return AllocHandler<typename std::decay<Handler>::type>(std::forward<Handler>(handler));
+}
+
+#endif
@@ -0,0 +1,95 @@
+#ifndef HANDOVER_H
+#define HANDOVER_H
+
+#include <array>
+#include <string>
+#include "common.h"
+
+#define HANDOVER_MAGIC "RTDS"					// Payload send along with the listening sockets
+#define LISTENER_COUNT 4						// Number of listening sockets handed over
+
+/*******************************************************************************************
+* @brief Enum class for the listening sockets (index into ListenerFDs)
+*
+* @details
+* TCP				TCP acceptor
+* UDP				UDP socket
+* SSL				SSL acceptor
+* CCM				CCM acceptor
+********************************************************************************************/
+enum class Listener
+{
+	TCP,
+	UDP,
+	SSL,
+	CCM
+};
+typedef std::array<int, LISTENER_COUNT> ListenerFDs;
+
+#ifdef RTDS_HANDOVER
+#include <sys/un.h>
+#include <csignal>
+
+#define HANDOVER_WAKE_SIGNAL SIGUSR2			// Signal interrupting the blocked accept / receive of the listener threads
+#define HANDOVER_WAKE_ATTEMPTS 100				// Times the listener threads are signalled (10 ms apart)
+
+class Handover
+{
+/*******************************************************************************************
+* @brief Fill the unix socket address for the handover path
+*
+* @param[in]			Handover path
+* @param[out]			Unix socket address
+* @return				True if the path fits in the address
+********************************************************************************************/
+	static bool mMakeAddress(const std::string&, sockaddr_un&);
+public:
+/*******************************************************************************************
+* @brief Take over the listening sockets from the RTDS running at the handover path
+*
+* @param[in]			Handover path
+* @param[out]			Listening socket file descriptors
+* @return				True if the sockets were received
+*
+* @details
+* Return false if no RTDS is listening at the handover path (fresh start).
+* Blocks until the running RTDS sends the sockets.
+********************************************************************************************/
+	static bool receiveListeners(const std::string&, ListenerFDs&);
+/*******************************************************************************************
+* @brief Open the handover listener at the handover path
+*
+* @param[in]			Handover path
+* @return				File descriptor of the listener or -1 on failure
+*
+* @details
+* A stale socket file left at the path is removed.
+********************************************************************************************/
+	static int openListener(const std::string&);
+/*******************************************************************************************
+* @brief Wait for a new RTDS and send it the listening sockets
+*
+* @param[in]			File descriptor of the handover listener
+* @param[in]			Handover path
+* @param[in]			Listening socket file descriptors
+* @return				True if the sockets were handed over
+*
+* @details
+* Blocks until a new RTDS connects. The handover listener is closed and the path is
+* unlinked before sending, so that the new RTDS can open its own listener at the path.
+********************************************************************************************/
+	static bool sendListeners(int, const std::string&, const ListenerFDs&);
+/*******************************************************************************************
+* @brief Install the (empty) handler of HANDOVER_WAKE_SIGNAL
+*
+* @details
+* The handler is installed without SA_RESTART, so a blocked accept or receive returns
+* EINTR. Closing or shutting down the listening sockets can not be used to wake them:
+* close does not interrupt a blocked call, and shutdown would stop the sockets in the
+* new RTDS as well (both processes share them).
+********************************************************************************************/
+	static void installWakeSignal();
+};
+#endif
+
+#endif
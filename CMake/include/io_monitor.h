@@ -0,0 +1,92 @@
+#ifndef IO_MONITOR_H
+#define IO_MONITOR_H
+
+#include <asio/io_context.hpp>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "latency.h"
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+#define IO_PROBE_INTERVAL 100				// Milliseconds between the event loop lag probes
+
+class IOmonitor
+{
+	struct Thread
+	{
+		std::atomic<std::uint64_t> handlers;	// Handlers executed (written only by the owning thread)
+		LatencyTick startTick;					// Time the thread started running the ioContext
+		bool hasCPUclock;						// False if the CPU time of the thread can not be read
+#ifdef _WIN32
+		void* threadHandle;						// Handle for GetThreadTimes
+#else
+		clockid_t cpuClock;						// CPU time clock of the thread
+#endif
+	};
+
+	static std::vector<std::unique_ptr<Thread>> mThreads;	// IO threads that ran the ioContext
+	static std::mutex mThreadLock;				// Mutex for registering a new thread
+	static std::atomic<LatencyTick> mProbeTick;	// Time the pending probe was posted (0 if none)
+	static std::atomic<LatencyTick> mLastLag;	// Lag of the last probe that ran
+
+/*******************************************************************************************
+* @brief Create and register the calling thread
+*
+* @details
+* The CPU clock is taken on the calling thread; if it is not available, the thread is
+* reported without busy and waiting time.
+********************************************************************************************/
+	static Thread* mRegisterThread();
+/*******************************************************************************************
+* @brief Remove a thread that stopped running the ioContext
+********************************************************************************************/
+	static void mUnregisterThread(const Thread*);
+/*******************************************************************************************
+* @brief Get the CPU time (user and system) used by a thread in nanoseconds
+********************************************************************************************/
+	static LatencyTick mCPUtime(const Thread&);
+
+public:
+/*******************************************************************************************
+* @brief Run the ioContext on the calling thread, counting the executed handlers
+*
+* @param[in]			ioContext
+* @param[out]			Error code of the failed run
+*
+* @details
+* Returns once the ioContext is stopped. The time the thread is not on the CPU is the time
+* waiting in the reactor (or blocked on a lock).
+********************************************************************************************/
+	static void run(asio::io_context&, asio::error_code&);
+/*******************************************************************************************
+* @brief Post a handler that records the scheduling lag (LatencyKind::LOOP_LAG)
+*
+* @param[in]			ioContext
+*
+* @details
+* The lag is the delay from posting the handler to it running on an IO thread.
+* No new probe is posted while the last one is still waiting to run.
+********************************************************************************************/
+	static void probe(asio::io_context&);
+/*******************************************************************************************
+* @brief Get the current event loop lag in nanoseconds
+*
+* @details
+* Lag of the last probe, or the time the pending probe has been waiting if that is longer.
+********************************************************************************************/
+	static LatencyTick lag();
+/*******************************************************************************************
+* @brief Generate the IO thread utilization string
+*
+* @return				Tab separated ioN=busy,waiting,handlers (seconds since the thread started,
+*						busy and waiting are - if the CPU time of the thread is not available)
+********************************************************************************************/
+	static std::string generateReport();
+};
+
+#endif
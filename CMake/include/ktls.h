@@ -0,0 +1,93 @@
+#ifndef KTLS_H
+#define KTLS_H
+
+#include "common.h"
+
+#ifdef RTDS_KTLS
+#include <asio/ip/tcp.hpp>
+#include <asio/ssl.hpp>
+#include <asio/strand.hpp>
+#include <asio/thread_pool.hpp>
+#include <functional>
+#ifdef OPENSSL_NO_KTLS
+#error "RTDS_KTLS needs an OpenSSL built with kernel TLS support (enable-ktls)"
+#endif
+typedef asio::ssl::stream<asio::ip::tcp::socket> SSLsocket;
+typedef asio::strand<asio::thread_pool::executor_type> HandshakeStrand;
+typedef std::function<void(const asio::error_code&)> HandshakeHandler;
+
+/*******************************************************************************************
+* @brief Kernel TLS for the data send to SSL peers (CMake option RTDS_KTLS, off by default)
+*
+* @details
+* OpenSSL switches the socket to kernel TLS itself (SSL_OP_ENABLE_KTLS) when the keys are
+* installed, but only on a socket BIO. asio::ssl::stream drives OpenSSL through a memory BIO
+* pair and can not run a handshake on a socket BIO, so the handshake is driven here instead,
+* with OpenSSL reading and writing the TCP socket directly. The stream takes over the reads
+* after the handshake: only the transmit side is handed over, the stream keeps decrypting.
+********************************************************************************************/
+class KernelTLS
+{
+/*******************************************************************************************
+* @brief Make OpenSSL read and write the TCP socket for the handshake
+*
+* @param[in]			SSL socket with an accepted connection
+* @return				Stream BIO to restore as the read BIO, nullptr on failure
+*
+* @details
+* The reads go through a fd BIO, so that OpenSSL never hands the receive side to the kernel.
+********************************************************************************************/
+	static BIO* mUseSocketBIOs(SSLsocket&);
+/*******************************************************************************************
+* @brief Run the handshake until OpenSSL has to wait for the socket
+*
+* @param[in]			SSL socket
+* @param[in]			Stream BIO (see mUseSocketBIOs)
+* @param[in]			Strand of the handshake pool
+* @param[in]			Handshake handler
+********************************************************************************************/
+	static void mHandshakeStep(SSLsocket&, BIO*, const HandshakeStrand&, HandshakeHandler);
+/*******************************************************************************************
+* @brief Give the reads back to the stream and call the handshake handler
+*
+* @param[in]			SSL socket
+* @param[in]			Stream BIO (see mUseSocketBIOs)
+* @param[in]			Handshake result
+* @param[in]			Handshake handler
+********************************************************************************************/
+	static void mFinishHandshake(SSLsocket&, BIO*, const asio::error_code&, const HandshakeHandler&);
+public:
+/*******************************************************************************************
+* @brief Let OpenSSL enable kernel TLS on the connections of the SSL context
+*
+* @param[in]			SSL context
+********************************************************************************************/
+	static void configure(asio::ssl::context&);
+/*******************************************************************************************
+* @brief Start the server side handshake (on the handshake strand)
+*
+* @param[in]			SSL socket with an accepted connection
+* @param[in]			Strand of the handshake pool running the handshake
+* @param[in]			Handshake handler (runs on the strand)
+*
+* @details
+* Without kernel TLS on the SSL context (or if the BIOs can not be created), this is the
+* async_handshake of the stream. Closing the socket aborts the handshake.
+********************************************************************************************/
+	static void handshake(SSLsocket&, const HandshakeStrand&, HandshakeHandler);
+/*******************************************************************************************
+* @brief Check if the kernel encrypts the data send to the socket (call after the handshake)
+*
+* @param[in]			SSL socket that completed the handshake
+* @return				True if the data send to the socket is encrypted by the kernel
+*
+* @details
+* On success, data must be written to the TCP socket directly (never through the stream);
+* records OpenSSL still writes (alerts, KeyUpdate) go through the kernel as well.
+* Otherwise (no tls module, cipher not supported) the writes go back to the stream.
+********************************************************************************************/
+	static bool enableTX(SSLsocket&);
+};
+
+#endif
+#endif
@@ -0,0 +1,167 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "flight_recorder.h"
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#define LATENCY_SUB_BITS 5				// Sub-buckets per power of two (2^5, upto 3% error)
+#define LATENCY_MAX_BITS 40				// Largest recorded latency (2^40 ns, about 18 minutes)
+
+/*******************************************************************************************
+* @brief Enum class for the latency histograms
+*
+* @details
+* TCP_COMMAND		TCP command received to response send
+* UDP_COMMAND		UDP command received to response send
+* SSL_COMMAND		SSL command received to response queued
+* FANOUT			Message created to message written to a peer (once per delivery)
+* LOOP_LAG			Handler posted to handler run on an IO thread (IOmonitor::probe)
+********************************************************************************************/
+enum class LatencyKind
+{
+	TCP_COMMAND,
+	UDP_COMMAND,
+	SSL_COMMAND,
+	FANOUT,
+	LOOP_LAG
+};
+#define LATENCY_KIND_COUNT 5
+
+typedef std::int64_t LatencyTick;			// Steady clock time in nanoseconds
+
+class Latency
+{
+	static constexpr std::size_t SUB_COUNT = std::size_t(1) << LATENCY_SUB_BITS;
+	static constexpr std::size_t BUCKET_COUNT = SUB_COUNT * (LATENCY_MAX_BITS - LATENCY_SUB_BITS + 1);
+
+	struct alignas(64) Shard
+	{
+		std::atomic<std::uint64_t> counts[LATENCY_KIND_COUNT][BUCKET_COUNT];	// Written only by the owning thread
+		std::atomic<std::uint64_t> sums[LATENCY_KIND_COUNT];				// Sum of the recorded latencies
+	};
+
+	inline static thread_local Shard* mThreadShard = nullptr;	// Shard of the calling thread
+	static std::vector<Shard*> mShards;			// Shards of all threads that recorded a latency
+	static std::mutex mShardLock;				// Mutex for registering a new shard
+	static const std::string NAME[];			// Name of the histograms
+
+/*******************************************************************************************
+* @brief Create and register the shard of the calling thread
+********************************************************************************************/
+	static Shard* mRegisterShard();
+/*******************************************************************************************
+* @brief Find the log-linear bucket of a latency
+*
+* @param[in]			Latency in nanoseconds
+* @return				Bucket index
+*
+* @details
+* Values below SUB_COUNT have their own bucket; above that each power of two is split in
+* SUB_COUNT linear buckets. Values beyond the range go to the last bucket.
+********************************************************************************************/
+	static std::size_t mBucket(std::uint64_t value)
+	{
+		if (value < SUB_COUNT)
+			return (std::size_t)value;
+#ifdef _MSC_VER
+		unsigned long exponent;
+		_BitScanReverse64(&exponent, value);
+#else
+		std::size_t exponent = 63 - __builtin_clzll(value);
+#endif
+		if (exponent >= LATENCY_MAX_BITS)
+			return BUCKET_COUNT - 1;
+		auto shift = exponent - LATENCY_SUB_BITS;
+		return SUB_COUNT * (shift + 1) + ((value >> shift) & (SUB_COUNT - 1));
+	}
+/*******************************************************************************************
+* @brief Get the highest latency that falls in a bucket
+********************************************************************************************/
+	static std::uint64_t mBucketMax(const std::size_t);
+
+public:
+/*******************************************************************************************
+* @brief Get the current time for measuring a latency
+********************************************************************************************/
+	static LatencyTick now()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+/*******************************************************************************************
+* @brief Record the latency from startTick to now
+*
+* @param[in]			Histogram
+* @param[in]			Start time
+*
+* @details
+* Only the calling thread writes to its shard, so a relaxed load and store is enough.
+* Latencies above FLIGHT_SLOW_HANDLER are also recorded in the flight recorder.
+********************************************************************************************/
+	static void record(const LatencyKind kind, const LatencyTick startTick)
+	{
+		auto elapsed = now() - startTick;
+		if (mThreadShard == nullptr)
+			mThreadShard = mRegisterShard();
+		if (elapsed < 0)
+			elapsed = 0;
+		else if (elapsed >= FLIGHT_SLOW_HANDLER)
+			FlightRecorder::record(FlightEvent::SLOW, elapsed, NAME[(std::size_t)kind]);
+		auto& count = mThreadShard->counts[(std::size_t)kind][mBucket(elapsed)];
+		count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		auto& sum = mThreadShard->sums[(std::size_t)kind];
+		sum.store(sum.load(std::memory_order_relaxed) + elapsed, std::memory_order_relaxed);
+	}
+/*******************************************************************************************
+* @brief Merge the histograms of all threads
+*
+* @param[in]			Histogram
+* @param[out]			Count of each bucket (resized to bucketCount())
+* @return				Sum of the recorded latencies in nanoseconds
+********************************************************************************************/
+	static std::uint64_t merge(const LatencyKind, std::vector<std::uint64_t>&);
+/*******************************************************************************************
+* @brief Get the bucket of a latency (latencies below a power of two are in lower buckets)
+********************************************************************************************/
+	static std::size_t bucket(const std::uint64_t value)
+	{
+		return mBucket(value);
+	}
+/*******************************************************************************************
+* @brief Get the number of buckets in a histogram
+********************************************************************************************/
+	static constexpr std::size_t bucketCount()
+	{
+		return BUCKET_COUNT;
+	}
+/*******************************************************************************************
+* @brief Get the name of a histogram
+********************************************************************************************/
+	static const std::string& name(const LatencyKind);
+/*******************************************************************************************
+* @brief Generate the summary of a histogram
+*
+* @param[in]			Histogram
+* @return				name=count,p50,p90,p99,p999,max (latencies in microseconds)
+********************************************************************************************/
+	static std::string summary(const LatencyKind);
+/*******************************************************************************************
+* @brief Generate the latency string
+*
+* @return				Tab separated histogram summaries
+*
+* @details
+* Each histogram is written as name=count,p50,p90,p99,p999,max (latencies in microseconds).
+********************************************************************************************/
+	static std::string generateReport();
+};
+
+#endif
@@ -1,35 +1,193 @@
 #ifndef LOG_H
 #define LOG_H
 
-#include <mutex>
-#include <fstream>
 #include <atomic>
-#include <iostream>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
 
 #define START_LOG Log::startLog();
 #define STOP_LOG Log::stopLog();
 
 #ifdef PRINT_DEBUG_LOG
-#define DEBUG_LOG(x) x
+#define DEBUG_LOG_AT(category, x) if (!Log::isEnabled(LogLevel::DEBUG, LogCategory::category)) {} else { x }
 #else
-#define DEBUG_LOG(x)
+#define DEBUG_LOG_AT(category, x)
 #endif
 
 #ifdef PRINT_LOG
-#define LOG(x) x
+#define LOG_AT(category, x) if (!Log::isEnabled(LogLevel::CRITICAL, LogCategory::category)) {} else { x }
 #else
-#define LOG(x)
+#define LOG_AT(category, x)
 #endif
 
+#define DEBUG_LOG(x) DEBUG_LOG_AT(GENERAL, x)
+#define LOG(x) LOG_AT(GENERAL, x)
+
+#define LOG_RECORD_SIZE 256					// Size of a log record (longer lines are truncated)
+#define LOG_RING_SIZE 1024					// Number of records buffered per thread (power of two)
+#define LOG_FLUSH_INTERVAL 10				// Milliseconds between the writes of the log writer
+
+/*******************************************************************************************
+* @brief Enum class for the runtime log level of a category
+*
+* @details
+* OFF				Nothing is logged.
+* CRITICAL			Only the critical logs (LOG).
+* DEBUG				Critical and debug logs (LOG and DEBUG_LOG).
+********************************************************************************************/
+enum class LogLevel
+{
+	OFF,
+	CRITICAL,
+	DEBUG
+};
+#define LOG_LEVEL_COUNT 3				// Number of log levels
+
+/*******************************************************************************************
+* @brief Enum class for the subsystem a log line belongs to
+*
+* @details
+* GENERAL			Startup, shutdown, handover and everything else.
+* ACCEPT			Accepting connections and peer life cycle.
+* BG				Broadcast group membership.
+* FANOUT			Message creation and delivery to the peers.
+* UDP				UDP peers.
+* CCM				CCM peers and commands.
+* TLS				TLS handshakes, certificates and ticket keys.
+********************************************************************************************/
+enum class LogCategory
+{
+	GENERAL,
+	ACCEPT,
+	BG,
+	FANOUT,
+	UDP,
+	CCM,
+	TLS
+};
+#define LOG_CATEGORY_COUNT 7			// Number of log categories
+
 class Log
 {
+	static const std::string LEVEL_NAME[];		// Name of each log level
+	static const std::string CATEGORY_NAME[];	// Name of each log category
+	static std::atomic<std::uint32_t> mEnabled;	// Bit per enabled (level, category) pair
+
+/*******************************************************************************************
+* @brief Get the bit of a (level, category) pair in mEnabled
+********************************************************************************************/
+	static constexpr std::uint32_t mBit(const LogLevel level, const LogCategory category)
+	{
+		return std::uint32_t(1) << (((short)level - 1) * LOG_CATEGORY_COUNT + (short)category);
+	}
+	struct Record
+	{
+		std::int64_t time;						// System time of the record in microseconds
+		std::uint16_t size;						// Number of characters in text
+		char text[LOG_RECORD_SIZE - sizeof(std::int64_t) - sizeof(std::uint16_t)];	// Log line (not null terminated)
+	};
+
+	struct Ring
+	{
+		alignas(64) std::atomic<std::uint64_t> head;	// Next record written by the owning thread
+		alignas(64) std::atomic<std::uint64_t> tail;	// Next record read by the log writer
+		alignas(64) std::atomic<std::uint64_t> dropped;	// Records dropped because the ring was full
+		Record records[LOG_RING_SIZE];					// Records waiting to be written
+	};
+
+	inline static thread_local Ring* mThreadRing = nullptr;	// Ring of the calling thread
+	static std::vector<std::unique_ptr<Ring>> mRings;	// Rings of all threads that logged
+	static std::mutex mRingLock;				// Mutex for registering a new ring
+	static std::atomic_bool mCanLog;			// True if needs logs
+	static std::atomic_bool mWriterRunning;		// True while the log writer should keep running
+	static std::thread mWriter;					// Thread writing the records to the log file
+	static std::FILE* mLogFile;					// Log file
+	static std::atomic<std::uint64_t> mDropCount;	// Total number of dropped records (reported)
+
+/*******************************************************************************************
+* @brief Create and register the ring of the calling thread
+********************************************************************************************/
+	static Ring* mRegisterRing();
+/*******************************************************************************************
+* @brief Write the buffered records of all threads to the log file (in time order)
+*
+* @param[in,out]	Reused record batch
+* @param[in,out]	Reused output buffer
+* @return			True if any record was written
+*
+* @details
+* Runs only on the log writer thread (or after it stopped).
+********************************************************************************************/
+	static bool mDrain(std::vector<Record>&, std::string&);
+/*******************************************************************************************
+* @brief Log writer thread, drain the rings every LOG_FLUSH_INTERVAL milliseconds
+********************************************************************************************/
+	static void mWriterRoutine();
+
+/*******************************************************************************************
+* @brief Append a value to the record text (truncated at the end of the record)
+********************************************************************************************/
+	static void mAppend(Record& record, const std::string_view& text)
+	{
+		auto size = std::min(text.size(), sizeof(record.text) - record.size);
+		std::memcpy(record.text + record.size, text.data(), size);
+		record.size += (std::uint16_t)size;
+	}
+	static void mAppend(Record& record, const char* text)
+	{
+		mAppend(record, std::string_view(text != nullptr ? text : "(null)"));
+	}
+	static void mAppend(Record& record, const std::string& text)
+	{
+		mAppend(record, std::string_view(text));
+	}
+	static void mAppend(Record& record, const char character)
+	{
+		mAppend(record, std::string_view(&character, 1));
+	}
+	static void mAppend(Record& record, const bool value)
+	{
+		mAppend(record, std::string_view(value ? "1" : "0"));
+	}
+	template<typename T>
+	static std::enable_if_t<std::is_arithmetic_v<T>> mAppend(Record& record, const T value)
+	{
+		char valueStr[32];
+		if constexpr (std::is_integral_v<T>)
+		{
+			auto result = std::to_chars(valueStr, valueStr + sizeof(valueStr), value);
+			mAppend(record, std::string_view(valueStr, result.ptr - valueStr));
+		}
+		else
+		{
+			auto size = std::snprintf(valueStr, sizeof(valueStr), "%g", (double)value);
+			mAppend(record, std::string_view(valueStr, size));
+		}
+	}
+
 public:
 /*******************************************************************************************
 * @brief Enable logging
+*
+* @details
+* Open log.txt and start the log writer thread.
 ********************************************************************************************/
     static void startLog();
 /*******************************************************************************************
 * @brief Disable Logging
+*
+* @details
+* Stop the log writer after writing the buffered records.
 ********************************************************************************************/
     static void stopLog();
 /*******************************************************************************************
@@ -39,35 +197,76 @@ public:
 ********************************************************************************************/
     static bool isLogging();
 /*******************************************************************************************
+* @brief Check if a log level is enabled for a category
+*
+* @param[in]        Level
+* @param[in]        Category
+*
+* @return           True if the lines of the level should be logged
+*
+* @details
+* One relaxed atomic load, the LOG_AT and DEBUG_LOG_AT macros skip formatting the
+* arguments when it is false.
+********************************************************************************************/
+    static bool isEnabled(const LogLevel level, const LogCategory category)
+    {
+        return (mEnabled.load(std::memory_order_relaxed) & mBit(level, category)) != 0;
+    }
+/*******************************************************************************************
+* @brief Set the log level of a category, or of all categories
+*
+* @param[in]        Level name (off, critical, debug)
+* @param[in]        Category name (general, accept, bg, fanout, udp, ccm, tls), empty for all
+*
+* @return           False if the level or category is unknown
+********************************************************************************************/
+    static bool setLevel(const std::string_view&, const std::string_view&);
+/*******************************************************************************************
+* @brief Generate the log level of every category
+*
+* @return           Tab separated category=level list
+********************************************************************************************/
+    static std::string generateLevels();
+/*******************************************************************************************
+* @brief Get the number of log records dropped because a thread's ring was full
+********************************************************************************************/
+    static std::uint64_t droppedCount();
+/*******************************************************************************************
 * @brief Print the message
 *
 * @param[in]        Message
+*
+* @details
+* The line is formatted into a record in the calling thread's ring (no lock, no syscall).
+* The record is dropped and counted if the ring is full.
 ********************************************************************************************/
     template<typename T, typename... Args>
-    static void log(T, Args...);
-
-private:
-    static std::atomic_bool mCanLog;            // True if needs logs
-    static std::mutex mWriteLock;               // Mutex for thread safety
-    static std::ofstream mLogFile;              // Log file stream
+    static void log(const T&, const Args&...);
 };
 
 template<typename T, typename... Args>
-inline void Log::log(T message, Args... messages)
+inline void Log::log(const T& message, const Args&... messages)
 {
-    std::lock_guard<std::mutex> lock(mWriteLock);
-    if (mCanLog)
+    if (!mCanLog.load(std::memory_order_relaxed))
+        return;
+    if (mThreadRing == nullptr)
+        mThreadRing = mRegisterRing();
+
+    auto& ring = *mThreadRing;
+    auto head = ring.head.load(std::memory_order_relaxed);
+    if (head - ring.tail.load(std::memory_order_acquire) >= LOG_RING_SIZE)
     {
-        mLogFile << message;
-        (mLogFile << ... << std::forward<Args>(messages));
-        mLogFile << std::endl;
-
-        #ifdef PRINT_DEBUG_LOG
-        std::cerr << message;
-        (std::cerr << ... << std::forward<Args>(messages));
-        std::cerr << std::endl;
-        #endif
+        ring.dropped.store(ring.dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return;
     }
+
+    auto& record = ring.records[head & (LOG_RING_SIZE - 1)];
+    record.time = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    record.size = 0;
+    mAppend(record, message);
+    (mAppend(record, messages), ...);
+    ring.head.store(head + 1, std::memory_order_release);
 }
 
-#endif
\ No newline at end of file
+#endif
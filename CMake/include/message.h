@@ -6,6 +6,10 @@
 #include <mutex>
 #include <asio/buffer.hpp>
 #include "common.h"
+#include "metrics.h"
+#include "latency.h"
+#include "flight_recorder.h"
+#include "trace.h"
 
 typedef std::chrono::time_point<std::chrono::system_clock> TimePoint;
 
@@ -34,6 +38,7 @@ class Message
 	Message(const MessageStr& mssgStr, const BGTstr& rTag, const PeerType& pType)
 	{
 		mCreatedTime = std::chrono::system_clock::now();
+		createdTick = Latency::now();
 		messageBuf = mssgStr;
 		peerType = pType;
 		recverTag = rTag;
@@ -45,6 +50,7 @@ public:
 	BGT recverTag;								// Receivers tag
 	PeerType peerType;							// Type of peer generating this message
 	asio::mutable_buffer asioBuffer;
+	LatencyTick createdTick;					// Message created time (for the fanout latency)
 /*******************************************************************************************
 * @brief Return true if the message have expired
 *
@@ -74,13 +80,17 @@ public:
 		addMssg += "\t" + sapStr + "\n";
 		auto message = new (std::nothrow) Message(addMssg, rTag, pType);
 		if (message == nullptr)
-				return nullptr;
+		{
+			Metrics::add(Metric::MESSAGE_FAILS);
+			FlightRecorder::record(FlightEvent::DROP, 0, "message allocation");
+			return nullptr;
+		}
 		else
 		{
 			if (!insertMssg2Q(message))
 				return nullptr;
-			else
-				return message;
+			RTDS_TRACE3(message_create, message, message->messageBuf.size(), (int)pType);
+			return message;
 		}
 	}
 /*******************************************************************************************
@@ -104,13 +114,17 @@ public:
 		remMssg += "\t" + sapStr + "\n";
 		auto message = new (std::nothrow) Message(remMssg, rTag, pType);
 		if (message == nullptr)
-				return nullptr;
+		{
+			Metrics::add(Metric::MESSAGE_FAILS);
+			FlightRecorder::record(FlightEvent::DROP, 0, "message allocation");
+			return nullptr;
+		}
 		else
 		{
 			if (!insertMssg2Q(message))
 				return nullptr;
-			else
-				return message;
+			RTDS_TRACE3(message_create, message, message->messageBuf.size(), (int)pType);
+			return message;
 		}
 	}
 /*******************************************************************************************
@@ -139,13 +153,17 @@ public:
 
 		auto message = new (std::nothrow) Message(brdMssg, rTag, pType);
 		if (message == nullptr)
+		{
+			Metrics::add(Metric::MESSAGE_FAILS);
+			FlightRecorder::record(FlightEvent::DROP, 0, "message allocation");
 			return nullptr;
+		}
 		else
 		{
 			if (!insertMssg2Q(message))
 				return nullptr;
-			else
-				return message;
+			RTDS_TRACE3(message_create, message, message->messageBuf.size(), (int)pType);
+			return message;
 		}
 	}
 /*******************************************************************************************
@@ -172,13 +190,17 @@ public:
 
 		auto message = new (std::nothrow) Message(brdMssg, rTag, pType);
 		if (message == nullptr)
+		{
+			Metrics::add(Metric::MESSAGE_FAILS);
+			FlightRecorder::record(FlightEvent::DROP, 0, "message allocation");
 			return nullptr;
+		}
 		else
 		{
 			if (!insertMssg2Q(message))
 				return nullptr;
-			else
-				return message;
+			RTDS_TRACE3(message_create, message, message->messageBuf.size(), (int)pType);
+			return message;
 		}
 	}
 /*******************************************************************************************
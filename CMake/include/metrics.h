@@ -0,0 +1,183 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "common.h"
+
+#define METRICS_CACHE_LINE 64			// Size of a cache line (shards never share a line)
+
+/*******************************************************************************************
+* @brief Enum class for the source of a command
+*
+* @details
+* TCP				TCP peer
+* UDP				UDP peer
+* SSL				SSL peer
+* CCM				CCM peer
+********************************************************************************************/
+enum class MetricSource
+{
+	TCP,
+	UDP,
+	SSL,
+	CCM
+};
+#define METRIC_SOURCE_COUNT 4
+
+/*******************************************************************************************
+* @brief Enum class for the counters and gauges
+*
+* @details
+* MESSAGES			Messages created (broadcast, message, join and leave notifications)
+* MESSAGE_FAILS		Messages that could not be created (peer got WAIT_RETRY)
+* DELIVERIES		Messages queued to a peer
+* DELIVERY_FAILS	Failed message writes (the peer connection is lost)
+* BYTES_IN			Bytes received from peers
+* BYTES_OUT			Bytes sent to peers (responses and messages)
+* SHED_COMMANDS		Commands answered with WAIT_RETRY while shedding load
+* SHED_ACCEPTS		Times the TCP or SSL accept routine paused while shedding load
+* QUOTA_REJECTS		Connections closed at accept (source at its connection limit)
+* RATE_REJECTS		Connections closed at accept (source over its connect rate)
+* QUOTA_EVICTIONS	Sources with open connections evicted from the full source table
+* HANDSHAKE_TIMEOUTS	TLS handshakes closed after HANDSHAKE_TIMEOUT seconds
+* UDP_PING_LIMITED	UDP commands dropped (source over its ping rate)
+* UDP_FANOUT_LIMITED	UDP broadcasts and messages dropped (source over its fanout rate)
+* BG_COUNT			[Gauge] Number of broadcast groups
+* BG_MEMBERS		[Gauge] Number of peers in broadcast groups
+* PENDING_DELIVERIES	[Gauge] Messages queued to peers and not yet written
+********************************************************************************************/
+enum class Metric
+{
+	MESSAGES,
+	MESSAGE_FAILS,
+	DELIVERIES,
+	DELIVERY_FAILS,
+	BYTES_IN,
+	BYTES_OUT,
+	SHED_COMMANDS,
+	SHED_ACCEPTS,
+	QUOTA_REJECTS,
+	RATE_REJECTS,
+	QUOTA_EVICTIONS,
+	HANDSHAKE_TIMEOUTS,
+	UDP_PING_LIMITED,
+	UDP_FANOUT_LIMITED,
+	BG_COUNT,
+	BG_MEMBERS,
+	PENDING_DELIVERIES
+};
+#define METRIC_COUNT 17
+
+class Metrics
+{
+	static constexpr std::size_t COMMAND_SLOTS = COMMAND_COUNT + 1;		// All commands and the unknown commands
+	static constexpr std::size_t VALUE_COUNT = METRIC_COUNT + METRIC_SOURCE_COUNT * COMMAND_SLOTS;
+
+	struct alignas(METRICS_CACHE_LINE) Shard
+	{
+		std::atomic<std::int64_t> values[VALUE_COUNT];	// Written only by the owning thread
+	};
+
+	inline static thread_local Shard* mThreadShard = nullptr;	// Shard of the calling thread
+	static std::vector<Shard*> mShards;				// Shards of all threads that updated a value
+	static std::mutex mShardLock;					// Mutex for registering a new shard
+	static const std::string NAME[];				// Name of the metrics
+	static const std::string SOURCE[];				// Name of the command sources
+
+/*******************************************************************************************
+* @brief Create and register the shard of the calling thread
+********************************************************************************************/
+	static Shard* mRegisterShard();
+/*******************************************************************************************
+* @brief Add to a value in the shard of the calling thread
+*
+* @param[in]			Index of the value
+* @param[in]			Amount to add
+*
+* @details
+* Only the owning thread writes to a shard, so a relaxed load and store is enough
+* (no locked instruction and no cache line shared with other writers).
+********************************************************************************************/
+	static void mAdd(const std::size_t index, const std::int64_t amount)
+	{
+		if (mThreadShard == nullptr)
+			mThreadShard = mRegisterShard();
+		auto& value = mThreadShard->values[index];
+		value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+	}
+/*******************************************************************************************
+* @brief Sum a value over all shards
+*
+* @param[in]			Index of the value
+* @return				Aggregated value
+********************************************************************************************/
+	static std::int64_t mSum(const std::size_t);
+
+public:
+/*******************************************************************************************
+* @brief Add to a counter or gauge
+*
+* @param[in]			Metric
+* @param[in]			Amount (negative to decrease a gauge)
+********************************************************************************************/
+	static void add(const Metric metric, const std::int64_t amount = 1)
+	{
+		mAdd((std::size_t)metric, amount);
+	}
+/*******************************************************************************************
+* @brief Count a received command
+*
+* @param[in]			Source of the command
+* @param[in]			Index of the command (COMMAND_COUNT for unknown commands)
+********************************************************************************************/
+	static void countCommand(const MetricSource source, const short command)
+	{
+		mAdd(commandIndex(source, command), 1);
+	}
+/*******************************************************************************************
+* @brief Get the aggregated value of a counter or gauge
+********************************************************************************************/
+	static std::int64_t value(const Metric);
+/*******************************************************************************************
+* @brief Get the aggregated values of all counters, gauges and commands (one lock)
+*
+* @param[out]			Values, indexed by Metric and then by commandIndex()
+********************************************************************************************/
+	static void snapshot(std::vector<std::int64_t>&);
+/*******************************************************************************************
+* @brief Get the index of a command count in the snapshot
+********************************************************************************************/
+	static constexpr std::size_t commandIndex(const MetricSource source, const short command)
+	{
+		return METRIC_COUNT + (std::size_t)source * COMMAND_SLOTS + command;
+	}
+/*******************************************************************************************
+* @brief Return true if the metric is a gauge (else a counter)
+********************************************************************************************/
+	static bool isGauge(const Metric);
+/*******************************************************************************************
+* @brief Get the name of a metric / command source
+********************************************************************************************/
+	static const std::string& name(const Metric);
+	static const std::string& name(const MetricSource);
+/*******************************************************************************************
+* @brief Get the aggregated count of a command
+********************************************************************************************/
+	static std::int64_t commandCount(const MetricSource, const short);
+/*******************************************************************************************
+* @brief Generate the stats string
+*
+* @return				Tab separated name=value pairs
+*
+* @details
+* Commands are named source_command (unknown commands as source_unknown).
+* Commands that were never received are left out.
+********************************************************************************************/
+	static std::string generateStats();
+};
+
+#endif
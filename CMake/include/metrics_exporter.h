@@ -0,0 +1,95 @@
+#ifndef METRICS_EXPORTER_H
+#define METRICS_EXPORTER_H
+
+#include <asio/ip/tcp.hpp>
+#include <asio/steady_timer.hpp>
+#include <asio/strand.hpp>
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define EXPORTER_REQUEST_SIZE 2048			// Maximum size of a scrape request header
+#define EXPORTER_TIMEOUT 5					// Seconds a scrape connection may stay open
+#define EXPORTER_FIRST_BUCKET 10			// Smallest histogram bucket bound exported (2^10 ns, about 1 us)
+#define EXPORTER_LAST_BUCKET 34				// Largest histogram bucket bound exported (2^34 ns, about 17 s)
+
+class MetricsExporter
+{
+	asio::strand<asio::io_context::executor_type> mStrand;	// Serializes the exporter handlers
+	asio::ip::tcp::acceptor mAcceptor;			// Acceptor for the scrape connections
+	asio::ip::tcp::socket mSocket;				// Scrape connection being served (one at a time)
+	asio::steady_timer mDeadline;				// Closes a scrape connection that takes too long
+	bool mIsRunning;							// True if the exporter is accepting connections
+
+	std::array<char, EXPORTER_REQUEST_SIZE> mRequest;	// Request header received
+	std::size_t mRequestSize;					// Number of bytes in mRequest
+	std::string mHeader;						// Response header (reused by every scrape)
+	std::string mBody;							// Response body (reused by every scrape)
+
+	std::vector<std::string> mValueLines;		// Name and labels of each metrics value (built once)
+	std::vector<std::string> mBucketLabels;		// le label of each exported histogram bucket (built once)
+	std::vector<std::int64_t> mValues;			// Snapshot of the metrics values (reused)
+	std::vector<std::uint64_t> mBuckets;		// Merged histogram buckets (reused)
+
+/*******************************************************************************************
+* @brief Build the name and labels of all exported values
+********************************************************************************************/
+	void mBuildLines();
+/*******************************************************************************************
+* @brief Render all counters, gauges and histograms in Prometheus text format to mBody
+*
+* @details
+* Values are appended to the reused buffers, so a scrape does not allocate per metric.
+********************************************************************************************/
+	void mRender();
+/*******************************************************************************************
+* @brief Append a number to the response body
+********************************************************************************************/
+	void mAppend(const std::int64_t);
+	void mAppend(const double);
+
+	void mAccept();
+	void mAcceptFeedbk(const asio::error_code&);
+	void mReadRequest();
+/*******************************************************************************************
+* @brief The callback function for getting request data
+*
+* @param[in] ec					Asio error code
+* @param[in] size				Number of bytes received
+*
+* @details
+* Read until the end of the request header, then send the metrics (GET /metrics) or 404.
+********************************************************************************************/
+	void mReadFeedbk(const asio::error_code&, std::size_t);
+	void mWriteFeedbk(const asio::error_code&);
+	void mDeadlineFeedbk(const asio::error_code&);
+/*******************************************************************************************
+* @brief Close the scrape connection and accept the next one
+********************************************************************************************/
+	void mFinish();
+
+public:
+/*******************************************************************************************
+* @brief Create the exporter on the ioContext (not listening)
+*
+* @param[in]			ioContext
+********************************************************************************************/
+	MetricsExporter(asio::io_context&);
+/*******************************************************************************************
+* @brief Start serving the metrics at the endpoint
+*
+* @param[in]			Endpoint of the HTTP listener
+*
+* @details
+* SO_REUSEPORT is set where available, so a new RTDS taking over the listeners can bind the
+* port while the old one drains. Throws asio::error_code on failure.
+********************************************************************************************/
+	void start(const asio::ip::tcp::endpoint&);
+/*******************************************************************************************
+* @brief Stop accepting and close the exporter sockets
+********************************************************************************************/
+	void stop();
+};
+
+#endif
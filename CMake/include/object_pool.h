@@ -0,0 +1,113 @@
+#ifndef OBJECT_POOL_H
+#define OBJECT_POOL_H
+
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+template<typename T>
+class ObjectPool
+{
+	static constexpr std::size_t SLOT_SIZE = (sizeof(T) + alignof(T) - 1) / alignof(T) * alignof(T);
+
+	inline static std::vector<void*> mFreeSlots;		// Free storage slots for T
+	inline static std::size_t mSlotCount = 0;			// Number of slots owned by the pool
+	inline static std::mutex mPoolLock;					// Mutex for thread safety
+
+public:
+/*******************************************************************************************
+* @brief Preallocate storage for objects in a single block
+*
+* @param[in]			Number of objects
+*
+* @details
+* The block is prefaulted so that the first accepts do not page fault.
+* Throws std::bad_alloc on failure.
+********************************************************************************************/
+	static void warmUp(std::size_t objectCount)
+	{
+		if (objectCount == 0)
+			return;
+		auto slotBlock = static_cast<char*>(::operator new(SLOT_SIZE * objectCount));
+		std::memset(slotBlock, 0, SLOT_SIZE * objectCount);
+
+		std::lock_guard<std::mutex> lock(mPoolLock);
+		mSlotCount += objectCount;
+		mFreeSlots.reserve(mSlotCount);
+		for (std::size_t index = 0; index < objectCount; index++)
+			mFreeSlots.push_back(slotBlock + SLOT_SIZE * index);
+	}
+/*******************************************************************************************
+* @brief Get storage for one object
+*
+* @return				Pointer to the storage
+*
+* @details
+* Allocate a new slot if the pool is empty (throws std::bad_alloc on failure).
+* Room for the new slot is reserved in the free list, so deallocate() never allocates.
+********************************************************************************************/
+	static void* allocate()
+	{
+		std::lock_guard<std::mutex> lock(mPoolLock);
+		if (!mFreeSlots.empty())
+		{
+			auto slot = mFreeSlots.back();
+			mFreeSlots.pop_back();
+			return slot;
+		}
+
+		if (mFreeSlots.capacity() <= mSlotCount)
+			mFreeSlots.reserve(2 * mSlotCount + 1);
+		auto slot = ::operator new(SLOT_SIZE);
+		mSlotCount++;
+		return slot;
+	}
+/*******************************************************************************************
+* @brief Return the storage of an object to the pool
+*
+* @param[in]			Pointer to the storage
+*
+* @details
+* Slots are never returned to the heap, the pool stays at its high-water mark.
+********************************************************************************************/
+	static void deallocate(void* slot) noexcept
+	{
+		std::lock_guard<std::mutex> lock(mPoolLock);
+		mFreeSlots.push_back(slot);
+	}
+/*******************************************************************************************
+* @brief Construct an object in pooled storage
+*
+* @param[in]			Constructor arguments
+* @return				Pointer to the object
+********************************************************************************************/
+	template<typename... Args>
+	static T* construct(Args&&... args)
+	{
+		auto slot = allocate();
+		try {
+			return new (slot) T(std::forward<Args>(args)...);
+		}
+		catch (...)
+		{
+			deallocate(slot);
+			throw;
+		}
+	}
+/*******************************************************************************************
+* @brief Destroy an object and return its storage to the pool
+*
+* @param[in]			Pointer to the object (constructed with construct())
+********************************************************************************************/
+	static void destroy(T* object)
+	{
+		if (object == nullptr)
+			return;
+		object->~T();
+		deallocate(object);
+	}
+};
+
+#endif
@@ -4,6 +4,19 @@
 #include <asio/ip/tcp.hpp>
 #include <asio/ip/udp.hpp>
 #include <asio/ssl.hpp>
+#include <asio/steady_timer.hpp>
+#include <asio/strand.hpp>
+#include <asio/thread_pool.hpp>
+#include <asio/bind_executor.hpp>
+#include <array>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include "handover.h"
+#include "ktls.h"
+#include "metrics.h"
+#include "metrics_exporter.h"
+#include "rtds_settings.h"
 typedef asio::ssl::stream<asio::ip::tcp::socket> SSLsocket;
 
 class RTDS
@@ -17,49 +30,244 @@ class RTDS
 	asio::ip::udp::endpoint mUDPep;				// UDP endpoint that describe the IPaddr ,Port and Protocol for the socket
 	asio::ip::udp::socket mUDPsock;				// UDP socket that accept packets
 	
-	asio::ssl::context mCCMcontext;				// CCM context
 	asio::ip::tcp::endpoint mCCMep;				// SSL endpoint that describe the IPaddr ,Port and Protocol for the acceptor socket
 	asio::ip::tcp::acceptor mCCMacceptor;		// SSL acceptor socket that accept incoming tcp connections	
 
-	asio::ssl::context mSSLcontext;				// SSL context
 	asio::ip::tcp::endpoint mSSLep;				// SSL endpoint that describe the IPaddr ,Port and Protocol for the acceptor socket
 	asio::ip::tcp::acceptor mSSLacceptor;		// SSL acceptor socket that accept incoming tcp connections	
 
+	unsigned short mMetricsPort;				// Port of the metrics HTTP listener (0 if disabled)
+	std::string mMetricsAddress;				// Address of the metrics HTTP listener
+	MetricsExporter mMetricsExporter;			// Serves the metrics in Prometheus text format
+
+	asio::thread_pool mHandshakePool;			// Threads doing the TLS handshakes, away from the ioContext threads
+	std::atomic_int mPendingSSLhandshakes;		// Number of SSL handshakes in progress
+	std::atomic_int mPendingCCMhandshakes;		// Number of CCM handshakes in progress
+	std::mutex mAcceptLock;						// Mutex for the accept routines waiting to accept
+	std::condition_variable mAcceptCondition;	// Signalled when a handshake slot frees, shedding stops or the server stops
+
 	int mThreadCount;							// Keep account of number of threads running ioContex.run()
 	std::atomic_bool mServerRunning;			// True if the server is running
 
+	std::string mHandoverPath;					// Unix socket path for listening socket handover
+	ListenerFDs mInheritedFDs;					// Listening sockets taken over from the previous RTDS
+#ifdef RTDS_HANDOVER
+	std::mutex mListenerLock;					// Mutex for the listener thread handles
+	std::array<pthread_t, LISTENER_COUNT> mListenerThreads;	// Thread running the accept / receive routine of each listener
+	std::array<bool, LISTENER_COUNT> mListenerRunning;		// True while the routine of the listener runs
+#endif
+
+/*******************************************************************************************
+* @brief Load the SSL and CCM contexts (exit on failure)
+********************************************************************************************/
+	void mConfigTLScontexts();
 	void mConfigTCPserver();
 	void mConfigUDPserver();
 	void mConfigCCMserver();
 	void mConfigSSLserver();
+/*******************************************************************************************
+* @brief Start the metrics HTTP listener if a metrics port is set
+********************************************************************************************/
+	void mConfigMetricsServer();
 	
 	void mIOthreadJob();
 	void mAddthread(const int);
+/*******************************************************************************************
+* @brief Preallocate the pooled peer and socket objects
+*
+* @param[in]		Number of objects to preallocate for each pool
+********************************************************************************************/
+	void mWarmPools(const unsigned int);
 
 	void mTCPacceptRoutine();
 	void mUDPlistenRoutine();
 	void mCCMacceptRoutine();
 	void mSSLacceptRoutine();
+/*******************************************************************************************
+* @brief Reload the SSL and CCM contexts when the certificate or DH file changes
+*
+* @details
+* Check the files every TLS_WATCH_INTERVAL seconds while the server is running.
+********************************************************************************************/
+	void mTLSwatchRoutine();
+/*******************************************************************************************
+* @brief Probe the event loop lag every IO_PROBE_INTERVAL milliseconds
+*
+* @details
+* The admission control is updated with the lag and the queued deliveries before each probe.
+********************************************************************************************/
+	void mIOprobeRoutine();
 
-	void mSSLhandshakeHandler(const asio::error_code&, SSLsocket*);
-	void mCCMhandshakeHandler(const asio::error_code&, SSLsocket*);
+/*******************************************************************************************
+* @brief Block the accept routine while the maximum number of handshakes are in progress
+*
+* @param[in]		Handshakes in progress on the listener
+* @param[in]		Maximum handshakes in progress (MAX_PENDING_HANDSHAKES / MAX_PENDING_CCM_HANDSHAKES)
+*
+* @details
+* New connections wait in the listen backlog instead of queuing up on the handshake pool.
+* SSL and CCM have separate budgets, so an SSL handshake storm cannot lock out the CCM.
+* The thread sleeps on mAcceptCondition until a handshake completes (no polling).
+********************************************************************************************/
+	void mWaitForHandshakeSlot(const std::atomic_int&, const int);
+/*******************************************************************************************
+* @brief Block the accept routine while shedding load (see Admission)
+*
+* @details
+* The thread sleeps on mAcceptCondition until a probe finds that shedding stopped.
+********************************************************************************************/
+	void mWaitForAdmission();
+/*******************************************************************************************
+* @brief Wake the accept routines waiting in mWaitForHandshakeSlot / mWaitForAdmission
+********************************************************************************************/
+	void mWakeAcceptRoutines();
+/*******************************************************************************************
+* @brief Count an accepted connection in the ConnectionQuota of its source
+*
+* @param[in]		Listener that accepted the connection
+* @param[in]		Accepted socket
+* @return			Slot of the source, or QUOTA_REJECTED if the socket has to be closed
+********************************************************************************************/
+	std::uint32_t mAcquireQuota(const Listener, asio::ip::tcp::socket&);
+/*******************************************************************************************
+* @brief Start the server side handshake on the handshake pool
+*
+* @param[in]		SSL socket with an accepted connection
+* @param[in]		Handshakes in progress on the listener (decremented before the handler runs)
+* @param[in]		Handshake handler (runs on the handshake pool)
+*
+* @details
+* The handler is bound to a strand of the handshake pool, so the TLS key exchange done while
+* the handshake progresses never runs on the ioContext threads. A deadline timer on the same
+* strand closes the socket if the handshake takes more than HANDSHAKE_TIMEOUT seconds, and
+* the handler then gets the error.
+********************************************************************************************/
+	template<typename HandshakeHandler>
+	void mStartHandshake(SSLsocket* peerSocket, std::atomic_int& pendingCount, HandshakeHandler handler)
+	{
+		struct Deadline
+		{
+			asio::steady_timer timer;		// Expires HANDSHAKE_TIMEOUT seconds after the accept
+			bool isDone;					// True once the handshake handler ran
+			Deadline(const asio::strand<asio::thread_pool::executor_type>& strand) : timer(strand), isDone(false) {}
+		};
+
+		pendingCount++;
+		auto strand = asio::make_strand(mHandshakePool);
+		auto deadline = std::make_shared<Deadline>(strand);
+		deadline->timer.expires_after(std::chrono::seconds(HANDSHAKE_TIMEOUT));
+		deadline->timer.async_wait(asio::bind_executor(strand, [peerSocket, deadline](const asio::error_code& ec)
+		{
+			if (ec || deadline->isDone)
+				return;
+			Metrics::add(Metric::HANDSHAKE_TIMEOUTS);
+			asio::error_code closeEc;
+			peerSocket->lowest_layer().close(closeEc);
+		}));
+		auto handshakeHandler = [this, &pendingCount, deadline, handler](const asio::error_code& ec)
+		{
+			deadline->isDone = true;
+			deadline->timer.cancel();
+			pendingCount--;
+			mWakeAcceptRoutines();
+			handler(ec);
+		};
+#ifdef RTDS_KTLS
+		KernelTLS::handshake(*peerSocket, strand, handshakeHandler);
+#else
+		peerSocket->async_handshake(asio::ssl::stream_base::server, asio::bind_executor(strand, handshakeHandler));
+#endif
+	}
+
+	void mSSLhandshakeHandler(const asio::error_code&, SSLsocket*, const std::uint32_t);
+	void mCCMhandshakeHandler(const asio::error_code&, SSLsocket*, const std::uint32_t);
+/*******************************************************************************************
+* @brief Create the peer for a socket that finished the handshake (runs on the ioContext)
+*
+* @param[in]		SSL socket
+* @param[in]		Slot of the source in the ConnectionQuota
+********************************************************************************************/
+	void mMakeSSLpeer(SSLsocket*, const std::uint32_t);
+	void mMakeCCMpeer(SSLsocket*, const std::uint32_t);
 
 	void mStartServer();
+/*******************************************************************************************
+* @brief Stop the listeners and close the listening sockets
+*
+* @details
+* The listener threads are woken (see mWakeListeners) before the sockets are closed, so
+* no thread is left blocked on a closed (and possibly reused) descriptor.
+********************************************************************************************/
 	void mStopServer();
+/*******************************************************************************************
+* @brief Register / unregister the calling thread as the routine of a listener
+*
+* @param[in]		Listener
+********************************************************************************************/
+	void mEnterListener(const Listener);
+	void mLeaveListener(const Listener);
+/*******************************************************************************************
+* @brief Interrupt the listener threads until their routines return
+*
+* @details
+* Signal the threads with HANDOVER_WAKE_SIGNAL every 10 ms (at most HANDOVER_WAKE_ATTEMPTS
+* times), so that a thread blocked in accept or receive sees that the server stopped
+* instead of taking one more connection from the sockets handed over. Nop on platforms
+* without handover.
+********************************************************************************************/
+	void mWakeListeners();
+
+/*******************************************************************************************
+* @brief Take over the listening sockets from the RTDS running at the handover path
+*
+* @details
+* The inherited sockets are used instead of binding new ones.
+* Handover is skipped if no handover path is set or no RTDS is running at the path.
+********************************************************************************************/
+	void mTakeOverListeners();
+/*******************************************************************************************
+* @brief Hand over the listening sockets to a new RTDS and drain the existing peers
+*
+* @details
+* Stop accepting after the handover and abort once all the peers are disconnected
+* (or MAX_DRAIN_TIME is reached).
+* The peers are not handed over: while draining, the old and the new RTDS each hold part of
+* the members of a BG, and broadcasts and messages do not cross between the two processes.
+* MAX_DRAIN_TIME is kept short to bound that split; the peers left are disconnected at the
+* abort and reconnect to the new RTDS.
+********************************************************************************************/
+	void mHandoverRoutine();
+/*******************************************************************************************
+* @brief Use the inherited listening socket (if any) for the acceptor / socket
+*
+* @param[in]		Acceptor or socket
+* @param[in]		Endpoint of the acceptor or socket
+* @param[in]		Listener type
+* @return			True if the inherited socket is assigned
+********************************************************************************************/
+	template<typename ASIOsocket, typename ASIOep>
+	bool mInheritListener(ASIOsocket& listener, const ASIOep& endpoint, const Listener type)
+	{
+		auto listenerFD = mInheritedFDs[(short)type];
+		if (listenerFD == -1)
+			return false;
+		listener.assign(endpoint.protocol(), listenerFD);
+		return true;
+	}
 
 public:
 /*******************************************************************************************
 * @brief Create the server object with it's own ioContext and worker class object
 *
-* @param[in]		The default port is 389
-* @param[in]		Number of threads to run the RTDS with [2-28]
+* @param[in]		Server configuration (ports, threads, pools and limits, see ServerConfig)
 *
 * @details
 * All the STL containers associated with this class are static in nature.
 * Add #define RTDS_DUAL_STACK in RTDS.h to compile the RTDS in IPv6 dual stack mode.
 * Start the logging system.
+* If an RTDS is running at the handover path, its listening sockets are taken over.
 ********************************************************************************************/
-	RTDS(const unsigned short, const unsigned short, short);
+	explicit RTDS(const ServerConfig&);
 	~RTDS();
 };
 
@@ -4,12 +4,46 @@
 #define RTDS_PORT Settings::mRTDSportNo
 #define RTDS_CCM Settings::mRTDSccmPortNo
 #define RTDS_START_THREAD Settings::mRTDSthreadCount
+#define RTDS_CONFIG Settings::serverConfig()
 #define NEED_TO_ABORT Settings::mNeedToAbort
 #define SIGNAL_ABORT Settings::mNeedToAbort = true;
 
+#include <atomic>
+#include <mutex>
 #include <string>
+#include <utility>
+#include <vector>
+/*******************************************************************************************
+* @brief Startup configuration of the RTDS server (see Settings::serverConfig)
+********************************************************************************************/
+struct ServerConfig
+{
+	unsigned short portNumber;					// TCP and UDP port number (SSL uses the next one)
+	unsigned short ccmPort;						// CCM port number
+	short threadCount;							// Number of IO threads to start
+	std::string handoverPath;					// Unix socket path for listening socket handover (empty to disable)
+	unsigned int warmPoolSize;					// Number of preallocated peers and sockets
+	unsigned short metricsPort;					// Port of the metrics HTTP listener (0 to disable)
+	std::string metricsAddress;					// Address of the metrics HTTP listener
+	std::string capturePath;					// Path of the command capture file (empty to disable)
+	unsigned int maxLoopLag;					// Event loop lag in ms above which load is shed (0 to disable)
+	unsigned int maxPending;					// Queued deliveries above which load is shed (0 to disable)
+	unsigned int maxSourceConnections;			// Open connections allowed per source and listener (0 to disable)
+	unsigned int sourceConnectRate;				// Connects per second allowed per source and listener (0 to disable)
+	unsigned int udpPingRate;					// UDP pings per second allowed per source (0 to disable)
+	unsigned int udpFanoutRate;					// UDP broadcasts and messages per second allowed per source (0 to disable)
+};
+
 class Settings
 {
+	struct Option
+	{
+		std::string key;						// Key in the configuration file
+		char flag;								// Argument the value is passed to
+	};
+
+	static const Option OPTION[];				// Configuration keys of the arguments
+	static std::mutex mReloadLock;				// Mutex serializing the reloads of the configuration file
 /*******************************************************************************************
 * @brief Find port number.
 *
@@ -20,6 +54,16 @@ class Settings
 ********************************************************************************************/
 	static void mFindPortNumber(std::string);
 	static void mFindccmPortNumber(std::string);
+	static void mFindMetricsPortNumber(std::string);
+/*******************************************************************************************
+* @brief Find metrics address.
+*
+* @param[in]		IPv4 or IPv6 address as string
+*
+* @details
+* std::err will display the error in argument and exit if the arguments are incorrect.
+********************************************************************************************/
+	static void mFindMetricsAddress(std::string);
 /*******************************************************************************************
 * @brief Find Thread count.
 *
@@ -29,10 +73,91 @@ class Settings
 * std::err will display the error in argument and exit if the arguments are incorrect.
 ********************************************************************************************/
 	static void mFindThreadCount(std::string);
+/*******************************************************************************************
+* @brief Find handover path.
+*
+* @param[in]		Unix socket path as string
+*
+* @details
+* std::err will display the error in argument and exit if the arguments are incorrect.
+********************************************************************************************/
+	static void mFindHandoverPath(std::string);
+/*******************************************************************************************
+* @brief Find warm pool size.
+*
+* @param[in]		Number of preallocated peers and sockets as string
+*
+* @details
+* std::err will display the error in argument and exit if the arguments are incorrect.
+********************************************************************************************/
+	static void mFindWarmPoolSize(std::string);
+/*******************************************************************************************
+* @brief Find capture path.
+*
+* @param[in]		Path of the command capture file as string
+*
+* @details
+* std::err will display the error in argument and exit if the arguments are incorrect.
+********************************************************************************************/
+	static void mFindCapturePath(std::string);
+/*******************************************************************************************
+* @brief Find a load shedding or connection limit.
+*
+* @param[in]		Limit as string (0 to disable)
+* @param[out]		Limit
+*
+* @details
+* std::err will display the error in argument and exit if the arguments are incorrect.
+********************************************************************************************/
+	static void mFindLimit(std::string, unsigned int&);
+/*******************************************************************************************
+* @brief Find a limit that is changed on reload (stored with one atomic store)
+********************************************************************************************/
+	static void mFindLimit(std::string, std::atomic<unsigned int>&);
+/*******************************************************************************************
+* @brief Find config file and load it.
+*
+* @param[in]		Path of the configuration file as string
+*
+* @details
+* The limits of the file are set first, then the other keys are processed as their argument.
+* std::err will display the error in argument and exit if the file or a value is incorrect.
+********************************************************************************************/
+	static void mFindConfigFile(std::string);
+/*******************************************************************************************
+* @brief Read the entries of a configuration file
+*
+* @param[in]		Path of the configuration file
+* @param[out]		Key and value pairs
+* @return			False if the file can not be read or a line is not "key = value"
+*
+* @details
+* Empty lines and lines starting with # are skipped.
+********************************************************************************************/
+	static bool mReadConfigFile(const std::string&, std::vector<std::pair<std::string, std::string>>&);
+/*******************************************************************************************
+* @brief Find the argument of a configuration key
+*
+* @param[in]		Key
+* @return			Option of the key (nullptr if unknown)
+********************************************************************************************/
+	static const Option* mFindOption(const std::string&);
 public:
 	static unsigned short mRTDSportNo;			// RTDS port number
 	static unsigned short mRTDSccmPortNo;		// RTDS CCM port number
+	static unsigned short mRTDSmetricsPortNo;	// RTDS metrics HTTP port number (0 if disabled)
+	static std::string mMetricsAddress;			// Address the metrics HTTP listener binds to
 	static short mRTDSthreadCount;				// Number of RTDS threads
+	static std::string mHandoverPath;			// Unix socket path for listening socket handover
+	static unsigned int mWarmPoolSize;			// Number of preallocated peers and sockets
+	static std::string mCapturePath;			// Path of the command capture file (empty if disabled)
+	static std::atomic<unsigned int> mMaxLoopLag;	// Event loop lag in ms above which load is shed (0 if disabled)
+	static std::atomic<unsigned int> mMaxPending;	// Queued deliveries above which load is shed (0 if disabled)
+	static std::atomic<unsigned int> mMaxSourceConnections;	// Open connections allowed per source (0 if disabled)
+	static std::atomic<unsigned int> mSourceConnectRate;	// Connects per second allowed per source (0 if disabled)
+	static unsigned int mUDPpingRate;			// UDP pings per second allowed per source (0 if disabled)
+	static unsigned int mUDPfanoutRate;			// UDP broadcasts and messages per second allowed per source (0 if disabled)
+	static std::string mConfigPath;				// Path of the configuration file (empty if none)
 	static bool mNeedToAbort;					// True if RTDS needs to be aborted
 /*******************************************************************************************
 * @brief Process Arguments string
@@ -44,6 +169,28 @@ public:
 ********************************************************************************************/
 	static void processArgument(std::string);
 /*******************************************************************************************
+* @brief Reload the configuration file
+*
+* @param[out]		Report of the keys not applied, "rejected=key,..\tignored=key,.." (empty
+*					parts left out)
+* @return			False if there is no file, it can not be read or a key is rejected
+*					(nothing is changed)
+*
+* @details
+* Applies the limits that are not [Startup] (RuntimeLimits), the load shedding limits and the
+* per-source connection limits. The other keys are ignored (applied on restart only).
+* A key is rejected if it is unknown or its value is incorrect. The report is logged.
+* Reloads from several CCM peers run one at a time; the reloaded values are atomics.
+* Reads the file, so call it off the IO threads.
+********************************************************************************************/
+	static bool reloadConfig(std::string&);
+/*******************************************************************************************
+* @brief Generate the startup configuration of the server from the processed arguments
+*
+* @return			Server configuration
+********************************************************************************************/
+	static ServerConfig serverConfig();
+/*******************************************************************************************
 * @brief Generate status string
 *
 * @param[in]		Status string
@@ -0,0 +1,119 @@
+#ifndef RUNTIME_LIMITS_H
+#define RUNTIME_LIMITS_H
+
+#include <atomic>
+#include <string>
+#include <utility>
+#include <vector>
+#include "common.h"
+
+#define LIMITS_CACHE_LINE 64			// Size of a cache line (all limits are read from one line)
+
+/*******************************************************************************************
+* @brief Enum class for the limits read while processing commands
+*
+* @details
+* MAX_BROADCAST_SIZE	Maximum size of a broadcast or message
+* MIN_TAG_SIZE		Minimum size of a general tag
+* MAX_TAG_SIZE		Maximum size of a tag
+* MIN_BGID_SIZE		Minimum size of a BGID
+* MAX_BGID_SIZE		Maximum size of a BGID
+* MSG_CACHE_SIZE	Messages kept before expired ones are deleted
+* MSG_KEEP_TIME		Minutes a message is kept at least
+* BUFF_SIZE			[Startup] Size of the read buffers
+* MAX_THREAD_COUNT	[Startup] Maximum number of RTDS threads
+********************************************************************************************/
+enum class Limit
+{
+	MAX_BROADCAST_SIZE,
+	MIN_TAG_SIZE,
+	MAX_TAG_SIZE,
+	MIN_BGID_SIZE,
+	MAX_BGID_SIZE,
+	MSG_CACHE_SIZE,
+	MSG_KEEP_TIME,
+	BUFF_SIZE,
+	MAX_THREAD_COUNT
+};
+#define LIMIT_COUNT 9
+
+/*******************************************************************************************
+* @brief Limits set in the configuration file
+*
+* @details
+* The values share one cache line and are read with relaxed loads, so the command path pays
+* no more than for the #define they replace. The [Startup] limits size structures created at
+* startup and are kept on reload; the others take effect on the next command.
+********************************************************************************************/
+class RuntimeLimits
+{
+	struct Spec
+	{
+		std::string name;					// Key in the configuration file
+		unsigned int minValue;				// Smallest accepted value
+		unsigned int maxValue;				// Largest accepted value
+		bool reloadable;					// False if the value is kept on reload
+	};
+
+	struct alignas(LIMITS_CACHE_LINE) Values
+	{
+		std::atomic<unsigned int> value[LIMIT_COUNT];	// Current value of each limit
+	};
+
+	static const Spec SPEC[];				// Key and range of each limit
+	static Values mValues;					// Current values (the DEF_ values until a file is loaded)
+
+/*******************************************************************************************
+* @brief Check that a set of values fits together
+*
+* @details
+* The minimum sizes must not exceed the maximum sizes and the read buffer must hold a
+* broadcast command with the largest message, BGID and tag.
+********************************************************************************************/
+	static bool mIsConsistent(const unsigned int (&)[LIMIT_COUNT]);
+
+public:
+/*******************************************************************************************
+* @brief Get a limit
+*
+* @param[in]			Limit
+* @return				Current value
+********************************************************************************************/
+	static unsigned int get(const Limit limit)
+	{
+		return mValues.value[(std::size_t)limit].load(std::memory_order_relaxed);
+	}
+/*******************************************************************************************
+* @brief Return true if a configuration key names a limit
+*
+* @param[in]			Key
+********************************************************************************************/
+	static bool isLimit(const std::string&);
+/*******************************************************************************************
+* @brief Return true if a configuration key names a limit that is applied on reload
+*
+* @param[in]			Key
+********************************************************************************************/
+	static bool isReloadable(const std::string&);
+/*******************************************************************************************
+* @brief Set the limits found in the entries of a configuration file
+*
+* @param[in]			Key and value pairs (keys that are not limits are skipped)
+* @param[in]			True on reload (the [Startup] limits are kept)
+* @param[in,out]		Rejected keys (the limits are only set if it is empty on return)
+* @return				False if a key is rejected (nothing is changed)
+*
+* @details
+* A key is rejected if its value is out of range. If the values do not fit together, all the
+* limit keys of the entries are rejected.
+********************************************************************************************/
+	static bool load(const std::vector<std::pair<std::string, std::string>>&, const bool, std::vector<std::string>&);
+/*******************************************************************************************
+* @brief Generate a report of the limits
+*
+* @return				Limits as "key=value\t"
+********************************************************************************************/
+	static std::string generateReport();
+};
+
+#endif
@@ -3,6 +3,8 @@
 
 #include <asio/ip/tcp.hpp>
 #include <asio/ssl.hpp>
+#include <asio/write.hpp>
+#include <functional>
 #include "peer.h"
 typedef asio::ssl::stream<asio::ip::tcp::socket> SSLsocket;
 
@@ -11,6 +13,9 @@ class SSLccm : public Peer
 	SSLsocket* mPeerSocket;					// Socket handling the data from peer system
 	bool mPeerIsActive;						// True if the peer socket is operational
 	bool mIsAdmin;							// True if have admin privileage
+	std::string mResponse;					// Response to the last command (may exceed the read buffer)
+	std::uint32_t mQuotaSlot;				// Slot of the source in the ConnectionQuota
+	std::function<std::string()> mDeferredJob;	// Blocking part of the last command, run off the IO thread (empty if none)
 
 /*******************************************************************************************
 * @brief Shedule handler funtion for peerSocket to receive the data in dataBuffer
@@ -33,7 +38,16 @@ class SSLccm : public Peer
 ********************************************************************************************/
 	void mProcessData(const asio::error_code&, std::size_t);
 /*******************************************************************************************
-* @brief Shedule a send for writeBuffer contents to the peer system
+* @brief Run mDeferredJob on a separate thread and send its response when it returns
+*
+* @details
+* The job returns the response text, which is sent from the ioContext. No read is pending
+* while the job runs, so the peer object stays alive until the response is sent.
+* Send WAIT_RETRY if the thread can not be started.
+********************************************************************************************/
+	void mRunDeferredJob();
+/*******************************************************************************************
+* @brief Shedule a send for the response to the peer system
 *
 * @details
 * The callback function _sendFeedback() will be invoked after the data is send.
@@ -63,8 +77,9 @@ public:
 * @brief Create a Peer object with an accepted SSLsocket*
 *
 * @param[in]			Pointer to the newly accepted socket
+* @param[in]			Slot of the source in the ConnectionQuota (released with the peer)
 ********************************************************************************************/
-	SSLccm(SSLsocket*);
+	SSLccm(SSLsocket*, const std::uint32_t);
 
 /*******************************************************************************************
 * @brief Terminate the RTDS server
@@ -79,6 +94,14 @@ public:
 ********************************************************************************************/
 	void status();
 /*******************************************************************************************
+* @brief Give the counters and gauges of the RTDS server
+********************************************************************************************/
+	void stats();
+/*******************************************************************************************
+* @brief Give the latency percentiles of the RTDS server
+********************************************************************************************/
+	void latency();
+/*******************************************************************************************
 * @brief Login to RTDS
 *
 * @param[in]			Username
@@ -90,6 +113,40 @@ public:
 ********************************************************************************************/
 	void login(const std::string_view&, const std::string_view&);
 /*******************************************************************************************
+* @brief Reload the TLS certificate for new SSL and CCM connections
+*
+* @details
+* The files are loaded on a separate thread (see mRunDeferredJob), not on the IO thread.
+* Send BAD_PARAM if the certificate can not be loaded (the current one is kept)
+********************************************************************************************/
+	void reloadTLS();
+/*******************************************************************************************
+* @brief Reload the configuration file
+*
+* @details
+* The file is read on a separate thread (see mRunDeferredJob), not on the IO thread.
+* Send BAD_PARAM if there is no file or it has a rejected key (nothing is changed).
+* The rejected and ignored keys follow the response (see Settings::reloadConfig).
+********************************************************************************************/
+	void reloadConfig();
+/*******************************************************************************************
+* @brief Give the log levels, or set the log level of a category (all if empty)
+*
+* @param[in]			Level name (empty to only give the levels)
+* @param[in]			Category name
+*
+* @details
+* Send BAD_PARAM if the level or category is unknown
+********************************************************************************************/
+	void logLevel(const std::string_view&, const std::string_view&);
+/*******************************************************************************************
+* @brief Dump the flight recorder events to FLIGHT_DUMP_FILE
+*
+* @details
+* Send WAIT_RETRY if the file can not be written
+********************************************************************************************/
+	void dumpFlight();
+/*******************************************************************************************
 * @brief Send response to the peer
 *
 * @param[in]			Response
@@ -2,17 +2,97 @@
 #define SSL_PEER_H
 
 #include "stream_peer.h"
+#include <asio/steady_timer.hpp>
+#include <asio/strand.hpp>
+#include <asio/write.hpp>
+#include <mutex>
+#include <vector>
+#include "latency.h"
 
 class SSLpeer : public StreamPeer
 {		
 	SSLsocket* mPeerSocket;				// Socket handling the data from peer system
+	bool mKernelTLS;					// True if the kernel encrypts the data send to the peer system
 
+	asio::strand<SSLsocket::executor_type> mStrand;	// Serializes every operation on the peer socket
+	asio::steady_timer mFlushTimer;		// Timer bounding the time pending data waits to be coalesced
+	std::mutex mSendLock;				// Mutex for the pending data and the flush state
+	std::string mPendingData;			// Data waiting to be written (coalesced into as few records as possible)
+	std::string mWritingData;			// Data being written to the peer system (strand only)
+	std::vector<LatencyTick> mPendingTicks;	// Created time of the messages in mPendingData
+	std::vector<LatencyTick> mWritingTicks;	// Created time of the messages in mWritingData (strand only)
+	bool mWriteInProgress;				// True if mWritingData is being written
+	bool mFlushTimerArmed;				// True if the flush timer handler is yet to be called
+	bool mFlushPosted;					// True if mFlushRequest is posted to the strand
+	bool mResponseQueued;				// True if mPendingData holds the response to a command
+	bool mResponseWriting;				// True if mWritingData holds the response to a command (strand only)
+	bool mIsReleased;					// True if the peer is deleted once the pending handlers return
+
+/*******************************************************************************************
+* @brief Shedule a write to the peer socket
+*
+* @param[in]			Buffer to be send
+* @param[in]			Write handler
+*
+* @details
+* With kernel TLS the data is written to the TCP socket directly, else through OpenSSL.
+********************************************************************************************/
+	template<typename ConstBuffer, typename WriteHandler>
+	void mWrite(const ConstBuffer& buffer, WriteHandler handler)
+	{
+		if (mKernelTLS)
+			asio::async_write(mPeerSocket->next_layer(), buffer, handler);
+		else
+			asio::async_write(*mPeerSocket, buffer, handler);
+	}
+/*******************************************************************************************
+* @brief Write all the pending data in one go (on the strand, mSendLock must be held)
+*
+* @details
+* The callback function mWriteFuncFeedbk() will be invoked after the data is send.
+********************************************************************************************/
+	void mFlushPending();
+/*******************************************************************************************
+* @brief Flush or arm the flush timer for the data queued by sendMessage (posted to the strand)
+*
+* @details
+* Shuts the socket down if the peer was disconnected for falling too far behind.
+********************************************************************************************/
+	void mFlushRequest();
 /*******************************************************************************************
-* @brief Shedule a send for dataBuffer contents to the peer system
+* @brief Check if a write, flush timer or flush request handler is still pending (mSendLock)
+********************************************************************************************/
+	bool mHasPendingHandlers() const;
+/*******************************************************************************************
+* @brief This callback function will be called after writing the pending data
+*
+* @param[in] ec					Asio error code
+*
+* @details
+* Write the data queued in the meantime, register for next receive if a response was send.
+* If ec state a error in connection, signal peer object to be deleted.
+********************************************************************************************/
+	void mWriteFuncFeedbk(const asio::error_code&);
+/*******************************************************************************************
+* @brief This callback function will be called when the flush timer expires
+*
+* @param[in] ec					Asio error code
+********************************************************************************************/
+	void mFlushTimerFeedbk(const asio::error_code&);
+/*******************************************************************************************
+* @brief Delete the peer once the pending write, timer and flush request handlers return
 *
 * @details
-* The callback function _sendFeedback() will be invoked after the data is send.
-* The callback function will be called even if thier is a error in ssl connection.
+* Cancel the pending write and the flush timer (on the strand).
+********************************************************************************************/
+	void mRelease();
+
+/*******************************************************************************************
+* @brief Queue the dataBuffer contents and send it to the peer system without waiting
+*
+* @details
+* The response goes out along with the messages pending for the peer.
+* The next receive is registered after the response is send.
 ********************************************************************************************/
 	void mSendPeerBufferData();
 /*******************************************************************************************
@@ -21,40 +101,32 @@ class SSLpeer : public StreamPeer
  * @details
  * The callback function _processData() will be invoked when their is new data in buffer.
  * The callback function will be called even if thier is a error in ssl connection.
+ * The data buffer is returned to the pool while waiting for the peer to send data.
  ********************************************************************************************/
 	void mPeerReceiveData();
 /*******************************************************************************************
-* @brief The callback function for getting (new data / socket error)
+* @brief The callback function for the peer socket becoming readable
 *
 * @param[in] ec					Asio error code
-* @param[in] size				Number of bytes received
 *
 * @details
-* Append receved data with '\0' to make it string
-* Pass the command to the command interpreter to process the command.
-* Send back Response for the received command.
+* Borrow a data buffer and read the command from the peer socket.
 * If ec state a error in connection, this peer object will be deleted.
 ********************************************************************************************/
-	void mProcessData(const asio::error_code&, std::size_t);
+	void mReceiveReadyData(const asio::error_code&);
 /*******************************************************************************************
-* @brief This callback function will be called after sending data in the write buffer
+* @brief The callback function for getting (new data / socket error)
 *
 * @param[in] ec					Asio error code
+* @param[in] size				Number of bytes received
 *
 * @details
-* If ec state a error in connection, this object will be deleted.
-* If the connection is ok then, clear the write buffer and register for next receive.
-********************************************************************************************/
-	void mSendFuncFeedbk(const asio::error_code&);
-/*******************************************************************************************
-* @brief This callback function will be called after sending message
-*
-* @param[in] ec			Asio error code
-*
-* @details
-* If ec state a error in connection, signal peer object to be deleted.
+* Append receved data with '\0' to make it string
+* Pass the command to the command interpreter to process the command.
+* Send back Response for the received command.
+* If ec state a error in connection, this peer object will be deleted.
 ********************************************************************************************/
-	void mSendMssgFuncFeedbk(const asio::error_code&);
+	void mProcessData(const asio::error_code&, std::size_t);
 /*******************************************************************************************
 * @brief Close and delete peerSocket
 *
@@ -69,11 +141,23 @@ public:
 * @brief Create a Peer object with an accepted socketPtr*
 *
 * @param[in]			Pointer to the newly accepted socket
+* @param[in]			Slot of the source in the ConnectionQuota (released with the peer)
 *
 * @details
 * Create a SourceAddressPair with the pointer to the socket. 
+* Hand the encryption of the data send to the peer over to the kernel if possible.
+* Every read, write, flush timer and teardown runs on the strand of the peer, so the SSL
+* stream is never used by two threads at once.
+********************************************************************************************/
+	SSLpeer(SSLsocket*, const std::uint32_t);
+/*******************************************************************************************
+* @brief Allocate / free the peer object from the ObjectPool
+*
+* @details
+* The peer socket is expected to be constructed with ObjectPool as well.
 ********************************************************************************************/
-	SSLpeer(SSLsocket*);
+	static void* operator new(std::size_t);
+	static void operator delete(void*);
 /*******************************************************************************************
 * @brief Shedule a send for message to the peer system
 *
@@ -82,8 +166,12 @@ public:
 *
 * @details
 * Only send the message if the tags are compatible.
-* The callback function _sendMFeedback() will be invoked after the data is send.
-* The callback function will be called even if thier is a error in ssl connection.
+* The message is coalesced with the other pending messages into as few TLS records as
+* possible. It is written within SSL_FLUSH_DELAY microseconds, or right away once
+* SSL_COALESCE_SIZE bytes are pending. A peer that falls SSL_MAX_PENDING_SIZE bytes behind
+* is disconnected (the message is dropped, like a failed write on a TCP peer).
+* Runs on the broadcasting thread: only the pending data is touched here, the write is
+* posted to the strand of the peer.
 ********************************************************************************************/
 	void sendMessage(const Message*);
 };
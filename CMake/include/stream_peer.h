@@ -14,6 +14,7 @@ class BGroup;
 class StreamPeer : public Peer
 {		
 	static std::atomic_int mGlobalPeerCount;		// Keep the total count of peers
+	static std::atomic<std::uint32_t> mLastPeerID;	// ID of the last created peer
 
 protected:
 	PeerMode mPeerMode;								// Hearing mode of the peer
@@ -22,6 +23,8 @@ protected:
 	BGT mBgTag;										// Broadcast group Tag
 	SAP mSApair;									// SAP string of the peer
 	PeerType mPeerType;								// Peer Type of the peer
+	std::uint32_t mPeerID;							// Unique ID of the peer (for the capture)
+	std::uint32_t mQuotaSlot;						// Slot of the source in the ConnectionQuota
 
 	std::shared_mutex mPeerResourceMtx;				// Mutex for locking the shared resources
 	bool mPeerIsActive;								// True if the peer socket is operational
@@ -32,7 +35,7 @@ protected:
 ********************************************************************************************/
 	StreamPeer();
 /*******************************************************************************************
-* @brief Distructor [Decrement the global peer count]
+* @brief Distructor [Decrement the global peer count, release the source quota]
 ********************************************************************************************/
 	~StreamPeer();
 
@@ -49,9 +52,17 @@ public:
 ********************************************************************************************/
 	const PeerType peerType() const;
 /*******************************************************************************************
+* @brief Get the unique ID of the peer (stream peers count up from 1)
+********************************************************************************************/
+	std::uint32_t peerID() const;
+/*******************************************************************************************
 * @brief Get the total Global Peer count
 ********************************************************************************************/
 	int getPeerCount() const;
+/*******************************************************************************************
+* @brief Get the total Global Peer count (without a peer)
+********************************************************************************************/
+	static int globalPeerCount();
 
 /*******************************************************************************************
 * @brief Disconnect the peer and delete the object
@@ -2,6 +2,7 @@
 #define TCP_PEER_H
 
 #include "stream_peer.h"
+#include "latency.h"
 
 class TCPpeer : public StreamPeer
 {		
@@ -21,9 +22,20 @@ class TCPpeer : public StreamPeer
  * @details
  * The callback function _processData() will be invoked when their is new data in buffer.
  * The callback function will be called even if thier is a error in tcp connection.
+ * The data buffer is returned to the pool while waiting for the peer to send data.
  ********************************************************************************************/
 	void mPeerReceiveData();
 /*******************************************************************************************
+* @brief The callback function for the peer socket becoming readable
+*
+* @param[in] ec					Asio error code
+*
+* @details
+* Borrow a data buffer and read the command from the peer socket.
+* If ec state a error in connection, this peer object will be deleted.
+********************************************************************************************/
+	void mReceiveReadyData(const asio::error_code&);
+/*******************************************************************************************
 * @brief The callback function for getting (new data / socket error)
 *
 * @param[in] ec					Asio error code
@@ -50,11 +62,13 @@ class TCPpeer : public StreamPeer
 * @brief This callback function will be called after sending message
 *
 * @param[in] ec			Asio error code
+* @param[in]			Message created time
 *
 * @details
 * If ec state a error in connection, signal peer object to be deleted.
+* Else record the fanout latency of the message.
 ********************************************************************************************/
-	void mSendMssgFuncFeedbk(const asio::error_code&);
+	void mSendMssgFuncFeedbk(const asio::error_code&, const LatencyTick);
 /*******************************************************************************************
 * @brief Close and delete peerSocket
 *
@@ -69,11 +83,20 @@ public:
 * @brief Create a Peer object with an accepted socketPtr*
 *
 * @param[in]			Pointer to the newly accepted socket
+* @param[in]			Slot of the source in the ConnectionQuota (released with the peer)
 *
 * @details
 * Create a SourceAddressPair with the pointer to the socket. 
 ********************************************************************************************/
-	TCPpeer(asio::ip::tcp::socket*);
+	TCPpeer(asio::ip::tcp::socket*, const std::uint32_t);
+/*******************************************************************************************
+* @brief Allocate / free the peer object from the ObjectPool
+*
+* @details
+* The peer socket is expected to be constructed with ObjectPool as well.
+********************************************************************************************/
+	static void* operator new(std::size_t);
+	static void operator delete(void*);
 /*******************************************************************************************
 * @brief Shedule a send for message to the peer system
 *
@@ -0,0 +1,62 @@
+#ifndef TLS_CONTEXT_H
+#define TLS_CONTEXT_H
+
+#include <asio/ssl.hpp>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include "common.h"
+
+#define TLS_CERT_FILE "server_cert.pem"		// Certificate and private key of the SSL and CCM ports
+#define TLS_DH_FILE "dh2048.pem"				// DH parameters of the SSL and CCM ports
+
+typedef std::shared_ptr<asio::ssl::context> SSLcontextPtr;
+
+class TLScontext
+{
+	static SSLcontextPtr mSSLcontext;					// Context for new SSL peers
+	static SSLcontextPtr mCCMcontext;					// Context for new CCM peers
+	static std::mutex mReloadLock;						// Mutex for loading the contexts one at a time
+	static std::filesystem::file_time_type mCertTime;	// Modification time of the loaded certificate file
+	static std::filesystem::file_time_type mDHTime;		// Modification time of the loaded DH file
+
+/*******************************************************************************************
+* @brief Build a new SSL context from the certificate and DH files
+*
+* @param[in]			Session ID context
+* @param[in]			True to collect the keys for kernel TLS
+* @return				Context, nullptr on failure
+********************************************************************************************/
+	static SSLcontextPtr mMakeContext(const std::string&, const bool);
+/*******************************************************************************************
+* @brief Get the modification time of the certificate and DH files
+*
+* @param[out]			Certificate file time
+* @param[out]			DH file time
+* @return				False if the files can not be found
+********************************************************************************************/
+	static bool mFileTimes(std::filesystem::file_time_type&, std::filesystem::file_time_type&);
+
+public:
+/*******************************************************************************************
+* @brief Build new SSL and CCM contexts and swap them in for new connections
+*
+* @return				True if the contexts are swapped
+*
+* @details
+* The current contexts are kept if the files can not be loaded.
+* Existing connections keep using the context they were accepted with.
+********************************************************************************************/
+	static bool load();
+/*******************************************************************************************
+* @brief Return true if the certificate or DH file changed since the last load
+********************************************************************************************/
+	static bool filesChanged();
+/*******************************************************************************************
+* @brief Get the current context for new SSL / CCM connections
+********************************************************************************************/
+	static SSLcontextPtr sslContext();
+	static SSLcontextPtr ccmContext();
+};
+
+#endif
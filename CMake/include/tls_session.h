@@ -0,0 +1,93 @@
+#ifndef TLS_SESSION_H
+#define TLS_SESSION_H
+
+#include <asio/ip/tcp.hpp>
+#include <asio/ssl.hpp>
+#include <atomic>
+#include <chrono>
+#include <shared_mutex>
+typedef asio::ssl::stream<asio::ip::tcp::socket> SSLsocket;
+
+#define SSL_SESSION_CACHE_SIZE 20480		// Maximum number of sessions in the server side cache
+#define SSL_SESSION_TIMEOUT 7200			// Number of seconds a session can be resumed
+#define TICKET_KEY_LIFETIME 3600			// Number of seconds before the ticket key is rotated
+#define TICKET_KEY_COUNT ((SSL_SESSION_TIMEOUT + TICKET_KEY_LIFETIME - 1) / TICKET_KEY_LIFETIME + 1)	// Keys accepted (session timeout plus one rotation)
+#define TICKET_KEY_NAME_SIZE 16				// Size of the ticket key name
+#define TICKET_KEY_SIZE 32					// Size of the ticket AES and HMAC keys
+
+class TLSsession
+{
+	struct TicketKey
+	{
+		unsigned char name[TICKET_KEY_NAME_SIZE];	// Key name send in the ticket
+		unsigned char aesKey[TICKET_KEY_SIZE];		// Key for encrypting the ticket
+		unsigned char hmacKey[TICKET_KEY_SIZE];		// Key for authenticating the ticket
+	};
+
+	static TicketKey mKeys[TICKET_KEY_COUNT];		// Current key (issues new tickets) followed by the older keys still accepted
+	static std::size_t mKeyCount;					// Number of valid keys in mKeys
+	static std::chrono::steady_clock::time_point mKeyCreatedTime;	// Time the current key was created
+	static std::shared_mutex mKeyLock;				// Mutex for rotating the keys
+
+	static std::atomic_uint mFullCount;				// Number of full handshakes
+	static std::atomic_uint mResumedCount;			// Number of resumed handshakes
+	friend struct TLSsessionTest;					// Unit tests age the keys (tests/tls_session_test.cpp)
+
+/*******************************************************************************************
+* @brief Generate a random ticket key
+*
+* @param[out]			Ticket key
+* @return				True if the random key is generated
+********************************************************************************************/
+	static bool mMakeKey(TicketKey&);
+/*******************************************************************************************
+* @brief Rotate the ticket keys if the current key is older than TICKET_KEY_LIFETIME
+*
+* @details
+* The older keys move down and the oldest one is dropped. A key is kept for TICKET_KEY_COUNT
+* rotations, so a ticket issued just before its key was rotated can still be resumed until
+* the session times out (and is renewed with the current key).
+********************************************************************************************/
+	static void mRotateKeys();
+/*******************************************************************************************
+* @brief OpenSSL callback for encrypting / decrypting a session ticket
+*
+* @return				OpenSSL ticket callback result
+*
+* @details
+* Return 1 to use the key, 2 to use the key and renew the ticket, 0 if the key is not found.
+********************************************************************************************/
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+	static int mTicketKeyCallback(SSL*, unsigned char*, unsigned char*, EVP_CIPHER_CTX*, EVP_MAC_CTX*, int);
+#else
+	static int mTicketKeyCallback(SSL*, unsigned char*, unsigned char*, EVP_CIPHER_CTX*, HMAC_CTX*, int);
+#endif
+
+public:
+/*******************************************************************************************
+* @brief Enable the server side session cache and session tickets for the SSL context
+*
+* @param[in]			SSL context
+* @param[in]			Session ID context (sessions are resumed only in the same context)
+*
+* @details
+* All contexts share the rotating ticket keys. Throws asio::error_code on failure.
+********************************************************************************************/
+	static void configure(asio::ssl::context&, const std::string&);
+/*******************************************************************************************
+* @brief Count a completed handshake as full or resumed
+*
+* @param[in]			SSL socket that completed the handshake
+********************************************************************************************/
+	static void countHandshake(SSLsocket&);
+/*******************************************************************************************
+* @brief Get the number of full handshakes
+********************************************************************************************/
+	static unsigned int fullCount();
+/*******************************************************************************************
+* @brief Get the number of resumed handshakes
+********************************************************************************************/
+	static unsigned int resumedCount();
+};
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+/*******************************************************************************************
+* @brief USDT tracepoints (provider rtds) for perf and bpftrace [Linux, CMake option RTDS_USDT]
+*
+* @details
+* A probe is a single nop until a tracer attaches, so the arguments must be values that are
+* already at hand. Without RTDS_USDT the macros compile to nothing.
+*
+* command			Command dispatched (peer type, command index, peer ID)
+* message_create	Message created (message, size, peer type)
+* bg_add			Peer added to a BG (peer, BGID)
+* bg_remove			Peer removed from a BG (peer, BGID)
+* broadcast_start	Fanout to a BG started (message, members)
+* broadcast_end		Fanout to a BG finished (message, members)
+* send_done			Message written to a peer (peer ID, message created tick, error code), once per
+*					failed SSL write
+*
+* ex: bpftrace -e 'usdt:./rtds:rtds:send_done { @fanout_ns = hist(nsecs - arg1); }'
+********************************************************************************************/
+#ifdef RTDS_USDT
+#include <sys/sdt.h>
+#define RTDS_TRACE2(probe, arg1, arg2) DTRACE_PROBE2(rtds, probe, arg1, arg2)
+#define RTDS_TRACE3(probe, arg1, arg2, arg3) DTRACE_PROBE3(rtds, probe, arg1, arg2, arg3)
+#else
+#define RTDS_TRACE2(probe, arg1, arg2)
+#define RTDS_TRACE3(probe, arg1, arg2, arg3)
+#endif
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef UDP_LIMITER_H
+#define UDP_LIMITER_H
+
+#include <asio/ip/udp.hpp>
+#include <cstdint>
+#include <vector>
+#include "common.h"
+#include "latency.h"
+
+#define UDP_LIMIT_TABLE_BITS 14				// Entries in the UDP source table (2^14, 24 bytes each)
+#define UDP_LIMIT_PROBE 8					// Entries searched for a source (the stalest one is reused)
+
+/*******************************************************************************************
+* @brief Enum class for the UDP command budgets
+*
+* @details
+* PING				Ping and every other command answered directly
+* FANOUT			Broadcast and message
+********************************************************************************************/
+enum class UDPbudget
+{
+	PING,
+	FANOUT
+};
+#define UDP_BUDGET_COUNT 2
+
+/*******************************************************************************************
+* @brief Per-source token bucket rate limiter for the UDP commands
+*
+* @details
+* Only the UDP listen routine uses the table, so it is not locked. Sources are kept by a
+* hash of the address (IPv6 by /64 prefix, the port is not part of the key) seeded per
+* process, in a fixed open addressing table allocated once a rate is set. Each budget holds one second of
+* commands, kept as the time the bucket is full again. When no entry is found within
+* UDP_LIMIT_PROBE, the entry whose buckets fill up first (the stalest) is reused.
+********************************************************************************************/
+class UDPlimiter
+{
+	struct Entry
+	{
+		std::uint64_t source;					// Hash of the source (0 if the entry was never used)
+		LatencyTick fullTick[UDP_BUDGET_COUNT];	// Time each bucket is full again
+	};
+
+	static std::vector<Entry> mTable;			// Source table (empty if no rate is set)
+	static std::uint64_t mHashSeed;				// Seed of the source hash (set with the table)
+	static LatencyTick mInterval[UDP_BUDGET_COUNT];		// Nanoseconds per command (0 if not limited)
+	static LatencyTick mTolerance[UDP_BUDGET_COUNT];	// Nanoseconds a bucket may run ahead of now
+
+public:
+/*******************************************************************************************
+* @brief Set the rates (call before the UDP listen routine starts)
+*
+* @param[in]			Ping commands per second per source (0 to disable)
+* @param[in]			Fanout commands per second per source (0 to disable)
+********************************************************************************************/
+	static void setLimits(const unsigned int, const unsigned int);
+/*******************************************************************************************
+* @brief Take a command from the budget of its source
+*
+* @param[in]			Source endpoint
+* @param[in]			Index of the command (COMMAND_COUNT if unknown)
+* @return				False if the source is over its budget (counted, the datagram is dropped)
+********************************************************************************************/
+	static bool allow(const asio::ip::udp::endpoint&, const short);
+};
+
+#endif
@@ -33,6 +33,16 @@ public:
 * UDP endpoint must be assigned before using any other functions
 ********************************************************************************************/
 	asio::ip::udp::endpoint& getRefToEndpoint();
+/*******************************************************************************************
+* @brief Get the ID of the UDP endpoint (for the capture)
+*
+* @return				Hash of the endpoint
+*
+* @details
+* Datagrams from the same endpoint get the same ID. UDP IDs are a separate ID space from
+* the stream peer IDs (the capture records the peer type with the ID).
+********************************************************************************************/
+	std::uint32_t peerID() const;
 
 /*******************************************************************************************
 * @brief Print the source address pair info to the buffer
@@ -0,0 +1,37 @@
+#include "admission.h"
+#include "flight_recorder.h"
+#include "log.h"
+
+std::atomic_bool Admission::mShedding;
+std::atomic<LatencyTick> Admission::mMaxLag((LatencyTick)DEF_MAX_LOOP_LAG * 1000000);
+std::atomic<std::int64_t> Admission::mMaxPending(DEF_MAX_PENDING);
+
+void Admission::setLimits(const unsigned int maxLag, const unsigned int maxPending)
+{
+	mMaxLag = (LatencyTick)maxLag * 1000000;
+	mMaxPending = maxPending;
+}
+
+void Admission::update(const LatencyTick lag, const std::int64_t pending)
+{
+	auto maxLag = mMaxLag.load();
+	auto maxPending = mMaxPending.load();
+	if (!isShedding())
+	{
+		auto lagExceeded = maxLag > 0 && lag > maxLag;
+		auto pendingExceeded = maxPending > 0 && pending > maxPending;
+		if (lagExceeded || pendingExceeded)
+		{
+			mShedding = true;
+			FlightRecorder::record(FlightEvent::SHED, lagExceeded ? lag : pending, lagExceeded ? "loop lag" : "pending deliveries");
+			LOG(Log::log("Shedding load - loop lag ", lag / 1000000, " ms, pending deliveries ", pending);)
+		}
+	}
+	else if ((maxLag == 0 || lag < maxLag * SHED_RESUME_PERCENT / 100) &&
+		(maxPending == 0 || pending < maxPending * SHED_RESUME_PERCENT / 100))
+	{
+		mShedding = false;
+		FlightRecorder::record(FlightEvent::SHED, 0, "resumed");
+		LOG(Log::log("Load shedding stopped");)
+	}
+}
@@ -1,8 +1,48 @@
 #include "advanced_buffer.h"
+#include "buffer_pool.h"
+#include "runtime_limits.h"
+#include "log.h"
+
+AdancedBuffer::AdancedBuffer()
+{
+	mBuffer = nullptr;
+	mVirtualSize = 0;
+}
+
+AdancedBuffer::~AdancedBuffer()
+{
+	release();
+}
+
+void AdancedBuffer::mAcquire()
+{
+	if (mBuffer == nullptr)
+		mBuffer = BufferPool::acquire();
+}
+
+void AdancedBuffer::release()
+{
+	if (mBuffer != nullptr)
+	{
+		BufferPool::release(mBuffer);
+		mBuffer = nullptr;
+	}
+	mVirtualSize = 0;
+}
 
 void AdancedBuffer::operator=(const std::string& responseStr)
 {
-	memcpy(mBuffer.data(), responseStr.data(), responseStr.length());
+	mAcquire();
+	std::size_t bufferSize = RuntimeLimits::get(Limit::BUFF_SIZE);
+	if (responseStr.length() > bufferSize)
+	{
+		LOG(Log::log("Response of ", responseStr.length(), " bytes cut to the buffer size ", bufferSize);)
+		memcpy(mBuffer, responseStr.data(), bufferSize - 1);
+		mBuffer[bufferSize - 1] = '\n';
+		mVirtualSize = bufferSize;
+		return;
+	}
+	memcpy(mBuffer, responseStr.data(), responseStr.length());
 	mVirtualSize = responseStr.length();
 }
 
@@ -17,16 +57,17 @@ bool AdancedBuffer::cookString(const size_t noOfStrBytes)
 
 asio::mutable_buffer AdancedBuffer::getReadBuffer()
 {
-	return asio::mutable_buffer(mBuffer.data(), RTDS_BUFF_SIZE);
+	mAcquire();
+	return asio::mutable_buffer(mBuffer, RuntimeLimits::get(Limit::BUFF_SIZE));
 }
 
 asio::mutable_buffer AdancedBuffer::getSendBuffer()
 {
-	return asio::mutable_buffer(mBuffer.data(), mVirtualSize);
+	return asio::mutable_buffer(mBuffer, mVirtualSize);
 }
 
 std::string_view AdancedBuffer::getStringView() const
 {
-	std::string_view strView((char*)mBuffer.data(), mVirtualSize);
+	std::string_view strView(mBuffer, mVirtualSize);
 	return strView;
 }
@@ -1,6 +1,8 @@
 #include "bg_controller.h"
 #include <algorithm>
+#include "metrics.h"
 #include "log.h"
+#include "trace.h"
 
 BGroupUnrestricted::BGroupUnrestricted(const std::string& bgID)
 {
@@ -32,19 +34,23 @@ bool BGroupUnrestricted::isEmpty() const
 void BGroupUnrestricted::broadcast(const Message* message)
 {
 	std::shared_lock<std::shared_mutex> readLock(mTCPpeerListLock);
+	RTDS_TRACE2(broadcast_start, message, mTCPpeerList.size());
 	for (auto peer : mTCPpeerList)
 			peer->sendMessage(message);
+	RTDS_TRACE2(broadcast_end, message, mTCPpeerList.size());
 }
 
 
 void BGroup::broadcast(StreamPeer* mPeer, const Message* message)
 {
 	std::shared_lock<std::shared_mutex> readLock(mTCPpeerListLock);
+	RTDS_TRACE2(broadcast_start, message, mTCPpeerList.size());
 	for (auto peer : mTCPpeerList)
 	{
 		if (peer != mPeer)
 			peer->sendMessage(message);
 	}
+	RTDS_TRACE2(broadcast_end, message, mTCPpeerList.size());
 }
 
 
@@ -53,6 +59,7 @@ std::shared_mutex BGcontroller::mBgLock;
 
 BGroup* BGcontroller::addToBG(StreamPeer* peer, const BGID& bgID)
 {
+	RTDS_TRACE2(bg_add, peer, bgID.c_str());
 	std::lock_guard<std::shared_mutex> writeLock(mBgLock);
 	BGroupUnrestricted* bGroup = nullptr;
 	auto bGroupItr = mBGmap.find(bgID);
@@ -60,16 +67,18 @@ BGroup* BGcontroller::addToBG(StreamPeer* peer, const BGID& bgID)
 	{
 		try {
 			bGroup = new BGroupUnrestricted(bgID);
-			DEBUG_LOG(Log::log("Created BG: ", bgID);)
+			DEBUG_LOG_AT(BG, Log::log("Created BG: ", bgID);)
 			bGroup->addPeer(peer);
-			DEBUG_LOG(Log::log("Added peer to BG: ", bgID);)
+			DEBUG_LOG_AT(BG, Log::log("Added peer to BG: ", bgID);)
 			mBGmap.insert(std::pair(bgID, bGroup));
-			DEBUG_LOG(Log::log("Added BG to map: ", bgID);)
+			DEBUG_LOG_AT(BG, Log::log("Added BG to map: ", bgID);)
+			Metrics::add(Metric::BG_COUNT);
+			Metrics::add(Metric::BG_MEMBERS);
 			return (BGroup*)bGroup;
 		}
 		catch (const std::runtime_error& ec)
 		{
-			LOG(Log::log("Failed to create BG - ", ec.what());)
+			LOG_AT(BG, Log::log("Failed to create BG - ", ec.what());)
 			if (bGroup != nullptr)
 				delete bGroup;
 			return nullptr;
@@ -80,12 +89,13 @@ BGroup* BGcontroller::addToBG(StreamPeer* peer, const BGID& bgID)
 		try {
 			bGroup = bGroupItr->second;
 			bGroup->addPeer(peer);
-			DEBUG_LOG(Log::log("Added peer to BG: ", bgID);)
+			DEBUG_LOG_AT(BG, Log::log("Added peer to BG: ", bgID);)
+			Metrics::add(Metric::BG_MEMBERS);
 			return (BGroup*)bGroup;
 		}
 		catch (const std::runtime_error& ec)
 		{
-			LOG(Log::log("Failed to add peer to BG - ", ec.what());)
+			LOG_AT(BG, Log::log("Failed to add peer to BG - ", ec.what());)
 			return nullptr;
 		}
 	}
@@ -93,16 +103,19 @@ BGroup* BGcontroller::addToBG(StreamPeer* peer, const BGID& bgID)
 
 void BGcontroller::removeFromBG(StreamPeer* peer, const BGID& bgID)
 {
+	RTDS_TRACE2(bg_remove, peer, bgID.c_str());
 	std::lock_guard<std::shared_mutex> writeLock(mBgLock);
 	auto bGroupItr = mBGmap.find(bgID);
 	if (bGroupItr != mBGmap.end())
 	{
 		auto bGroup = bGroupItr->second;
 		bGroup->removePeer(peer);
+		Metrics::add(Metric::BG_MEMBERS, -1);
 		if (bGroup->isEmpty())
 		{
 			mBGmap.erase(bGroupItr);
-			DEBUG_LOG(Log::log("Deleted BG: ", bgID);)
+			Metrics::add(Metric::BG_COUNT, -1);
+			DEBUG_LOG_AT(BG, Log::log("Deleted BG: ", bgID);)
 		}
 	}
 }
@@ -0,0 +1,68 @@
+#include "buffer_pool.h"
+#include "runtime_limits.h"
+
+thread_local BufferPool::ThreadCache BufferPool::mCache;
+std::vector<char*> BufferPool::mFreeBuffers;
+std::mutex BufferPool::mPoolLock;
+
+BufferPool::ThreadCache::ThreadCache()
+{
+	freeBuffers.reserve(BUFFER_CACHE_SIZE + 1);
+}
+
+BufferPool::ThreadCache::~ThreadCache()
+{
+	mSpill(freeBuffers.size());
+}
+
+void BufferPool::mRefill()
+{
+	auto& freeBuffers = mCache.freeBuffers;
+	std::lock_guard<std::mutex> lock(mPoolLock);
+	for (std::size_t count = 0; count < BUFFER_BATCH_SIZE && !mFreeBuffers.empty(); count++)
+	{
+		freeBuffers.push_back(mFreeBuffers.back());
+		mFreeBuffers.pop_back();
+	}
+}
+
+void BufferPool::mSpill(const std::size_t count)
+{
+	auto& freeBuffers = mCache.freeBuffers;
+	std::vector<char*> excessBuffers;
+	{
+		std::lock_guard<std::mutex> lock(mPoolLock);
+		for (std::size_t index = 0; index < count && !freeBuffers.empty(); index++)
+		{
+			if (mFreeBuffers.size() < MAX_POOLED_BUFFERS)
+				mFreeBuffers.push_back(freeBuffers.back());
+			else
+				excessBuffers.push_back(freeBuffers.back());
+			freeBuffers.pop_back();
+		}
+	}
+	for (auto buffer : excessBuffers)
+		delete[] buffer;
+}
+
+char* BufferPool::acquire()
+{
+	auto& freeBuffers = mCache.freeBuffers;
+	if (freeBuffers.empty())
+		mRefill();
+	if (!freeBuffers.empty())
+	{
+		auto buffer = freeBuffers.back();
+		freeBuffers.pop_back();
+		return buffer;
+	}
+	return new char[RuntimeLimits::get(Limit::BUFF_SIZE)];
+}
+
+void BufferPool::release(char* buffer)
+{
+	auto& freeBuffers = mCache.freeBuffers;
+	freeBuffers.push_back(buffer);
+	if (freeBuffers.size() > BUFFER_CACHE_SIZE)
+		mSpill(BUFFER_BATCH_SIZE);
+}
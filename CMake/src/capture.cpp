@@ -0,0 +1,139 @@
+#include "capture.h"
+#include "log.h"
+#include <algorithm>
+
+std::vector<std::unique_ptr<Capture::Ring>> Capture::mRings;
+std::mutex Capture::mRingLock;
+std::atomic_bool Capture::mCapturing;
+std::atomic_bool Capture::mWriterRunning;
+std::thread Capture::mWriter;
+std::FILE* Capture::mCaptureFile = nullptr;
+LatencyTick Capture::mStartTick = 0;
+
+/*******************************************************************************************
+* @brief Append an integer to a buffer in little endian byte order
+********************************************************************************************/
+template<typename T>
+static void appendLittleEndian(std::string& output, T value)
+{
+	for (std::size_t byte = 0; byte < sizeof(T); byte++)
+		output += (char)((std::uint64_t)value >> (8 * byte) & 0xFF);
+}
+
+bool Capture::start(const std::string& capturePath)
+{
+	std::lock_guard<std::mutex> lock(mRingLock);
+	if (mCaptureFile != nullptr)
+		return true;
+	mCaptureFile = std::fopen(capturePath.c_str(), "wb");
+	if (mCaptureFile == nullptr)
+		return false;
+	std::fwrite(CAPTURE_MAGIC, 1, CAPTURE_MAGIC_SIZE, mCaptureFile);
+	mStartTick = Latency::now();
+	mCommandSize = RuntimeLimits::get(Limit::BUFF_SIZE);
+
+	mWriterRunning = true;
+	try {
+		mWriter = std::thread(&Capture::mWriterRoutine);
+	}
+	catch (const std::system_error&)
+	{
+		mWriterRunning = false;
+		std::fclose(mCaptureFile);
+		mCaptureFile = nullptr;
+		return false;
+	}
+	mCapturing = true;
+	return true;
+}
+
+void Capture::stop()
+{
+	if (mCapturing.exchange(false))
+	{
+		mWriterRunning = false;
+		if (mWriter.joinable())
+			mWriter.join();
+		std::lock_guard<std::mutex> lock(mRingLock);
+		std::fclose(mCaptureFile);
+		mCaptureFile = nullptr;
+	}
+}
+
+std::uint64_t Capture::droppedCount()
+{
+	std::lock_guard<std::mutex> lock(mRingLock);
+	std::uint64_t dropCount = 0;
+	for (auto& ring : mRings)
+		dropCount += ring->dropped.load(std::memory_order_relaxed);
+	return dropCount;
+}
+
+Capture::Ring* Capture::mRegisterRing()
+{
+	auto ring = std::make_unique<Ring>();
+	ring->head = 0;
+	ring->tail = 0;
+	ring->dropped = 0;
+	ring->commands = std::make_unique<char[]>(CAPTURE_RING_SIZE * mCommandSize);
+
+	std::lock_guard<std::mutex> lock(mRingLock);
+	mRings.push_back(std::move(ring));
+	return mRings.back().get();
+}
+
+void Capture::mDrain(std::vector<Record>& batch, std::string& commands, std::string& output)
+{
+	batch.clear();
+	commands.clear();
+	{
+		std::lock_guard<std::mutex> lock(mRingLock);
+		for (auto& ring : mRings)
+		{
+			auto tail = ring->tail.load(std::memory_order_relaxed);
+			auto head = ring->head.load(std::memory_order_acquire);
+			for (; tail != head; tail++)
+			{
+				auto index = tail & (CAPTURE_RING_SIZE - 1);
+				batch.push_back(ring->records[index]);
+				batch.back().offset = commands.size();
+				commands.append(&ring->commands[index * mCommandSize], batch.back().size);
+			}
+			ring->tail.store(tail, std::memory_order_release);
+		}
+	}
+	if (batch.empty())
+		return;
+
+	std::stable_sort(batch.begin(), batch.end(),
+		[](const Record& left, const Record& right) { return left.time < right.time; });
+
+	output.clear();
+	for (auto& record : batch)
+	{
+		appendLittleEndian(output, std::max<LatencyTick>(record.time - mStartTick, 0));
+		appendLittleEndian(output, record.peerID);
+		appendLittleEndian(output, (std::uint8_t)record.peerType);
+		appendLittleEndian(output, record.size);
+		output.append(commands, record.offset, record.size);
+	}
+	if (std::fwrite(output.data(), 1, output.size(), mCaptureFile) != output.size())
+	{
+		LOG(Log::log("Capture write failed");)
+	}
+	std::fflush(mCaptureFile);
+}
+
+void Capture::mWriterRoutine()
+{
+	std::vector<Record> batch;
+	std::string commands;
+	std::string output;
+	batch.reserve(CAPTURE_RING_SIZE);
+	while (mWriterRunning)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(CAPTURE_FLUSH_INTERVAL));
+		mDrain(batch, commands, output);
+	}
+	mDrain(batch, commands, output);
+}
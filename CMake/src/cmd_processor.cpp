@@ -23,10 +23,27 @@ const std::string CmdProcessor::COMM[] =
 	"exit",
 	"login",
 	"abort",
-	"status"
+	"status",
+	"reload",
+	"stats",
+	"latency",
+	"loglevel",
+	"dump"
 };
+static_assert(sizeof(CmdProcessor::COMM) / sizeof(std::string) == COMMAND_COUNT, "Command string missing");
 
 
+short CmdProcessor::findCommand(const std::string_view& command)
+{
+	short index = 0;
+	for (; index < COMMAND_COUNT; index++)
+	{
+		if (command == COMM[index])
+			break;
+	}
+	return index;
+}
+
 TagType CmdProcessor::getTagType(const std::string_view& tag)
 {
 	if (isTag(tag))
@@ -37,7 +54,7 @@ TagType CmdProcessor::getTagType(const std::string_view& tag)
 			return TagType::OWN;
 		else if (tag.empty())
 			return TagType::EMPTY;
-		else if (tag.size() >= MIN_TAG_SIZE)
+		else if (tag.size() >= RuntimeLimits::get(Limit::MIN_TAG_SIZE))
 			return TagType::GENERAL;
 		else
 			return TagType::ERR;
@@ -48,28 +65,28 @@ TagType CmdProcessor::getTagType(const std::string_view& tag)
 
 bool CmdProcessor::isTag(const std::string_view& tag)
 {
-	if (isConsistent(tag) && tag.size() <= MAX_TAG_SIZE)
+	if (isConsistent(tag) && tag.size() <= RuntimeLimits::get(Limit::MAX_TAG_SIZE))
 		return true;
 	return false;
 }
 
 bool CmdProcessor::isGeneralTag(const std::string_view& tag)
 {
-	if (tag.size() >= MIN_TAG_SIZE && isConsistent(tag) && tag.size() <= MAX_TAG_SIZE)
+	if (tag.size() >= RuntimeLimits::get(Limit::MIN_TAG_SIZE) && isConsistent(tag) && tag.size() <= RuntimeLimits::get(Limit::MAX_TAG_SIZE))
 		return true;
 	return false;
 }
 
 bool CmdProcessor::isBGID(const std::string_view& bgid)
 {
-	if (bgid.size() >= MIN_BGID_SIZE && isConsistent(bgid) && bgid.size() <= MAX_BGID_SIZE)
+	if (bgid.size() >= RuntimeLimits::get(Limit::MIN_BGID_SIZE) && isConsistent(bgid) && bgid.size() <= RuntimeLimits::get(Limit::MAX_BGID_SIZE))
 		return true;
 	return false;
 }
 
 bool CmdProcessor::isBmessage(const std::string_view& bMessage)
 {
-	if (bMessage.size() != 0 && isPrintable(bMessage) && bMessage.size() <= MAX_BROADCAST_SIZE)
+	if (bMessage.size() != 0 && isPrintable(bMessage) && bMessage.size() <= RuntimeLimits::get(Limit::MAX_BROADCAST_SIZE))
 		return true;
 	return false;
 }
@@ -134,7 +151,7 @@ bool CmdProcessor::isThreadCount(const std::string threadCStr, short& threadCoun
 	if (std::regex_match(threadCStr, rgx))
 	{
 		auto threadC = std::stoi(threadCStr);
-		if (threadC <= MAX_THREAD_COUNT && threadC >= MIN_THREAD_COUNT)
+		if (threadC <= (int)RuntimeLimits::get(Limit::MAX_THREAD_COUNT) && threadC >= MIN_THREAD_COUNT)
 		{
 			threadCount = threadC;
 			return true;
@@ -143,6 +160,36 @@ bool CmdProcessor::isThreadCount(const std::string threadCStr, short& threadCoun
 	return false;
 }
 
+bool CmdProcessor::isPoolSize(const std::string poolSStr, unsigned int& poolSize)
+{
+	std::regex rgx("[0-9]{1,7}");
+	if (std::regex_match(poolSStr, rgx))
+	{
+		auto poolS = std::stoul(poolSStr);
+		if (poolS <= MAX_WARM_POOL_SIZE)
+		{
+			poolSize = poolS;
+			return true;
+		}
+	}
+	return false;
+}
+
+bool CmdProcessor::isLimit(const std::string limitStr, unsigned int& limit)
+{
+	std::regex rgx("[0-9]{1,7}");
+	if (std::regex_match(limitStr, rgx))
+	{
+		auto limitV = std::stoul(limitStr);
+		if (limitV <= MAX_LIMIT_VALUE)
+		{
+			limit = limitV;
+			return true;
+		}
+	}
+	return false;
+}
+
 const std::string_view CmdProcessor::extractElement(std::string_view& command)
 {
 	auto endIndex = command.find_first_of('\t');
@@ -167,21 +214,28 @@ const std::string_view CmdProcessor::extractElement(std::string_view& command)
 void CmdProcessor::processCommand(UDPpeer& peer)
 {
 	auto commandStr = peer.getCommandString();
-	auto command = extractElement(commandStr);
-	
-	if (command == COMM[(short)Command::BROADCAST])
+	Capture::record(peer.peerID(), PeerType::UDP, commandStr);
+	auto command = findCommand(extractElement(commandStr));
+	Metrics::countCommand(MetricSource::UDP, command);
+	RTDS_TRACE3(command, (int)PeerType::UDP, command, peer.peerID());
+
+	if (!UDPlimiter::allow(peer.getRefToEndpoint(), command))
+		return;
+	if (command != (short)Command::LISTEN && Admission::shedCommand(command))
+		peer.respondWith(Response::WAIT_RETRY);
+	else if (command == (short)Command::BROADCAST)
 		mUDP_broadcast(peer, commandStr);
-	else if (command == COMM[(short)Command::MESSAGE])
+	else if (command == (short)Command::MESSAGE)
 		mUDP_message(peer, commandStr);
-	else if (command == COMM[(short)Command::PING])
+	else if (command == (short)Command::PING)
 		mUDP_ping(peer, commandStr);
-	else if (command == COMM[(short)Command::LISTEN])
+	else if (command == (short)Command::LISTEN)
 		peer.respondWith(Response::NOT_ALLOWED);
-	else if (command == COMM[(short)Command::LEAVE])
+	else if (command == (short)Command::LEAVE)
 		peer.respondWith(Response::NOT_ALLOWED);
-	else if (command == COMM[(short)Command::CHANGE])
+	else if (command == (short)Command::CHANGE)
 		peer.respondWith(Response::NOT_ALLOWED);
-	else if (command == COMM[(short)Command::EXIT])
+	else if (command == (short)Command::EXIT)
 		peer.respondWith(Response::NOT_ALLOWED);
 	else
 		peer.respondWith(Response::BAD_COMMAND);
@@ -223,15 +277,27 @@ void CmdProcessor::mUDP_message(UDPpeer& peer, std::string_view& commandStr)
 void CmdProcessor::processCommand(SSLccm& peer)
 {
 	auto commandStr = peer.getCommandString();
-	auto command = extractElement(commandStr);
-	if (command == COMM[(short)Command::LOGIN])
+	auto command = findCommand(extractElement(commandStr));
+	Metrics::countCommand(MetricSource::CCM, command);
+
+	if (command == (short)Command::LOGIN)
 		mCCM_login(peer, commandStr);
-	else if (command == COMM[(short)Command::STATUS])
+	else if (command == (short)Command::STATUS)
 		mCCM_status(peer, commandStr);
-	else if (command == COMM[(short)Command::EXIT])
+	else if (command == (short)Command::EXIT)
 		mCCM_exit(peer, commandStr);
-	else if (command == COMM[(short)Command::ABORT])
+	else if (command == (short)Command::ABORT)
 		mCCM_abort(peer, commandStr);
+	else if (command == (short)Command::RELOAD)
+		mCCM_reload(peer, commandStr);
+	else if (command == (short)Command::STATS)
+		mCCM_stats(peer, commandStr);
+	else if (command == (short)Command::LATENCY)
+		mCCM_latency(peer, commandStr);
+	else if (command == (short)Command::LOGLEVEL)
+		mCCM_loglevel(peer, commandStr);
+	else if (command == (short)Command::DUMP)
+		mCCM_dump(peer, commandStr);
 	else
 		peer.respondWith(Response::BAD_COMMAND);
 }
@@ -268,4 +334,48 @@ void CmdProcessor::mCCM_abort(SSLccm& peer, std::string_view& commandStr)
 		peer.abort();
 	else
 		peer.respondWith(Response::BAD_PARAM);
-}
\ No newline at end of file
+}
+void CmdProcessor::mCCM_reload(SSLccm& peer, std::string_view& commandStr)
+{
+	auto target = extractElement(commandStr);
+	if (target == "tls" && commandStr.empty())
+		peer.reloadTLS();
+	else if (target == "config" && commandStr.empty())
+		peer.reloadConfig();
+	else
+		peer.respondWith(Response::BAD_PARAM);
+}
+
+void CmdProcessor::mCCM_stats(SSLccm& peer, std::string_view& commandStr)
+{
+	if (commandStr.empty())
+		peer.stats();
+	else
+		peer.respondWith(Response::BAD_PARAM);
+}
+
+void CmdProcessor::mCCM_latency(SSLccm& peer, std::string_view& commandStr)
+{
+	if (commandStr.empty())
+		peer.latency();
+	else
+		peer.respondWith(Response::BAD_PARAM);
+}
+
+void CmdProcessor::mCCM_loglevel(SSLccm& peer, std::string_view& commandStr)
+{
+	auto level = extractElement(commandStr);
+	auto category = extractElement(commandStr);
+	if (commandStr.empty() && (!level.empty() || category.empty()))
+		peer.logLevel(level, category);
+	else
+		peer.respondWith(Response::BAD_PARAM);
+}
+
+void CmdProcessor::mCCM_dump(SSLccm& peer, std::string_view& commandStr)
+{
+	if (commandStr.empty())
+		peer.dumpFlight();
+	else
+		peer.respondWith(Response::BAD_PARAM);
+}
@@ -0,0 +1,155 @@
+#include "connection_quota.h"
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include "metrics.h"
+
+std::vector<ConnectionQuota::Entry> ConnectionQuota::mTable;
+std::atomic<bool> ConnectionQuota::mHasTable(false);
+std::array<ConnectionQuota::Shard, std::size_t(1) << QUOTA_SHARD_BITS> ConnectionQuota::mShards;
+std::uint32_t ConnectionQuota::mMaxConnections = 0;
+LatencyTick ConnectionQuota::mConnectInterval = 0;
+LatencyTick ConnectionQuota::mBurstTolerance = 0;
+std::uint64_t ConnectionQuota::mHashSeed = 0;
+
+/*******************************************************************************************
+* @brief Mix the bits of a 64 bit value (splitmix64 finalizer)
+********************************************************************************************/
+static std::uint64_t mixBits(std::uint64_t value)
+{
+	value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+	value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+	return value ^ (value >> 31);
+}
+
+void ConnectionQuota::setLimits(const unsigned int maxConnections, const unsigned int connectRate)
+{
+	for (auto& shard : mShards)
+		shard.lock.lock();
+	mMaxConnections = maxConnections;
+	mConnectInterval = (connectRate > 0) ? 1000000000 / (LatencyTick)connectRate : 0;
+	mBurstTolerance = (connectRate > 0) ? mConnectInterval * (connectRate - 1) : 0;
+	if ((mMaxConnections > 0 || mConnectInterval > 0) && mTable.empty())
+	{
+		mHashSeed = randomSeed();
+		mTable.assign(std::size_t(1) << QUOTA_TABLE_BITS, Entry());
+		mHasTable.store(true, std::memory_order_release);
+	}
+	for (auto& shard : mShards)
+		shard.lock.unlock();
+}
+
+std::uint32_t ConnectionQuota::mAdmit(const std::uint32_t index, const LatencyTick now)
+{
+	auto& entry = mTable[index];
+	if (mMaxConnections > 0 && entry.connections >= mMaxConnections)
+	{
+		Metrics::add(Metric::QUOTA_REJECTS);
+		return QUOTA_REJECTED;
+	}
+	if (mConnectInterval > 0)
+	{
+		auto fullTick = std::max(entry.fullTick, now);
+		if (fullTick - now > mBurstTolerance)
+		{
+			Metrics::add(Metric::RATE_REJECTS);
+			return QUOTA_REJECTED;
+		}
+		entry.fullTick = fullTick + mConnectInterval;
+	}
+	entry.connections++;
+	return index | (std::uint32_t)entry.generation << QUOTA_TABLE_BITS;
+}
+
+std::array<unsigned char, 16> ConnectionQuota::sourceBytes(const asio::ip::address& address)
+{
+	std::array<unsigned char, 16> addressBytes;
+	if (address.is_v4())
+		addressBytes = asio::ip::make_address_v6(asio::ip::v4_mapped, address.to_v4()).to_bytes();
+	else
+	{
+		addressBytes = address.to_v6().to_bytes();
+		if (!address.to_v6().is_v4_mapped())
+			std::fill(addressBytes.begin() + 8, addressBytes.end(), 0);
+	}
+	return addressBytes;
+}
+
+std::uint64_t ConnectionQuota::sourceHash(const std::array<unsigned char, 16>& addressBytes, const std::uint64_t seed)
+{
+	std::uint64_t high, low;
+	std::memcpy(&high, addressBytes.data(), sizeof(high));
+	std::memcpy(&low, addressBytes.data() + 8, sizeof(low));
+	return mixBits(mixBits(high ^ seed) ^ low);
+}
+
+std::uint64_t ConnectionQuota::randomSeed()
+{
+	try {
+		std::random_device randomDevice;
+		return (std::uint64_t)randomDevice() << 32 ^ randomDevice();
+	}
+	catch (const std::exception&)
+	{
+		return mixBits((std::uint64_t)Latency::now());
+	}
+}
+
+std::uint32_t ConnectionQuota::acquire(const Listener listener, const asio::ip::address& address)
+{
+	if (!mHasTable.load(std::memory_order_acquire))
+		return QUOTA_UNTRACKED;
+	auto addressBytes = sourceBytes(address);
+	auto listenerKey = (std::uint8_t)((std::uint8_t)listener + 1);
+	auto hash = mixBits(sourceHash(addressBytes, mHashSeed) ^ listenerKey);
+	auto start = (std::uint32_t)(hash >> (64 - QUOTA_TABLE_BITS));
+	auto shardMask = (std::uint32_t(1) << (QUOTA_TABLE_BITS - QUOTA_SHARD_BITS)) - 1;
+	auto now = Latency::now();
+
+	std::lock_guard<std::mutex> lock(mShards[start >> (QUOTA_TABLE_BITS - QUOTA_SHARD_BITS)].lock);
+	auto freeIndex = QUOTA_UNTRACKED;
+	auto idleIndex = QUOTA_UNTRACKED;
+	auto oldestIndex = QUOTA_UNTRACKED;
+	for (std::uint32_t probe = 0; probe < QUOTA_PROBE_LIMIT; probe++)
+	{
+		auto index = (start & ~shardMask) | ((start + probe) & shardMask);
+		auto& entry = mTable[index];
+		if (entry.listener == listenerKey && entry.address == addressBytes)
+			return mAdmit(index, now);
+		if (freeIndex == QUOTA_UNTRACKED && (entry.listener == 0 || (entry.connections == 0 && entry.fullTick <= now)))
+			freeIndex = index;
+		if (entry.connections == 0 && (idleIndex == QUOTA_UNTRACKED || entry.fullTick < mTable[idleIndex].fullTick))
+			idleIndex = index;
+		if (oldestIndex == QUOTA_UNTRACKED || entry.fullTick < mTable[oldestIndex].fullTick)
+			oldestIndex = index;
+		if (entry.listener == 0)
+			break;
+	}
+	if (freeIndex == QUOTA_UNTRACKED)
+		freeIndex = idleIndex;
+	if (freeIndex == QUOTA_UNTRACKED)
+	{
+		freeIndex = oldestIndex;
+		mTable[freeIndex].generation = (mTable[freeIndex].generation + 1) & QUOTA_GENERATION_MASK;
+		Metrics::add(Metric::QUOTA_EVICTIONS);
+	}
+
+	auto& entry = mTable[freeIndex];
+	entry.address = addressBytes;
+	entry.fullTick = now;
+	entry.connections = 0;
+	entry.listener = listenerKey;
+	return mAdmit(freeIndex, now);
+}
+
+void ConnectionQuota::release(const std::uint32_t slot)
+{
+	if (slot == QUOTA_UNTRACKED || slot == QUOTA_REJECTED)
+		return;
+	auto index = slot & ((std::uint32_t(1) << QUOTA_TABLE_BITS) - 1);
+	auto generation = slot >> QUOTA_TABLE_BITS;
+	std::lock_guard<std::mutex> lock(mShards[index >> (QUOTA_TABLE_BITS - QUOTA_SHARD_BITS)].lock);
+	auto& entry = mTable[index];
+	if (entry.generation == generation && entry.connections > 0)
+		entry.connections--;
+}
@@ -0,0 +1,244 @@
+#include "flight_recorder.h"
+#include <csignal>
+#include <memory>
+#include <new>
+#include <system_error>
+#include <thread>
+#include <fcntl.h>
+#include "log.h"
+#ifdef _WIN32
+#include <io.h>
+#include <sys/stat.h>
+#define FLIGHT_OPEN(path) ::_open(path, _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE)
+#define FLIGHT_WRITE ::_write
+#define FLIGHT_CLOSE ::_close
+#else
+#include <unistd.h>
+#define FLIGHT_OPEN(path) ::open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644)
+#define FLIGHT_WRITE ::write
+#define FLIGHT_CLOSE ::close
+#endif
+
+std::atomic<FlightRecorder::Ring*> FlightRecorder::mRings[FLIGHT_MAX_THREADS];
+std::atomic<int> FlightRecorder::mRingCount(0);
+std::atomic_flag FlightRecorder::mRingsFull = ATOMIC_FLAG_INIT;
+std::atomic<bool> FlightRecorder::mDumping(false);
+
+const char* const FlightRecorder::NAME[] =
+{
+	"ACCEPT",
+	"JOIN",
+	"LEAVE",
+	"DROP",
+	"FAILURE",
+	"SLOW",
+	"ABORT",
+	"DUMP",
+	"SHED"
+};
+
+FlightRecorder::Ring* FlightRecorder::mRegisterRing()
+{
+	struct RingOwner
+	{
+		Ring* ring;								// Ring owned by the thread (nullptr if none)
+		bool hasExited;							// True once the thread released its ring
+
+		~RingOwner()
+		{
+			hasExited = true;
+			if (ring == nullptr)
+				return;
+			mThreadRing = nullptr;
+			ring->isOwned.store(false, std::memory_order_release);
+		}
+	};
+	thread_local RingOwner ringOwner = { nullptr, false };
+	if (ringOwner.hasExited)
+		return nullptr;
+
+	installSignalStack();
+	auto ringCount = mRingCount.load();
+	for (int index = 0; index < ringCount && index < FLIGHT_MAX_THREADS; index++)
+	{
+		auto ring = mRings[index].load(std::memory_order_acquire);
+		auto isOwned = false;
+		if (ring != nullptr && ring->isOwned.compare_exchange_strong(isOwned, true, std::memory_order_acq_rel))
+			return ringOwner.ring = ring;
+	}
+
+	auto index = mRingCount.fetch_add(1);
+	if (index >= FLIGHT_MAX_THREADS)
+	{
+		if (!mRingsFull.test_and_set())
+		{	LOG(Log::log("Flight recorder full, threads beyond ", FLIGHT_MAX_THREADS, " running threads are not recorded");)	}
+		return nullptr;
+	}
+	auto ring = new Ring();
+	ring->head.store(0, std::memory_order_relaxed);
+	ring->isOwned.store(true, std::memory_order_relaxed);
+	mRings[index].store(ring, std::memory_order_release);
+	return ringOwner.ring = ring;
+}
+
+/*******************************************************************************************
+* @brief Append an integer to a buffer (async-signal-safe)
+*
+* @param[in,out]		End of the buffer
+* @param[in]			Value
+* @param[in]			Minimum number of digits (zero padded)
+********************************************************************************************/
+static char* appendNumber(char* end, std::int64_t value, int minDigits = 1)
+{
+	char digits[24];
+	int count = 0;
+	if (value < 0)
+	{
+		*end++ = '-';
+		value = -value;
+	}
+	do {
+		digits[count++] = (char)('0' + value % 10);
+		value /= 10;
+	} while (value != 0 || count < minDigits);
+	while (count > 0)
+		*end++ = digits[--count];
+	return end;
+}
+
+void FlightRecorder::mWriteEvents(int fd)
+{
+	static_assert(sizeof(NAME) / sizeof(const char*) == FLIGHT_EVENT_COUNT, "Flight event name missing");
+	static const char header[] = "thread\ttime\tevent\tvalue\tdetail\n";
+	FLIGHT_WRITE(fd, header, sizeof(header) - 1);
+
+	char line[128 + FLIGHT_DETAIL_SIZE];
+	auto ringCount = mRingCount.load();
+	if (ringCount > FLIGHT_MAX_THREADS)
+		ringCount = FLIGHT_MAX_THREADS;
+	for (int index = 0; index < ringCount; index++)
+	{
+		auto ring = mRings[index].load(std::memory_order_acquire);
+		if (ring == nullptr)
+			continue;
+		auto head = ring->head.load(std::memory_order_acquire);
+		auto tail = (head > FLIGHT_RING_SIZE) ? head - FLIGHT_RING_SIZE : 0;
+		for (; tail < head; tail++)
+		{
+			const auto& event = ring->events[tail & (FLIGHT_RING_SIZE - 1)];
+			auto end = appendNumber(line, index);
+			*end++ = '\t';
+			end = appendNumber(end, event.time / 1000000);
+			*end++ = '.';
+			end = appendNumber(end, event.time % 1000000, 6);
+			*end++ = '\t';
+			auto type = (std::size_t)event.type < FLIGHT_EVENT_COUNT ? NAME[(std::size_t)event.type] : "?";
+			auto typeSize = std::strlen(type);
+			std::memcpy(end, type, typeSize);
+			end += typeSize;
+			*end++ = '\t';
+			end = appendNumber(end, event.value);
+			*end++ = '\t';
+			std::size_t detailSize = event.detailSize < FLIGHT_DETAIL_SIZE ? event.detailSize : FLIGHT_DETAIL_SIZE;
+			for (std::size_t character = 0; character < detailSize; character++)
+				*end++ = (event.detail[character] == '\t' || event.detail[character] == '\n') ? ' ' : event.detail[character];
+			*end++ = '\n';
+			FLIGHT_WRITE(fd, line, (unsigned int)(end - line));
+		}
+	}
+}
+
+void FlightRecorder::mDumpRoutine()
+{
+	auto fd = FLIGHT_OPEN(FLIGHT_DUMP_FILE);
+	if (fd >= 0)
+	{
+		mWriteEvents(fd);
+		FLIGHT_CLOSE(fd);
+	}
+	else
+	{	LOG(Log::log("Failed to open the flight recorder dump file ", FLIGHT_DUMP_FILE);)	}
+	mDumping.store(false, std::memory_order_release);
+}
+
+bool FlightRecorder::dump()
+{
+	if (mDumping.exchange(true, std::memory_order_acq_rel))
+		return false;
+	record(FlightEvent::DUMP);
+	try {
+		std::thread dumpThread(&FlightRecorder::mDumpRoutine);
+		dumpThread.detach();
+	}
+	catch (const std::system_error&)
+	{
+		mDumping.store(false, std::memory_order_release);
+		return false;
+	}
+	return true;
+}
+
+void FlightRecorder::waitForDump()
+{
+	while (mDumping.load(std::memory_order_acquire))
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+}
+
+void FlightRecorder::mSignalHandler(int signalNumber)
+{
+	static std::atomic_flag dumping = ATOMIC_FLAG_INIT;
+	if (!dumping.test_and_set())
+	{
+		auto fd = FLIGHT_OPEN(FLIGHT_DUMP_FILE);
+		if (fd >= 0)
+		{
+			mWriteEvents(fd);
+			FLIGHT_CLOSE(fd);
+		}
+	}
+	std::raise(signalNumber);
+}
+
+void FlightRecorder::installCrashHandler()
+{
+#ifndef _WIN32
+	struct sigaction action = {};
+	action.sa_handler = &FlightRecorder::mSignalHandler;
+	sigemptyset(&action.sa_mask);
+	action.sa_flags = SA_RESETHAND | SA_ONSTACK;
+	for (auto signalNumber : { SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT })
+		sigaction(signalNumber, &action, nullptr);
+	installSignalStack();
+#endif
+}
+
+void FlightRecorder::installSignalStack()
+{
+#ifndef _WIN32
+	struct SignalStack
+	{
+		std::unique_ptr<char[]> memory;			// Alternate stack (nullptr if not installed)
+
+		~SignalStack()
+		{
+			if (memory == nullptr)
+				return;
+			stack_t disabled = {};
+			disabled.ss_flags = SS_DISABLE;
+			sigaltstack(&disabled, nullptr);
+		}
+	};
+	thread_local SignalStack signalStack;
+	if (signalStack.memory != nullptr)
+		return;
+
+	signalStack.memory.reset(new (std::nothrow) char[FLIGHT_SIGNAL_STACK_SIZE]);
+	if (signalStack.memory == nullptr)
+		return;
+	stack_t stack = {};
+	stack.ss_sp = signalStack.memory.get();
+	stack.ss_size = FLIGHT_SIGNAL_STACK_SIZE;
+	if (sigaltstack(&stack, nullptr) != 0)
+		signalStack.memory.reset();
+#endif
+}
@@ -0,0 +1,48 @@
+#include "handler_allocator.h"
+#include <new>
+
+thread_local HandlerMemory::ThreadCache HandlerMemory::mCache;
+
+HandlerMemory::ThreadCache::~ThreadCache()
+{
+	for (auto block : freeList)
+	{
+		while (block != nullptr)
+		{
+			auto nextBlock = block->next;
+			::operator delete(block);
+			block = nextBlock;
+		}
+	}
+}
+
+void* HandlerMemory::allocate(std::size_t size)
+{
+	auto sizeClass = (size + HANDLER_SLOT_SIZE - 1) / HANDLER_SLOT_SIZE - 1;
+	if (size == 0 || sizeClass >= HANDLER_SLOT_CLASSES)
+		return ::operator new(size);
+
+	auto block = mCache.freeList[sizeClass];
+	if (block != nullptr)
+	{
+		mCache.freeList[sizeClass] = block->next;
+		mCache.freeCount[sizeClass]--;
+		return block;
+	}
+	return ::operator new((sizeClass + 1) * HANDLER_SLOT_SIZE);
+}
+
+void HandlerMemory::deallocate(void* pointer, std::size_t size)
+{
+	auto sizeClass = (size + HANDLER_SLOT_SIZE - 1) / HANDLER_SLOT_SIZE - 1;
+	if (size == 0 || sizeClass >= HANDLER_SLOT_CLASSES || mCache.freeCount[sizeClass] >= MAX_RECYCLED_HANDLERS)
+	{
+		::operator delete(pointer);
+		return;
+	}
+
+	auto block = static_cast<FreeBlock*>(pointer);
+	block->next = mCache.freeList[sizeClass];
+	mCache.freeList[sizeClass] = block;
+	mCache.freeCount[sizeClass]++;
+}
@@ -0,0 +1,150 @@
+#include "handover.h"
+#ifdef RTDS_HANDOVER
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cstring>
+#include "log.h"
+
+static void handoverWakeHandler(int)
+{
+}
+
+void Handover::installWakeSignal()
+{
+	struct sigaction action = {};
+	action.sa_handler = handoverWakeHandler;
+	sigemptyset(&action.sa_mask);
+	action.sa_flags = 0;
+	sigaction(HANDOVER_WAKE_SIGNAL, &action, nullptr);
+}
+
+bool Handover::mMakeAddress(const std::string& path, sockaddr_un& address)
+{
+	if (path.empty() || path.size() >= sizeof(address.sun_path))
+		return false;
+
+	std::memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	std::memcpy(address.sun_path, path.data(), path.size());
+	return true;
+}
+
+bool Handover::receiveListeners(const std::string& path, ListenerFDs& listenerFDs)
+{
+	sockaddr_un address;
+	if (!mMakeAddress(path, address))
+	{
+		LOG(Log::log("Invalid handover path - ", path);)
+		return false;
+	}
+
+	auto unixSocket = ::socket(AF_UNIX, SOCK_STREAM, 0);
+	if (unixSocket == -1)
+		return false;
+	if (::connect(unixSocket, (sockaddr*)&address, sizeof(address)) == -1)
+	{
+		DEBUG_LOG(Log::log("No RTDS to take over from at ", path);)
+		::close(unixSocket);
+		return false;
+	}
+	DEBUG_LOG(Log::log("Connected to the running RTDS for handover");)
+
+	char magic[sizeof(HANDOVER_MAGIC)];
+	alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * LISTENER_COUNT)];
+	iovec ioVector = { magic, sizeof(magic) };
+	msghdr handoverMsg = {};
+	handoverMsg.msg_iov = &ioVector;
+	handoverMsg.msg_iovlen = 1;
+	handoverMsg.msg_control = control;
+	handoverMsg.msg_controllen = sizeof(control);
+
+	auto dataSize = ::recvmsg(unixSocket, &handoverMsg, MSG_CMSG_CLOEXEC);
+	::close(unixSocket);
+
+	auto ctrlMsg = CMSG_FIRSTHDR(&handoverMsg);
+	if (ctrlMsg == nullptr || ctrlMsg->cmsg_level != SOL_SOCKET || ctrlMsg->cmsg_type != SCM_RIGHTS
+		|| ctrlMsg->cmsg_len != CMSG_LEN(sizeof(int) * LISTENER_COUNT))
+	{
+		LOG(Log::log("Handover failed - listening sockets not received");)
+		return false;
+	}
+	std::memcpy(listenerFDs.data(), CMSG_DATA(ctrlMsg), sizeof(int) * LISTENER_COUNT);
+
+	if (dataSize != sizeof(magic) || std::memcmp(magic, HANDOVER_MAGIC, sizeof(magic)) != 0)
+	{
+		LOG(Log::log("Handover failed - bad handover message");)
+		for (auto listenerFD : listenerFDs)
+			::close(listenerFD);
+		return false;
+	}
+	DEBUG_LOG(Log::log("Listening sockets received");)
+	return true;
+}
+
+int Handover::openListener(const std::string& path)
+{
+	sockaddr_un address;
+	if (!mMakeAddress(path, address))
+	{
+		LOG(Log::log("Invalid handover path - ", path);)
+		return -1;
+	}
+
+	auto listenFD = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (listenFD == -1)
+		return -1;
+
+	::unlink(address.sun_path);
+	if (::bind(listenFD, (sockaddr*)&address, sizeof(address)) == -1 || ::listen(listenFD, 1) == -1)
+	{
+		LOG(Log::log("Failed to open handover listener - ", std::strerror(errno));)
+		::close(listenFD);
+		return -1;
+	}
+	DEBUG_LOG(Log::log("Handover listener open at ", path);)
+	return listenFD;
+}
+
+bool Handover::sendListeners(int listenFD, const std::string& path, const ListenerFDs& listenerFDs)
+{
+	int unixSocket;
+	do {
+		unixSocket = ::accept(listenFD, nullptr, nullptr);
+	} while (unixSocket == -1 && errno == EINTR);
+
+	::unlink(path.c_str());
+	::close(listenFD);
+	if (unixSocket == -1)
+	{
+		LOG(Log::log("Handover listener failed - ", std::strerror(errno));)
+		return false;
+	}
+	DEBUG_LOG(Log::log("New RTDS connected for handover");)
+
+	char magic[] = HANDOVER_MAGIC;
+	alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * LISTENER_COUNT)];
+	std::memset(control, 0, sizeof(control));
+	iovec ioVector = { magic, sizeof(magic) };
+	msghdr handoverMsg = {};
+	handoverMsg.msg_iov = &ioVector;
+	handoverMsg.msg_iovlen = 1;
+	handoverMsg.msg_control = control;
+	handoverMsg.msg_controllen = sizeof(control);
+
+	auto ctrlMsg = CMSG_FIRSTHDR(&handoverMsg);
+	ctrlMsg->cmsg_level = SOL_SOCKET;
+	ctrlMsg->cmsg_type = SCM_RIGHTS;
+	ctrlMsg->cmsg_len = CMSG_LEN(sizeof(int) * LISTENER_COUNT);
+	std::memcpy(CMSG_DATA(ctrlMsg), listenerFDs.data(), sizeof(int) * LISTENER_COUNT);
+
+	auto dataSize = ::sendmsg(unixSocket, &handoverMsg, MSG_NOSIGNAL);
+	::close(unixSocket);
+	if (dataSize != sizeof(magic))
+	{
+		LOG(Log::log("Failed to send listening sockets - ", std::strerror(errno));)
+		return false;
+	}
+	DEBUG_LOG(Log::log("Listening sockets handed over");)
+	return true;
+}
+#endif
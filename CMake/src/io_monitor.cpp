@@ -0,0 +1,118 @@
+#include "io_monitor.h"
+#include <asio/post.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+std::vector<std::unique_ptr<IOmonitor::Thread>> IOmonitor::mThreads;
+std::mutex IOmonitor::mThreadLock;
+std::atomic<LatencyTick> IOmonitor::mProbeTick;
+std::atomic<LatencyTick> IOmonitor::mLastLag;
+
+IOmonitor::Thread* IOmonitor::mRegisterThread()
+{
+	auto thread = std::make_unique<Thread>();
+	thread->handlers.store(0, std::memory_order_relaxed);
+	thread->startTick = Latency::now();
+#ifdef _WIN32
+	thread->threadHandle = ::OpenThread(THREAD_QUERY_LIMITED_INFORMATION, FALSE, ::GetCurrentThreadId());
+	thread->hasCPUclock = thread->threadHandle != nullptr;
+#else
+	thread->hasCPUclock = ::pthread_getcpuclockid(::pthread_self(), &thread->cpuClock) == 0;
+#endif
+
+	std::lock_guard<std::mutex> lock(mThreadLock);
+	mThreads.push_back(std::move(thread));
+	return mThreads.back().get();
+}
+
+void IOmonitor::mUnregisterThread(const Thread* thread)
+{
+	std::lock_guard<std::mutex> lock(mThreadLock);
+	auto found = std::find_if(mThreads.begin(), mThreads.end(),
+		[thread](const std::unique_ptr<Thread>& registered) { return registered.get() == thread; });
+	if (found == mThreads.end())
+		return;
+#ifdef _WIN32
+	if ((*found)->threadHandle != nullptr)
+		::CloseHandle((*found)->threadHandle);
+#endif
+	mThreads.erase(found);
+}
+
+LatencyTick IOmonitor::mCPUtime(const Thread& thread)
+{
+	if (!thread.hasCPUclock)
+		return 0;
+#ifdef _WIN32
+	FILETIME creationTime, exitTime, kernelTime, userTime;
+	if (!::GetThreadTimes(thread.threadHandle, &creationTime, &exitTime, &kernelTime, &userTime))
+		return 0;
+	auto toTicks = [](const FILETIME& time) { return ((LatencyTick)time.dwHighDateTime << 32 | time.dwLowDateTime) * 100; };
+	return toTicks(kernelTime) + toTicks(userTime);
+#else
+	timespec cpuTime;
+	if (::clock_gettime(thread.cpuClock, &cpuTime) != 0)
+		return 0;
+	return (LatencyTick)cpuTime.tv_sec * 1000000000 + cpuTime.tv_nsec;
+#endif
+}
+
+void IOmonitor::run(asio::io_context& ioContext, asio::error_code& ec)
+{
+	auto thread = mRegisterThread();
+	auto& handlers = thread->handlers;
+	while (ioContext.run_one(ec) > 0)
+		handlers.store(handlers.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	mUnregisterThread(thread);
+}
+
+void IOmonitor::probe(asio::io_context& ioContext)
+{
+	if (mProbeTick.load() != 0)
+		return;
+	auto postedTick = Latency::now();
+	mProbeTick = postedTick;
+	asio::post(ioContext, [postedTick]()
+	{
+		mLastLag = Latency::now() - postedTick;
+		Latency::record(LatencyKind::LOOP_LAG, postedTick);
+		mProbeTick = 0;
+	});
+}
+
+LatencyTick IOmonitor::lag()
+{
+	auto probeTick = mProbeTick.load();
+	auto lastLag = mLastLag.load();
+	if (probeTick != 0)
+		return std::max(lastLag, Latency::now() - probeTick);
+	return lastLag;
+}
+
+std::string IOmonitor::generateReport()
+{
+	std::string reportStr;
+	auto now = Latency::now();
+	std::lock_guard<std::mutex> lock(mThreadLock);
+	for (std::size_t index = 0; index < mThreads.size(); index++)
+	{
+		auto& thread = *mThreads[index];
+		auto handlerCount = (unsigned long long)thread.handlers.load(std::memory_order_relaxed);
+		char threadStr[96];
+		if (!thread.hasCPUclock)
+			std::snprintf(threadStr, sizeof(threadStr), "io%u=-,-,%llu\t", (unsigned int)index, handlerCount);
+		else
+		{
+			auto busyTime = mCPUtime(thread);
+			auto waitTime = std::max<LatencyTick>(now - thread.startTick - busyTime, 0);
+			std::snprintf(threadStr, sizeof(threadStr), "io%u=%.3f,%.3f,%llu\t", (unsigned int)index, busyTime / 1e9,
+				waitTime / 1e9, handlerCount);
+		}
+		reportStr += threadStr;
+	}
+	return reportStr;
+}
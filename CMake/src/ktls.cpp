@@ -0,0 +1,107 @@
+#include "ktls.h"
+#ifdef RTDS_KTLS
+#include <asio/bind_executor.hpp>
+#include <asio/post.hpp>
+#include "log.h"
+
+void KernelTLS::configure(asio::ssl::context& sslContext)
+{
+	::SSL_CTX_set_options(sslContext.native_handle(), SSL_OP_ENABLE_KTLS | SSL_OP_NO_RENEGOTIATION);
+}
+
+BIO* KernelTLS::mUseSocketBIOs(SSLsocket& sslSocket)
+{
+	auto socketFD = (int)sslSocket.lowest_layer().native_handle();
+	auto readBIO = ::BIO_new_fd(socketFD, BIO_NOCLOSE);
+	auto writeBIO = ::BIO_new_socket(socketFD, BIO_NOCLOSE);
+	asio::error_code ec;
+	if (readBIO != nullptr && writeBIO != nullptr)
+		sslSocket.lowest_layer().non_blocking(true, ec);
+	if (readBIO == nullptr || writeBIO == nullptr || ec)
+	{
+		DEBUG_LOG_AT(TLS, Log::log("Kernel TLS socket BIO not created");)
+		::BIO_free(readBIO);
+		::BIO_free(writeBIO);
+		return nullptr;
+	}
+
+	auto sslHandle = sslSocket.native_handle();
+	auto streamBIO = ::SSL_get_rbio(sslHandle);
+	::BIO_up_ref(streamBIO);
+	::SSL_set0_rbio(sslHandle, readBIO);
+	::SSL_set0_wbio(sslHandle, writeBIO);
+	return streamBIO;
+}
+
+void KernelTLS::mHandshakeStep(SSLsocket& sslSocket, BIO* streamBIO, const HandshakeStrand& strand, HandshakeHandler handler)
+{
+	auto sslHandle = sslSocket.native_handle();
+	::ERR_clear_error();
+	auto result = ::SSL_accept(sslHandle);
+	auto sslError = ::SSL_get_error(sslHandle, result);
+	if (sslError == SSL_ERROR_WANT_READ || sslError == SSL_ERROR_WANT_WRITE)
+	{
+		auto waitType = sslError == SSL_ERROR_WANT_READ ? asio::socket_base::wait_read : asio::socket_base::wait_write;
+		sslSocket.lowest_layer().async_wait(waitType, asio::bind_executor(strand,
+			[&sslSocket, streamBIO, strand, handler](const asio::error_code& ec)
+		{
+			if (ec)
+				mFinishHandshake(sslSocket, streamBIO, ec, handler);
+			else
+				mHandshakeStep(sslSocket, streamBIO, strand, handler);
+		}));
+		return;
+	}
+
+	asio::error_code ec;
+	if (result != 1)
+	{
+		auto errorCode = ::ERR_get_error();
+		if (errorCode != 0)
+			ec = asio::error_code((int)errorCode, asio::error::get_ssl_category());
+		else
+			ec = asio::error::connection_reset;
+	}
+	mFinishHandshake(sslSocket, streamBIO, ec, handler);
+}
+
+void KernelTLS::mFinishHandshake(SSLsocket& sslSocket, BIO* streamBIO, const asio::error_code& ec, const HandshakeHandler& handler)
+{
+	::SSL_set0_rbio(sslSocket.native_handle(), streamBIO);
+	asio::error_code blockingEc;
+	sslSocket.lowest_layer().non_blocking(false, blockingEc);
+	handler(ec);
+}
+
+void KernelTLS::handshake(SSLsocket& sslSocket, const HandshakeStrand& strand, HandshakeHandler handler)
+{
+	BIO* streamBIO = nullptr;
+	if (::SSL_get_options(sslSocket.native_handle()) & SSL_OP_ENABLE_KTLS)
+		streamBIO = mUseSocketBIOs(sslSocket);
+	if (streamBIO == nullptr)
+	{
+		sslSocket.async_handshake(asio::ssl::stream_base::server, asio::bind_executor(strand, handler));
+		return;
+	}
+	asio::post(strand, [&sslSocket, streamBIO, strand, handler]()
+	{
+		mHandshakeStep(sslSocket, streamBIO, strand, handler);
+	});
+}
+
+bool KernelTLS::enableTX(SSLsocket& sslSocket)
+{
+	auto sslHandle = sslSocket.native_handle();
+	auto writeBIO = ::SSL_get_wbio(sslHandle);
+	auto streamBIO = ::SSL_get_rbio(sslHandle);
+	if (writeBIO == streamBIO)
+		return false;
+	if (BIO_get_ktls_send(writeBIO))
+		return true;
+
+	DEBUG_LOG_AT(TLS, Log::log("Kernel TLS not available for ", ::SSL_get_cipher_name(sslHandle));)
+	::BIO_up_ref(streamBIO);
+	::SSL_set0_wbio(sslHandle, streamBIO);
+	return false;
+}
+#endif
@@ -0,0 +1,97 @@
+#include "latency.h"
+#include <cstdio>
+
+std::vector<Latency::Shard*> Latency::mShards;
+std::mutex Latency::mShardLock;
+
+const std::string Latency::NAME[] =
+{
+	"tcp_command",
+	"udp_command",
+	"ssl_command",
+	"fanout",
+	"loop_lag"
+};
+
+Latency::Shard* Latency::mRegisterShard()
+{
+	auto shard = new Shard();
+	for (auto& histogram : shard->counts)
+	{
+		for (auto& count : histogram)
+			count.store(0, std::memory_order_relaxed);
+	}
+	for (auto& sum : shard->sums)
+		sum.store(0, std::memory_order_relaxed);
+
+	std::lock_guard<std::mutex> shardLock(mShardLock);
+	mShards.push_back(shard);
+	return shard;
+}
+
+std::uint64_t Latency::mBucketMax(const std::size_t bucket)
+{
+	if (bucket < SUB_COUNT)
+		return bucket;
+	auto shift = bucket / SUB_COUNT - 1;
+	auto lowest = (SUB_COUNT + bucket % SUB_COUNT) << shift;
+	return lowest + (std::uint64_t(1) << shift) - 1;
+}
+
+std::uint64_t Latency::merge(const LatencyKind kind, std::vector<std::uint64_t>& buckets)
+{
+	std::uint64_t sum = 0;
+	buckets.assign(BUCKET_COUNT, 0);
+	std::lock_guard<std::mutex> shardLock(mShardLock);
+	for (auto shard : mShards)
+	{
+		auto& histogram = shard->counts[(std::size_t)kind];
+		for (std::size_t bucket = 0; bucket < BUCKET_COUNT; bucket++)
+			buckets[bucket] += histogram[bucket].load(std::memory_order_relaxed);
+		sum += shard->sums[(std::size_t)kind].load(std::memory_order_relaxed);
+	}
+	return sum;
+}
+
+const std::string& Latency::name(const LatencyKind kind)
+{
+	return NAME[(std::size_t)kind];
+}
+
+std::string Latency::summary(const LatencyKind kind)
+{
+	static const double PERCENTILE[] = { 0.5, 0.9, 0.99, 0.999, 1.0 };
+
+	std::vector<std::uint64_t> buckets;
+	merge(kind, buckets);
+	std::uint64_t total = 0;
+	for (auto count : buckets)
+		total += count;
+
+	std::string summaryStr = NAME[(std::size_t)kind] + "=" + std::to_string(total);
+	std::size_t bucket = 0;
+	std::uint64_t seen = 0;
+	for (auto percentile : PERCENTILE)
+	{
+		auto rank = (std::uint64_t)(percentile * total + 0.5);
+		if (rank == 0)
+			rank = 1;
+		while (total > 0 && bucket < BUCKET_COUNT && seen + buckets[bucket] < rank)
+			seen += buckets[bucket++];
+		auto latency = (total > 0) ? mBucketMax(bucket) : 0;
+		char latencyStr[32];
+		std::snprintf(latencyStr, sizeof(latencyStr), ",%.1f", latency / 1000.0);
+		summaryStr += latencyStr;
+	}
+	return summaryStr;
+}
+
+std::string Latency::generateReport()
+{
+	static_assert(sizeof(NAME) / sizeof(std::string) == LATENCY_KIND_COUNT, "Histogram name missing");
+
+	std::string reportStr;
+	for (short kind = 0; kind < LATENCY_KIND_COUNT; kind++)
+		reportStr += summary((LatencyKind)kind) + "\t";
+	return reportStr;
+}
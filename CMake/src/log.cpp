@@ -1,40 +1,216 @@
+#include "common.h"
 #include "log.h"
-#include <chrono>
+#include <algorithm>
 #include <ctime>
-#include <iomanip>
+#include <iostream>
 
+const std::string Log::LEVEL_NAME[] =
+{
+	"off",
+	"critical",
+	"debug"
+};
+const std::string Log::CATEGORY_NAME[] =
+{
+	"general",
+	"accept",
+	"bg",
+	"fanout",
+	"udp",
+	"ccm",
+	"tls"
+};
+
+#ifdef NDEBUG
+std::atomic<std::uint32_t> Log::mEnabled((std::uint32_t(1) << LOG_CATEGORY_COUNT) - 1);	// Critical logs only
+#else
+std::atomic<std::uint32_t> Log::mEnabled((std::uint32_t(1) << (2 * LOG_CATEGORY_COUNT)) - 1);	// All logs
+#endif
+std::vector<std::unique_ptr<Log::Ring>> Log::mRings;
+std::mutex Log::mRingLock;
 std::atomic_bool Log::mCanLog;
-std::mutex Log::mWriteLock;
-std::ofstream Log::mLogFile;
+std::atomic_bool Log::mWriterRunning;
+std::thread Log::mWriter;
+std::FILE* Log::mLogFile = nullptr;
+std::atomic<std::uint64_t> Log::mDropCount;
 
 void Log::startLog()
 {
-	std::lock_guard<std::mutex> lock(mWriteLock);
-	try {
-		mLogFile.open("log.txt", std::ios::out);
+	std::lock_guard<std::mutex> lock(mRingLock);
+	if (mLogFile != nullptr)
+		return;
+	mLogFile = std::fopen("log.txt", "w");
+	if (mLogFile == nullptr)
+	{
+		std::cerr << "Logging failed";
+		mCanLog = false;
+		return;
+	}
+
+	const auto currTime = std::time(NULL);
+	char strTime[32];
+	std::strftime(strTime, sizeof(strTime), "%F %T", std::localtime(&currTime));
+	std::fprintf(mLogFile, "Log started at : %s\n", strTime);
+	std::fflush(mLogFile);
 
-		const auto currTime = std::time(NULL);
-		auto strTime = std::put_time(std::localtime(&currTime), "%F %T");
-		mLogFile << "Log started at : " << strTime << std::endl;
+	mWriterRunning = true;
+	try {
+		mWriter = std::thread(&Log::mWriterRoutine);
 	}
-	catch (...)
+	catch (const std::system_error&)
 	{
 		std::cerr << "Logging failed";
-		mCanLog = false;
+		mWriterRunning = false;
+		std::fclose(mLogFile);
+		mLogFile = nullptr;
+		return;
 	}
 	mCanLog = true;
 }
 
 void Log::stopLog()
 {
-	if (mCanLog)
+	if (mCanLog.exchange(false))
 	{
-		mCanLog = false;
-		mLogFile.close();
+		mWriterRunning = false;
+		if (mWriter.joinable())
+			mWriter.join();
+		std::lock_guard<std::mutex> lock(mRingLock);
+		std::fclose(mLogFile);
+		mLogFile = nullptr;
 	}
 }
 
 bool Log::isLogging()
 {
 	return mCanLog;
-}
\ No newline at end of file
+}
+
+bool Log::setLevel(const std::string_view& levelName, const std::string_view& categoryName)
+{
+	static_assert(sizeof(LEVEL_NAME) / sizeof(std::string) == LOG_LEVEL_COUNT, "Log level name missing");
+	static_assert(sizeof(CATEGORY_NAME) / sizeof(std::string) == LOG_CATEGORY_COUNT, "Log category name missing");
+
+	auto level = std::find(LEVEL_NAME, LEVEL_NAME + LOG_LEVEL_COUNT, levelName) - LEVEL_NAME;
+	if (level == LOG_LEVEL_COUNT)
+		return false;
+
+	std::uint32_t categoryMask = 0, levelMask = 0;
+	for (short category = 0; category < LOG_CATEGORY_COUNT; category++)
+	{
+		if (!categoryName.empty() && categoryName != CATEGORY_NAME[category])
+			continue;
+		for (short enabledLevel = 1; enabledLevel < LOG_LEVEL_COUNT; enabledLevel++)
+		{
+			auto bit = mBit((LogLevel)enabledLevel, (LogCategory)category);
+			categoryMask |= bit;
+			if (enabledLevel <= level)
+				levelMask |= bit;
+		}
+	}
+	if (categoryMask == 0)
+		return false;
+
+	auto enabled = mEnabled.load(std::memory_order_relaxed);
+	while (!mEnabled.compare_exchange_weak(enabled, (enabled & ~categoryMask) | levelMask, std::memory_order_relaxed));
+	return true;
+}
+
+std::string Log::generateLevels()
+{
+	std::string levels;
+	for (short category = 0; category < LOG_CATEGORY_COUNT; category++)
+	{
+		short level = 0;
+		while (level + 1 < LOG_LEVEL_COUNT && isEnabled((LogLevel)(level + 1), (LogCategory)category))
+			level++;
+		levels += CATEGORY_NAME[category] + "=" + LEVEL_NAME[level] + "\t";
+	}
+	return levels;
+}
+
+std::uint64_t Log::droppedCount()
+{
+	std::lock_guard<std::mutex> lock(mRingLock);
+	std::uint64_t dropCount = 0;
+	for (auto& ring : mRings)
+		dropCount += ring->dropped.load(std::memory_order_relaxed);
+	return dropCount;
+}
+
+Log::Ring* Log::mRegisterRing()
+{
+	auto ring = std::make_unique<Ring>();
+	ring->head = 0;
+	ring->tail = 0;
+	ring->dropped = 0;
+
+	std::lock_guard<std::mutex> lock(mRingLock);
+	mRings.push_back(std::move(ring));
+	return mRings.back().get();
+}
+
+bool Log::mDrain(std::vector<Record>& batch, std::string& output)
+{
+	batch.clear();
+	std::uint64_t dropCount = 0;
+	{
+		std::lock_guard<std::mutex> lock(mRingLock);
+		for (auto& ring : mRings)
+		{
+			auto tail = ring->tail.load(std::memory_order_relaxed);
+			auto head = ring->head.load(std::memory_order_acquire);
+			for (; tail != head; tail++)
+				batch.push_back(ring->records[tail & (LOG_RING_SIZE - 1)]);
+			ring->tail.store(tail, std::memory_order_release);
+			dropCount += ring->dropped.load(std::memory_order_relaxed);
+		}
+	}
+	auto newDrops = dropCount - mDropCount.exchange(dropCount);
+	if (batch.empty() && newDrops == 0)
+		return false;
+
+	std::stable_sort(batch.begin(), batch.end(),
+		[](const Record& left, const Record& right) { return left.time < right.time; });
+
+	output.clear();
+	std::time_t lastSecond = -1;
+	char timeStr[24];
+	std::size_t secondSize = 0;
+	for (auto& record : batch)
+	{
+		std::time_t seconds = record.time / 1000000;
+		if (seconds != lastSecond)
+		{
+			lastSecond = seconds;
+			secondSize = std::strftime(timeStr, sizeof(timeStr), "%T", std::localtime(&seconds));
+		}
+		auto timeSize = secondSize + std::snprintf(timeStr + secondSize, sizeof(timeStr) - secondSize,
+			".%06d ", (int)(record.time % 1000000));
+		output.append(timeStr, timeSize);
+		output.append(record.text, record.size);
+		output += '\n';
+	}
+	if (newDrops > 0)
+		output += "Log records dropped: " + std::to_string(newDrops) + "\n";
+
+	std::fwrite(output.data(), 1, output.size(), mLogFile);
+	std::fflush(mLogFile);
+#ifdef OUTPUT_DEBUG_LOG
+	std::cerr.write(output.data(), output.size());
+#endif
+	return true;
+}
+
+void Log::mWriterRoutine()
+{
+	std::vector<Record> batch;
+	std::string output;
+	batch.reserve(LOG_RING_SIZE);
+	while (mWriterRunning)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(LOG_FLUSH_INTERVAL));
+		mDrain(batch, output);
+	}
+	mDrain(batch, output);
+}
@@ -10,7 +10,7 @@ int main(int argCount, const char* args[])
 		Settings::processArgument(argument);
 	}
 
-	RTDS rtdsServer(RTDS_PORT, RTDS_CCM, RTDS_START_THREAD);
+	RTDS rtdsServer(RTDS_CONFIG);
 	while (true)
 	{
 		std::this_thread::sleep_for(std::chrono::seconds(1));
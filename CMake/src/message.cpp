@@ -1,6 +1,7 @@
 #include "message.h"
 #include "common.h"
 #include "log.h"
+#include "runtime_limits.h"
 
 std::queue<Message*> Message::mMessageQ;
 std::mutex Message::mQinsLock;
@@ -11,7 +12,7 @@ bool Message::haveExpired() const
 	TimePoint timeNow = std::chrono::system_clock::now();
 	auto diffTime = std::chrono::duration_cast<std::chrono::minutes>(timeNow - mCreatedTime);
 	auto timePassed = diffTime.count();
-	if (timePassed > MIN_MSG_KEEP_TIME)
+	if (timePassed > (long long)RuntimeLimits::get(Limit::MSG_KEEP_TIME))
 		return true;
 	else
 		return false;
@@ -24,9 +25,12 @@ bool Message::insertMssg2Q(Message* message)
 		mCleanMessageQ();
 		std::lock_guard<std::mutex> lock(mQinsLock);
 		mMessageQ.push(message);
+		Metrics::add(Metric::MESSAGES);
 		return true;
 	}catch (...) {
-		LOG(Log::log("Failed to add message to Queue!");)
+		LOG_AT(FANOUT, Log::log("Failed to add message to Queue!");)
+		Metrics::add(Metric::MESSAGE_FAILS);
+		FlightRecorder::record(FlightEvent::DROP, 0, "message queue");
 		delete message;
 		return false;
 	}
@@ -36,12 +40,12 @@ void Message::mCleanMessageQ()
 {
 	if (mQremLock.try_lock())
 	{
-		while (mMessageQ.size() > MAX_MSG_CACHE_SIZE)
+		while (mMessageQ.size() > RuntimeLimits::get(Limit::MSG_CACHE_SIZE))
 		{
 			auto message = mMessageQ.front();
 			if (message->haveExpired())
 			{
-				DEBUG_LOG(Log::log("Message deleted ", message->messageBuf);)
+				DEBUG_LOG_AT(FANOUT, Log::log("Message deleted ", message->messageBuf);)
 				mMessageQ.pop();
 				delete message;
 			}
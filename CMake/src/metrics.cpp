@@ -0,0 +1,120 @@
+#include "metrics.h"
+#include "cmd_processor.h"
+#include "tls_session.h"
+#include "log.h"
+
+std::vector<Metrics::Shard*> Metrics::mShards;
+std::mutex Metrics::mShardLock;
+
+const std::string Metrics::NAME[] =
+{
+	"messages",
+	"message_fails",
+	"deliveries",
+	"delivery_fails",
+	"bytes_in",
+	"bytes_out",
+	"shed_commands",
+	"shed_accepts",
+	"quota_rejects",
+	"rate_rejects",
+	"quota_evictions",
+	"handshake_timeouts",
+	"udp_ping_limited",
+	"udp_fanout_limited",
+	"bg_count",
+	"bg_members",
+	"pending_deliveries"
+};
+
+const std::string Metrics::SOURCE[] =
+{
+	"tcp",
+	"udp",
+	"ssl",
+	"ccm"
+};
+
+Metrics::Shard* Metrics::mRegisterShard()
+{
+	auto shard = new Shard();
+	for (auto& value : shard->values)
+		value.store(0, std::memory_order_relaxed);
+
+	std::lock_guard<std::mutex> shardLock(mShardLock);
+	mShards.push_back(shard);
+	return shard;
+}
+
+std::int64_t Metrics::mSum(const std::size_t index)
+{
+	std::int64_t total = 0;
+	std::lock_guard<std::mutex> shardLock(mShardLock);
+	for (auto shard : mShards)
+		total += shard->values[index].load(std::memory_order_relaxed);
+	return total;
+}
+
+std::int64_t Metrics::value(const Metric metric)
+{
+	return mSum((std::size_t)metric);
+}
+
+std::int64_t Metrics::commandCount(const MetricSource source, const short command)
+{
+	return mSum(commandIndex(source, command));
+}
+
+void Metrics::snapshot(std::vector<std::int64_t>& values)
+{
+	values.assign(VALUE_COUNT, 0);
+	std::lock_guard<std::mutex> shardLock(mShardLock);
+	for (auto shard : mShards)
+	{
+		for (std::size_t index = 0; index < VALUE_COUNT; index++)
+			values[index] += shard->values[index].load(std::memory_order_relaxed);
+	}
+}
+
+bool Metrics::isGauge(const Metric metric)
+{
+	return metric == Metric::BG_COUNT || metric == Metric::BG_MEMBERS || metric == Metric::PENDING_DELIVERIES;
+}
+
+const std::string& Metrics::name(const Metric metric)
+{
+	return NAME[(std::size_t)metric];
+}
+
+const std::string& Metrics::name(const MetricSource source)
+{
+	return SOURCE[(std::size_t)source];
+}
+
+std::string Metrics::generateStats()
+{
+	static_assert(sizeof(NAME) / sizeof(std::string) == METRIC_COUNT, "Metric name missing");
+	static_assert(sizeof(SOURCE) / sizeof(std::string) == METRIC_SOURCE_COUNT, "Source name missing");
+
+	std::string statsStr;
+	for (short metric = 0; metric < METRIC_COUNT; metric++)
+		statsStr += NAME[metric] + "=" + std::to_string(value((Metric)metric)) + "\t";
+	statsStr += "peers=" + std::to_string(StreamPeer::globalPeerCount()) + "\t";
+	statsStr += "tls_full=" + std::to_string(TLSsession::fullCount()) + "\t";
+	statsStr += "tls_resumed=" + std::to_string(TLSsession::resumedCount()) + "\t";
+	statsStr += "log_dropped=" + std::to_string(Log::droppedCount()) + "\t";
+
+	for (short source = 0; source < METRIC_SOURCE_COUNT; source++)
+	{
+		for (short command = 0; command <= COMMAND_COUNT; command++)
+		{
+			auto count = commandCount((MetricSource)source, command);
+			if (count == 0)
+				continue;
+			statsStr += SOURCE[source] + "_";
+			statsStr += (command == COMMAND_COUNT) ? std::string("unknown") : CmdProcessor::COMM[command];
+			statsStr += "=" + std::to_string(count) + "\t";
+		}
+	}
+	return statsStr;
+}
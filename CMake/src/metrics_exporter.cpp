@@ -0,0 +1,247 @@
+#include "metrics_exporter.h"
+#include <asio/post.hpp>
+#include <asio/write.hpp>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include "cmd_processor.h"
+#include "metrics.h"
+#include "latency.h"
+#include "tls_session.h"
+#include "log.h"
+
+MetricsExporter::MetricsExporter(asio::io_context& ioContext) : mStrand(asio::make_strand(ioContext)),
+mAcceptor(mStrand), mSocket(mStrand), mDeadline(mStrand)
+{
+	mIsRunning = false;
+	mRequestSize = 0;
+	mBuildLines();
+}
+
+void MetricsExporter::mBuildLines()
+{
+	for (short metric = 0; metric < METRIC_COUNT; metric++)
+	{
+		auto metricName = "rtds_" + Metrics::name((Metric)metric);
+		if (Metrics::isGauge((Metric)metric))
+			mValueLines.push_back("# TYPE " + metricName + " gauge\n" + metricName + " ");
+		else
+			mValueLines.push_back("# TYPE " + metricName + "_total counter\n" + metricName + "_total ");
+	}
+
+	std::string typeLine = "# TYPE rtds_commands_total counter\n";
+	for (short source = 0; source < METRIC_SOURCE_COUNT; source++)
+	{
+		for (short command = 0; command <= COMMAND_COUNT; command++)
+		{
+			auto commandName = (command == COMMAND_COUNT) ? std::string("unknown") : CmdProcessor::COMM[command];
+			mValueLines.push_back(typeLine + "rtds_commands_total{source=\"" + Metrics::name((MetricSource)source)
+				+ "\",command=\"" + commandName + "\"} ");
+			typeLine.clear();
+		}
+	}
+	mValueLines.push_back("# TYPE rtds_peers gauge\nrtds_peers ");
+	mValueLines.push_back("# TYPE rtds_tls_handshakes_total counter\nrtds_tls_handshakes_total{type=\"full\"} ");
+	mValueLines.push_back("rtds_tls_handshakes_total{type=\"resumed\"} ");
+	mValueLines.push_back("# TYPE rtds_log_dropped_total counter\nrtds_log_dropped_total ");
+
+	for (auto bound = EXPORTER_FIRST_BUCKET; bound <= EXPORTER_LAST_BUCKET; bound++)
+	{
+		char boundStr[32];
+		std::snprintf(boundStr, sizeof(boundStr), "%.9g", (double)(std::uint64_t(1) << bound) / 1e9);
+		mBucketLabels.push_back(std::string(",le=\"") + boundStr + "\"} ");
+	}
+
+	typeLine = "# TYPE rtds_latency_seconds histogram\n";
+	for (short kind = 0; kind < LATENCY_KIND_COUNT; kind++)
+	{
+		auto kindLabel = "{kind=\"" + Latency::name((LatencyKind)kind) + "\"";
+		for (auto& bucketLabel : mBucketLabels)
+		{
+			mValueLines.push_back(typeLine + "rtds_latency_seconds_bucket" + kindLabel + bucketLabel);
+			typeLine.clear();
+		}
+		mValueLines.push_back("rtds_latency_seconds_bucket" + kindLabel + ",le=\"+Inf\"} ");
+		mValueLines.push_back("rtds_latency_seconds_sum" + kindLabel + "} ");
+		mValueLines.push_back("rtds_latency_seconds_count" + kindLabel + "} ");
+	}
+}
+
+void MetricsExporter::mAppend(const std::int64_t value)
+{
+	char valueStr[24];
+	auto result = std::to_chars(valueStr, valueStr + sizeof(valueStr), value);
+	mBody.append(valueStr, result.ptr - valueStr);
+	mBody += '\n';
+}
+
+void MetricsExporter::mAppend(const double value)
+{
+	char valueStr[32];
+	auto size = std::snprintf(valueStr, sizeof(valueStr), "%.9g\n", value);
+	mBody.append(valueStr, size);
+}
+
+void MetricsExporter::mRender()
+{
+	mBody.clear();
+	auto line = mValueLines.begin();
+
+	Metrics::snapshot(mValues);
+	for (auto value : mValues)
+	{
+		mBody += *line++;
+		mAppend(value);
+	}
+	mBody += *line++;
+	mAppend((std::int64_t)StreamPeer::globalPeerCount());
+	mBody += *line++;
+	mAppend((std::int64_t)TLSsession::fullCount());
+	mBody += *line++;
+	mAppend((std::int64_t)TLSsession::resumedCount());
+	mBody += *line++;
+	mAppend((std::int64_t)Log::droppedCount());
+
+	for (short kind = 0; kind < LATENCY_KIND_COUNT; kind++)
+	{
+		auto sum = Latency::merge((LatencyKind)kind, mBuckets);
+		std::uint64_t total = 0;
+		std::size_t bucket = 0;
+		for (auto bound = EXPORTER_FIRST_BUCKET; bound <= EXPORTER_LAST_BUCKET; bound++)
+		{
+			auto boundBucket = Latency::bucket(std::uint64_t(1) << bound);
+			for (; bucket < boundBucket; bucket++)
+				total += mBuckets[bucket];
+			mBody += *line++;
+			mAppend((std::int64_t)total);
+		}
+		for (; bucket < mBuckets.size(); bucket++)
+			total += mBuckets[bucket];
+		mBody += *line++;
+		mAppend((std::int64_t)total);
+		mBody += *line++;
+		mAppend(sum / 1e9);
+		mBody += *line++;
+		mAppend((std::int64_t)total);
+	}
+}
+
+void MetricsExporter::start(const asio::ip::tcp::endpoint& endpoint)
+{
+	asio::error_code ec;
+	mAcceptor.open(endpoint.protocol(), ec);
+	if (!ec)
+		mAcceptor.set_option(asio::ip::tcp::acceptor::reuse_address(true), ec);
+#ifdef SO_REUSEPORT
+	if (!ec)
+		mAcceptor.set_option(asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>(true), ec);
+#endif
+	if (!ec)
+		mAcceptor.bind(endpoint, ec);
+	if (!ec)
+		mAcceptor.listen(asio::socket_base::max_listen_connections, ec);
+	if (ec)
+		throw ec;
+
+	mIsRunning = true;
+	asio::post(mStrand, std::bind(&MetricsExporter::mAccept, this));
+}
+
+void MetricsExporter::stop()
+{
+	asio::post(mStrand, [this]()
+	{
+		asio::error_code ec;
+		mIsRunning = false;
+		mAcceptor.close(ec);
+		mSocket.close(ec);
+		mDeadline.cancel();
+	});
+}
+
+void MetricsExporter::mAccept()
+{
+	if (mIsRunning)
+		mAcceptor.async_accept(mSocket, std::bind(&MetricsExporter::mAcceptFeedbk, this, std::placeholders::_1));
+}
+
+void MetricsExporter::mAcceptFeedbk(const asio::error_code& ec)
+{
+	if (ec)
+	{
+		DEBUG_LOG(Log::log("Metrics exporter accept failed - ", ec.message());)
+		mAccept();
+		return;
+	}
+	mRequestSize = 0;
+	mDeadline.expires_after(std::chrono::seconds(EXPORTER_TIMEOUT));
+	mDeadline.async_wait(std::bind(&MetricsExporter::mDeadlineFeedbk, this, std::placeholders::_1));
+	mReadRequest();
+}
+
+void MetricsExporter::mReadRequest()
+{
+	mSocket.async_read_some(asio::buffer(mRequest.data() + mRequestSize, mRequest.size() - mRequestSize),
+		std::bind(&MetricsExporter::mReadFeedbk, this, std::placeholders::_1, std::placeholders::_2));
+}
+
+void MetricsExporter::mReadFeedbk(const asio::error_code& ec, std::size_t dataSize)
+{
+	if (ec)
+	{
+		mFinish();
+		return;
+	}
+	mRequestSize += dataSize;
+	std::string_view request(mRequest.data(), mRequestSize);
+	if (request.find("\r\n\r\n") == std::string_view::npos && request.find("\n\n") == std::string_view::npos)
+	{
+		if (mRequestSize < mRequest.size())
+			mReadRequest();
+		else
+			mFinish();
+		return;
+	}
+
+	if (request.rfind("GET /metrics ", 0) == 0 || request.rfind("GET /metrics?", 0) == 0)
+	{
+		mRender();
+		mHeader = "HTTP/1.1 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: ";
+	}
+	else
+	{
+		mBody = "Not Found\n";
+		mHeader = "HTTP/1.1 404 Not Found\r\nContent-Type: text/plain\r\nContent-Length: ";
+	}
+	mHeader += std::to_string(mBody.size());
+	mHeader += "\r\nConnection: close\r\n\r\n";
+
+	std::array<asio::const_buffer, 2> response = { asio::buffer(mHeader), asio::buffer(mBody) };
+	asio::async_write(mSocket, response, std::bind(&MetricsExporter::mWriteFeedbk, this, std::placeholders::_1));
+}
+
+void MetricsExporter::mWriteFeedbk(const asio::error_code& ec)
+{
+	if (ec)
+	{	DEBUG_LOG(Log::log("Metrics exporter write failed - ", ec.message());)	}
+	mFinish();
+}
+
+void MetricsExporter::mDeadlineFeedbk(const asio::error_code& ec)
+{
+	if (ec != asio::error::operation_aborted && mDeadline.expiry() <= std::chrono::steady_clock::now())
+	{
+		asio::error_code closeEc;
+		mSocket.close(closeEc);
+	}
+}
+
+void MetricsExporter::mFinish()
+{
+	asio::error_code ec;
+	mSocket.shutdown(asio::ip::tcp::socket::shutdown_both, ec);
+	mSocket.close(ec);
+	mDeadline.cancel();
+	mAccept();
+}
@@ -1,45 +1,93 @@
 ﻿#include "rtds.h"
 #include <thread>
 #include <functional>
+#include <asio/post.hpp>
 #include "cmd_processor.h"
+#include "rtds_settings.h"
 #include "log.h"
 
 #include "udp_peer.h"
 #include "tcp_peer.h"
+#include "ssl_peer.h"
 #include "ssl_ccm.h"
+#include "object_pool.h"
+#include "tls_session.h"
+#include "tls_context.h"
+#include "metrics.h"
+#include "latency.h"
+#include "flight_recorder.h"
+#include "capture.h"
+#include "io_monitor.h"
+#include "admission.h"
+#include "connection_quota.h"
+#include "udp_limiter.h"
 
 #ifdef RTDS_DUAL_STACK
-RTDS::RTDS(const unsigned short portNumber, const unsigned short ccmPort, short threadCount) : mTCPep(asio::ip::tcp::v6(), portNumber),
-mUDPep(asio::ip::udp::v6(), portNumber), mUDPsock(mIOcontext), mTCPacceptor(mIOcontext), mIOworker(mIOcontext), 
-mCCMcontext(asio::ssl::context::sslv23), mCCMep(asio::ip::tcp::v6(), ccmPort), mCCMacceptor(mIOcontext), 
-mSSLcontext(asio::ssl::context::sslv23), mSSLep(asio::ip::tcp::v6(), portNumber + 1), mSSLacceptor(mIOcontext)
+RTDS::RTDS(const ServerConfig& config) : mTCPep(asio::ip::tcp::v6(), config.portNumber),
+mUDPep(asio::ip::udp::v6(), config.portNumber), mUDPsock(mIOcontext), mTCPacceptor(mIOcontext), mIOworker(mIOcontext), 
+mCCMep(asio::ip::tcp::v6(), config.ccmPort), mCCMacceptor(mIOcontext), 
+mSSLep(asio::ip::tcp::v6(), config.portNumber + 1), mSSLacceptor(mIOcontext),
+mMetricsPort(config.metricsPort), mMetricsAddress(config.metricsAddress), mMetricsExporter(mIOcontext), mHandshakePool(HANDSHAKE_THREAD_COUNT), mHandoverPath(config.handoverPath)
 #else 
-RTDS::RTDS(const unsigned short portNumber, const unsigned short ccmPort, short threadCount) : mTCPep(asio::ip::tcp::v4(), portNumber),
-mUDPep(asio::ip::udp::v4(), portNumber), mUDPsock(mIOcontext), mTCPacceptor(mIOcontext), mIOworker(mIOcontext), 
-mCCMcontext(asio::ssl::context::sslv23), mCCMep(asio::ip::tcp::v4(), ccmPort), mCCMacceptor(mIOcontext), 
-mSSLcontext(asio::ssl::context::sslv23), mSSLep(asio::ip::tcp::v4(), portNumber + 1), mSSLacceptor(mIOcontext)
+RTDS::RTDS(const ServerConfig& config) : mTCPep(asio::ip::tcp::v4(), config.portNumber),
+mUDPep(asio::ip::udp::v4(), config.portNumber), mUDPsock(mIOcontext), mTCPacceptor(mIOcontext), mIOworker(mIOcontext), 
+mCCMep(asio::ip::tcp::v4(), config.ccmPort), mCCMacceptor(mIOcontext), 
+mSSLep(asio::ip::tcp::v4(), config.portNumber + 1), mSSLacceptor(mIOcontext),
+mMetricsPort(config.metricsPort), mMetricsAddress(config.metricsAddress), mMetricsExporter(mIOcontext), mHandshakePool(HANDSHAKE_THREAD_COUNT), mHandoverPath(config.handoverPath)
 #endif
 {
 	START_LOG
+	FlightRecorder::installCrashHandler();
 	DEBUG_LOG(Log::log("............... RTDS Log ..............");)
-	DEBUG_LOG(Log::log("RTDS Port : ", portNumber);)
+	DEBUG_LOG(Log::log("RTDS Port : ", config.portNumber);)
+	if (!config.capturePath.empty())
+	{
+		if (Capture::start(config.capturePath))
+		{
+			LOG(Log::log("Capturing the commands to ", config.capturePath);)
+		}
+		else
+		{
+			LOG(Log::log("Failed to open the capture file ", config.capturePath);)
+		}
+	}
+	Admission::setLimits(config.maxLoopLag, config.maxPending);
+	ConnectionQuota::setLimits(config.maxSourceConnections, config.sourceConnectRate);
+	UDPlimiter::setLimits(config.udpPingRate, config.udpFanoutRate);
 	mThreadCount = 0;
-	mAddthread(threadCount);
+	mPendingSSLhandshakes = 0;
+	mPendingCCMhandshakes = 0;
+	mInheritedFDs.fill(-1);
+#ifdef RTDS_HANDOVER
+	mListenerRunning.fill(false);
+#endif
+	mWarmPools(config.warmPoolSize);
+	mAddthread(config.threadCount);
+	mTakeOverListeners();
+	mConfigTLScontexts();
 	mConfigTCPserver();
 	mConfigUDPserver();
 	mConfigSSLserver();
 	mConfigCCMserver();
+	mConfigMetricsServer();
 	mStartServer();
 }
 
 RTDS::~RTDS()
 {
 	mStopServer();
+	mHandshakePool.stop();
 	mIOcontext.stop();
 	do {
 		std::this_thread::sleep_for(std::chrono::milliseconds(100));
 	} while (!mIOcontext.stopped() && mThreadCount == 0);
 
+	if (Capture::isCapturing())
+	{
+		Capture::stop();
+		LOG(Log::log("Capture stopped, commands dropped: ", Capture::droppedCount());)
+	}
+	FlightRecorder::waitForDump();
 	DEBUG_LOG(Log::log("RTDS Exiting [Logging stopped]");)
 	STOP_LOG
 }
@@ -47,6 +95,9 @@ RTDS::~RTDS()
 void RTDS::mStartServer()
 {
 	mServerRunning = true;
+#ifdef RTDS_HANDOVER
+	Handover::installWakeSignal();
+#endif
 	try {
 		std::thread ioThreadLR(&RTDS::mUDPlistenRoutine, this);
 		std::thread ioThreadAR(&RTDS::mTCPacceptRoutine, this);
@@ -57,6 +108,26 @@ void RTDS::mStartServer()
 		ioThreadCR.detach();
 		ioThreadSR.detach();
 		DEBUG_LOG(Log::log("New thread to UDP, TCP, SSL & CCM routines");)
+		if (TLS_WATCH_INTERVAL > 0)
+		{
+			std::thread ioThreadWR(&RTDS::mTLSwatchRoutine, this);
+			ioThreadWR.detach();
+			DEBUG_LOG(Log::log("New thread to TLS watch routine");)
+		}
+		if (IO_PROBE_INTERVAL > 0)
+		{
+			std::thread ioThreadPR(&RTDS::mIOprobeRoutine, this);
+			ioThreadPR.detach();
+			DEBUG_LOG(Log::log("New thread to IO probe routine");)
+		}
+#ifdef RTDS_HANDOVER
+		if (!mHandoverPath.empty())
+		{
+			std::thread ioThreadHR(&RTDS::mHandoverRoutine, this);
+			ioThreadHR.detach();
+			DEBUG_LOG(Log::log("New thread to handover routine");)
+		}
+#endif
 	}
 	catch (const std::runtime_error& ec)
 	{
@@ -67,8 +138,11 @@ void RTDS::mStartServer()
 
 void RTDS::mStopServer()
 {
-	mServerRunning = false;
+	if (!mServerRunning.exchange(false))
+		return;
 	DEBUG_LOG(Log::log("Server stopping, canceling and closing sockets...");)
+	mWakeAcceptRoutines();
+	mWakeListeners();
 	try {
 		mUDPsock.cancel();
 		mUDPsock.close();
@@ -82,22 +156,60 @@ void RTDS::mStopServer()
 		mCCMacceptor.cancel();
 		mCCMacceptor.close();
 		DEBUG_LOG(Log::log("CCM acceptor closed");)
+		mMetricsExporter.stop();
+		DEBUG_LOG(Log::log("Metrics exporter stopped");)
 	}
 	catch (const asio::error_code& ec)
 	{	DEBUG_LOG(Log::log("Failed to close sockets - ", ec.message());)	}
 	DEBUG_LOG(Log::log("Server sockets closed");)
 }
 
+void RTDS::mConfigTLScontexts()
+{
+	DEBUG_LOG(Log::log("TLS contexts configuring...");)
+	if (!TLScontext::load())
+	{
+		LOG(Log::log("Failed to configure TLS contexts");)
+		exit(0);
+	}
+	DEBUG_LOG(Log::log("TLS contexts configured");)
+}
+
+void RTDS::mConfigMetricsServer()
+{
+	if (mMetricsPort == 0)
+		return;
+	DEBUG_LOG(Log::log("Metrics server configuring...");)
+	try {
+		asio::error_code ec;
+		auto metricsAddress = asio::ip::make_address(mMetricsAddress, ec);
+		if (ec)
+			throw ec;
+		mMetricsExporter.start(asio::ip::tcp::endpoint(metricsAddress, mMetricsPort));
+	}
+	catch (const asio::error_code& ec)
+	{
+		LOG(Log::log("Failed to configure metrics server - ", ec.message());)
+		exit(0);
+	}
+	DEBUG_LOG(Log::log("Metrics server configured");)
+}
+
 void RTDS::mConfigTCPserver()
 {
 	DEBUG_LOG(Log::log("TCP server configuring...");)
 	try {
-		mTCPacceptor.open(mTCPep.protocol());
-		DEBUG_LOG(Log::log("TCP acceptor open");)
-		mTCPacceptor.bind(mTCPep);
-		DEBUG_LOG(Log::log("TCP acceptor bound to endpoint");)
-		mTCPacceptor.listen(asio::socket_base::max_listen_connections);
-		DEBUG_LOG(Log::log("TCP acceptor started listening");)
+		if (mInheritListener(mTCPacceptor, mTCPep, Listener::TCP))
+		{	DEBUG_LOG(Log::log("TCP acceptor inherited");)	}
+		else
+		{
+			mTCPacceptor.open(mTCPep.protocol());
+			DEBUG_LOG(Log::log("TCP acceptor open");)
+			mTCPacceptor.bind(mTCPep);
+			DEBUG_LOG(Log::log("TCP acceptor bound to endpoint");)
+			mTCPacceptor.listen(asio::socket_base::max_listen_connections);
+			DEBUG_LOG(Log::log("TCP acceptor started listening");)
+		}
 	}
 	catch (const asio::error_code& ec)
 	{
@@ -111,10 +223,15 @@ void RTDS::mConfigUDPserver()
 {
 	DEBUG_LOG(Log::log("UDP socket configuring...");)
 	try {
-		mUDPsock.open(mUDPep.protocol());
-		DEBUG_LOG(Log::log("UDP acceptor open");)
-		mUDPsock.bind(mUDPep);
-		DEBUG_LOG(Log::log("UDP acceptor bound to endpoint");)
+		if (mInheritListener(mUDPsock, mUDPep, Listener::UDP))
+		{	DEBUG_LOG(Log::log("UDP socket inherited");)	}
+		else
+		{
+			mUDPsock.open(mUDPep.protocol());
+			DEBUG_LOG(Log::log("UDP acceptor open");)
+			mUDPsock.bind(mUDPep);
+			DEBUG_LOG(Log::log("UDP acceptor bound to endpoint");)
+		}
 	}
 	catch (const asio::error_code& ec)
 	{
@@ -128,21 +245,17 @@ void RTDS::mConfigCCMserver()
 {
 	DEBUG_LOG(Log::log("CCM server configuring...");)
 		try {
-		mCCMcontext.set_options(asio::ssl::context::default_workarounds
-			| asio::ssl::context::no_sslv2 | asio::ssl::context::single_dh_use);
-		DEBUG_LOG(Log::log("CCM context options configured");)
-		mCCMcontext.use_certificate_file("server_cert.pem", asio::ssl::context::pem);
-		DEBUG_LOG(Log::log("CCM SSL certificate loaded");)
-		mCCMcontext.use_private_key_file("server_cert.pem", asio::ssl::context::pem);
-		DEBUG_LOG(Log::log("CCM SSL private key loaded");)
-		mCCMcontext.use_tmp_dh_file("dh2048.pem");
-		DEBUG_LOG(Log::log("CCM SSL DH files loaded");)
-		mCCMacceptor.open(mCCMep.protocol());
-		DEBUG_LOG(Log::log("CCM acceptor open");)
-		mCCMacceptor.bind(mCCMep);
-		DEBUG_LOG(Log::log("CCM acceptor bound to endpoint");)
-		mCCMacceptor.listen(asio::socket_base::max_listen_connections);
-		DEBUG_LOG(Log::log("CCM acceptor started listening");)
+		if (mInheritListener(mCCMacceptor, mCCMep, Listener::CCM))
+		{	DEBUG_LOG(Log::log("CCM acceptor inherited");)	}
+		else
+		{
+			mCCMacceptor.open(mCCMep.protocol());
+			DEBUG_LOG(Log::log("CCM acceptor open");)
+			mCCMacceptor.bind(mCCMep);
+			DEBUG_LOG(Log::log("CCM acceptor bound to endpoint");)
+			mCCMacceptor.listen(asio::socket_base::max_listen_connections);
+			DEBUG_LOG(Log::log("CCM acceptor started listening");)
+		}
 	}
 	catch (const asio::error_code& ec)
 	{
@@ -156,21 +269,17 @@ void RTDS::mConfigSSLserver()
 {
 	DEBUG_LOG(Log::log("SSL server configuring...");)
 		try {
-		mSSLcontext.set_options(asio::ssl::context::default_workarounds
-			| asio::ssl::context::no_sslv2 | asio::ssl::context::single_dh_use);
-		DEBUG_LOG(Log::log("SSL context options configured");)
-		mSSLcontext.use_certificate_file("server_cert.pem", asio::ssl::context::pem);
-		DEBUG_LOG(Log::log("SSL certificate loaded");)
-		mSSLcontext.use_private_key_file("server_cert.pem", asio::ssl::context::pem);
-		DEBUG_LOG(Log::log("SSL private key loaded");)
-		mSSLcontext.use_tmp_dh_file("dh2048.pem");
-		DEBUG_LOG(Log::log("SSL DH files loaded");)
-		mSSLacceptor.open(mSSLep.protocol());
-		DEBUG_LOG(Log::log("SSL acceptor open");)
-		mSSLacceptor.bind(mSSLep);
-		DEBUG_LOG(Log::log("SSL acceptor bound to endpoint");)
-		mSSLacceptor.listen(asio::socket_base::max_listen_connections);
-		DEBUG_LOG(Log::log("SSL acceptor started listening");)
+		if (mInheritListener(mSSLacceptor, mSSLep, Listener::SSL))
+		{	DEBUG_LOG(Log::log("SSL acceptor inherited");)	}
+		else
+		{
+			mSSLacceptor.open(mSSLep.protocol());
+			DEBUG_LOG(Log::log("SSL acceptor open");)
+			mSSLacceptor.bind(mSSLep);
+			DEBUG_LOG(Log::log("SSL acceptor bound to endpoint");)
+			mSSLacceptor.listen(asio::socket_base::max_listen_connections);
+			DEBUG_LOG(Log::log("SSL acceptor started listening");)
+		}
 	}
 	catch (const asio::error_code& ec)
 	{
@@ -184,7 +293,8 @@ void RTDS::mIOthreadJob()
 {
 	asio::error_code ec;
 	mThreadCount++;
-	mIOcontext.run(ec);
+	FlightRecorder::installSignalStack();
+	IOmonitor::run(mIOcontext, ec);
 	if (ec)
 	{	LOG(Log::log("ioContext.run() failed - ", ec.message());)	}
 
@@ -209,49 +319,88 @@ void RTDS::mAddthread(int threadCount)
 	}
 }
 
+void RTDS::mWarmPools(const unsigned int poolSize)
+{
+	try {
+		ObjectPool<asio::ip::tcp::socket>::warmUp(poolSize);
+		ObjectPool<TCPpeer>::warmUp(poolSize);
+		ObjectPool<SSLsocket>::warmUp(poolSize);
+		ObjectPool<SSLpeer>::warmUp(poolSize);
+		DEBUG_LOG(Log::log("Peer and socket pools warmed up: ", poolSize);)
+	}
+	catch (const std::bad_alloc& ec)
+	{
+		LOG(Log::log("Cannot preallocate peer/socket pools - ", ec.what());)
+		exit(0);
+	}
+}
+
 void RTDS::mTCPacceptRoutine()
 {
 	mThreadCount++;
+	mEnterListener(Listener::TCP);
 	asio::socket_base::keep_alive keepAlive(true);
 	asio::socket_base::enable_connection_aborted connAbortSignal(true);
+	asio::ip::tcp::no_delay noDelay(true);
 
 	while (mServerRunning)
 	{
 		asio::ip::tcp::socket* peerSocket = nullptr;
+		std::uint32_t quotaSlot = QUOTA_UNTRACKED;
 		bool peerIsGood = true;
 		try
 		{
-			peerSocket = new asio::ip::tcp::socket(mIOcontext);
-			DEBUG_LOG(Log::log("TCP socket created");)
+			mWaitForAdmission();
+			peerSocket = ObjectPool<asio::ip::tcp::socket>::construct(mIOcontext);
+			DEBUG_LOG_AT(ACCEPT, Log::log("TCP socket created");)
 			mTCPacceptor.accept(*peerSocket);
-			DEBUG_LOG(Log::log("TCP socket accepted connection");)
+			DEBUG_LOG_AT(ACCEPT, Log::log("TCP socket accepted connection");)
+			quotaSlot = mAcquireQuota(Listener::TCP, *peerSocket);
+			if (quotaSlot == QUOTA_REJECTED)
+			{
+				ObjectPool<asio::ip::tcp::socket>::destroy(peerSocket);
+				continue;
+			}
 			peerSocket->set_option(keepAlive);
-			DEBUG_LOG(Log::log("TCP socket option keepAlive set");)
+			DEBUG_LOG_AT(ACCEPT, Log::log("TCP socket option keepAlive set");)
 			peerSocket->set_option(connAbortSignal);
-			DEBUG_LOG(Log::log("TCP socket option connAbortSignal set");)
-			new TCPpeer(peerSocket);
-			DEBUG_LOG(Log::log("TCP peer created");)
+			DEBUG_LOG_AT(ACCEPT, Log::log("TCP socket option connAbortSignal set");)
+			peerSocket->set_option(noDelay);
+			DEBUG_LOG_AT(ACCEPT, Log::log("TCP socket option noDelay set");)
+			new TCPpeer(peerSocket, quotaSlot);
+			DEBUG_LOG_AT(ACCEPT, Log::log("TCP peer created");)
 		}
 		catch (const std::runtime_error& ec)
 		{
-			LOG(Log::log("Cannot allocate TCP peer/socket - ", ec.what());)
+			if (mServerRunning)
+			{
+				LOG_AT(ACCEPT, Log::log("Cannot allocate TCP peer/socket - ", ec.what());)
+				FlightRecorder::record(FlightEvent::FAILURE, 0, ec.what());
+			}
 			peerIsGood = false;
 		}
 		catch (const asio::error_code& ec)
 		{
-			DEBUG_LOG(Log::log("Failed to configure TCP peer - ", ec.message());)
+			DEBUG_LOG_AT(ACCEPT, Log::log("Failed to configure TCP peer - ", ec.message());)
+			FlightRecorder::record(FlightEvent::FAILURE, ec.value(), "configure tcp peer");
 			peerIsGood = false;
 		}
 
-		if (!peerIsGood && peerSocket != nullptr)
-			delete peerSocket;
+		if (!peerIsGood)
+		{
+			ConnectionQuota::release(quotaSlot);
+			if (peerSocket != nullptr)
+				ObjectPool<asio::ip::tcp::socket>::destroy(peerSocket);
+		}
 	}
+	mLeaveListener(Listener::TCP);
 	mThreadCount--;
 }
 
 void RTDS::mUDPlistenRoutine()
 {
 	mThreadCount++;
+	mEnterListener(Listener::UDP);
 	UDPpeer udpPeer(&mUDPsock);
 	asio::error_code ec;
 
@@ -259,136 +408,362 @@ void RTDS::mUDPlistenRoutine()
 	{
 		auto dataSize = mUDPsock.receive_from(udpPeer.getReadBuffer(), udpPeer.getRefToEndpoint(), 0, ec);
 		if (ec)
-		{	if (mServerRunning) { DEBUG_LOG(Log::log("UDP receive failed - ", ec.message());)	}}
+		{
+			if (mServerRunning)
+			{
+				DEBUG_LOG_AT(UDP, Log::log("UDP receive failed - ", ec.message());)
+				FlightRecorder::record(FlightEvent::FAILURE, ec.value(), "udp receive");
+			}
+		}
 		else
 		{
+			auto receivedTick = Latency::now();
+			Metrics::add(Metric::BYTES_IN, dataSize);
 			if (udpPeer.cookString(dataSize))
 				CmdProcessor::processCommand(udpPeer);
-			else
+			else if (UDPlimiter::allow(udpPeer.getRefToEndpoint(), COMMAND_COUNT))
 				udpPeer.respondWith(Response::BAD_COMMAND);
+			Latency::record(LatencyKind::UDP_COMMAND, receivedTick);
 		}
 	}
+	mLeaveListener(Listener::UDP);
 	mThreadCount--;
 }
 
 void RTDS::mCCMacceptRoutine()
 {
 	mThreadCount++;
+	mEnterListener(Listener::CCM);
 	asio::socket_base::keep_alive keepAlive(true);
 	asio::socket_base::enable_connection_aborted connAbortSignal(true);
+	asio::ip::tcp::no_delay noDelay(true);
 
 	while (mServerRunning)
 	{
 		SSLsocket* peerSocket = nullptr;
+		std::uint32_t quotaSlot = QUOTA_UNTRACKED;
 		bool peerIsGood = true;
 		try
 		{
-			peerSocket = new SSLsocket(mIOcontext, mCCMcontext);
-			DEBUG_LOG(Log::log("New CCM socket created");)
-			mCCMacceptor.accept(peerSocket->lowest_layer());
-			DEBUG_LOG(Log::log("CCM socket accepted connection");)
-			peerSocket->lowest_layer().set_option(keepAlive);
-			DEBUG_LOG(Log::log("CCM socket option keepAlive set");)
-			peerSocket->lowest_layer().set_option(connAbortSignal);
-			DEBUG_LOG(Log::log("CCM socket option connAbortSignal set");)
-			peerSocket->async_handshake(asio::ssl::stream_base::server,
-				std::bind(&RTDS::mCCMhandshakeHandler, this, std::placeholders::_1, peerSocket));
+			mWaitForHandshakeSlot(mPendingCCMhandshakes, MAX_PENDING_CCM_HANDSHAKES);
+			asio::ip::tcp::socket acceptedSocket(mIOcontext);
+			mCCMacceptor.accept(acceptedSocket);
+			DEBUG_LOG_AT(ACCEPT, Log::log("CCM socket accepted connection");)
+			quotaSlot = mAcquireQuota(Listener::CCM, acceptedSocket);
+			if (quotaSlot == QUOTA_REJECTED)
+				continue;
+			acceptedSocket.set_option(keepAlive);
+			DEBUG_LOG_AT(ACCEPT, Log::log("CCM socket option keepAlive set");)
+			acceptedSocket.set_option(connAbortSignal);
+			DEBUG_LOG_AT(ACCEPT, Log::log("CCM socket option connAbortSignal set");)
+			acceptedSocket.set_option(noDelay);
+			DEBUG_LOG_AT(ACCEPT, Log::log("CCM socket option noDelay set");)
+			peerSocket = ObjectPool<SSLsocket>::construct(std::move(acceptedSocket), *TLScontext::ccmContext());
+			DEBUG_LOG_AT(ACCEPT, Log::log("New CCM socket created");)
+			mStartHandshake(peerSocket, mPendingCCMhandshakes, std::bind(&RTDS::mCCMhandshakeHandler, this, std::placeholders::_1, peerSocket, quotaSlot));
+			DEBUG_LOG_AT(ACCEPT, Log::log("CCM socket handshake started");)
 		}
 		catch (const std::runtime_error& ec)
 		{
-			LOG(Log::log("Cannot allocate CCM socket - ", ec.what());)
+			if (mServerRunning)
+			{
+				LOG_AT(ACCEPT, Log::log("Cannot allocate CCM socket - ", ec.what());)
+				FlightRecorder::record(FlightEvent::FAILURE, 0, ec.what());
+			}
 			peerIsGood = false;
 		}
 		catch (const asio::error_code& ec)
 		{
-			DEBUG_LOG(Log::log("Failed to configure CCM peer - ", ec.message());)
+			DEBUG_LOG_AT(ACCEPT, Log::log("Failed to configure CCM peer - ", ec.message());)
+			FlightRecorder::record(FlightEvent::FAILURE, ec.value(), "configure ccm peer");
 			peerIsGood = false;
 		}
 
-		if (!peerIsGood && peerSocket != nullptr)
-			delete peerSocket;
+		if (!peerIsGood)
+		{
+			ConnectionQuota::release(quotaSlot);
+			if (peerSocket != nullptr)
+				ObjectPool<SSLsocket>::destroy(peerSocket);
+		}
 	}
+	mLeaveListener(Listener::CCM);
 	mThreadCount--;
 }
 
 void RTDS::mSSLacceptRoutine()
 {
 	mThreadCount++;
+	mEnterListener(Listener::SSL);
 	asio::socket_base::keep_alive keepAlive(true);
 	asio::socket_base::enable_connection_aborted connAbortSignal(true);
+	asio::ip::tcp::no_delay noDelay(true);
 
 	while (mServerRunning)
 	{
 		SSLsocket* peerSocket = nullptr;
+		std::uint32_t quotaSlot = QUOTA_UNTRACKED;
 		bool peerIsGood = true;
 		try
 		{
-			peerSocket = new SSLsocket(mIOcontext, mSSLcontext);
-			DEBUG_LOG(Log::log("New SSL socket created");)
-			mSSLacceptor.accept(peerSocket->lowest_layer());
-			DEBUG_LOG(Log::log("SSL socket accepted connection");)
-			peerSocket->lowest_layer().set_option(keepAlive);
-			DEBUG_LOG(Log::log("SSL socket option keepAlive set");)
-			peerSocket->lowest_layer().set_option(connAbortSignal);
-			DEBUG_LOG(Log::log("SSL socket option connAbortSignal set");)
-			peerSocket->async_handshake(asio::ssl::stream_base::server,
-				std::bind(&RTDS::mSSLhandshakeHandler, this, std::placeholders::_1, peerSocket));
+			mWaitForAdmission();
+			mWaitForHandshakeSlot(mPendingSSLhandshakes, MAX_PENDING_HANDSHAKES);
+			asio::ip::tcp::socket acceptedSocket(mIOcontext);
+			mSSLacceptor.accept(acceptedSocket);
+			DEBUG_LOG_AT(ACCEPT, Log::log("SSL socket accepted connection");)
+			quotaSlot = mAcquireQuota(Listener::SSL, acceptedSocket);
+			if (quotaSlot == QUOTA_REJECTED)
+				continue;
+			acceptedSocket.set_option(keepAlive);
+			DEBUG_LOG_AT(ACCEPT, Log::log("SSL socket option keepAlive set");)
+			acceptedSocket.set_option(connAbortSignal);
+			DEBUG_LOG_AT(ACCEPT, Log::log("SSL socket option connAbortSignal set");)
+			acceptedSocket.set_option(noDelay);
+			DEBUG_LOG_AT(ACCEPT, Log::log("SSL socket option noDelay set");)
+			peerSocket = ObjectPool<SSLsocket>::construct(std::move(acceptedSocket), *TLScontext::sslContext());
+			DEBUG_LOG_AT(ACCEPT, Log::log("New SSL socket created");)
+			mStartHandshake(peerSocket, mPendingSSLhandshakes, std::bind(&RTDS::mSSLhandshakeHandler, this, std::placeholders::_1, peerSocket, quotaSlot));
+			DEBUG_LOG_AT(ACCEPT, Log::log("SSL socket handshake started");)
 		}
 		catch (const std::runtime_error& ec)
 		{
-			LOG(Log::log("Cannot allocate SSL peer/socket - ", ec.what());)
+			if (mServerRunning)
+			{
+				LOG_AT(ACCEPT, Log::log("Cannot allocate SSL peer/socket - ", ec.what());)
+				FlightRecorder::record(FlightEvent::FAILURE, 0, ec.what());
+			}
 			peerIsGood = false;
 		}
 		catch (const asio::error_code& ec)
 		{
-			DEBUG_LOG(Log::log("Failed to configure SSL peer - ", ec.message());)
+			DEBUG_LOG_AT(ACCEPT, Log::log("Failed to configure SSL peer - ", ec.message());)
+			FlightRecorder::record(FlightEvent::FAILURE, ec.value(), "configure ssl peer");
 			peerIsGood = false;
 		}
 
-		if (!peerIsGood && peerSocket != nullptr)
-			delete peerSocket;
+		if (!peerIsGood)
+		{
+			ConnectionQuota::release(quotaSlot);
+			if (peerSocket != nullptr)
+				ObjectPool<SSLsocket>::destroy(peerSocket);
+		}
 	}
+	mLeaveListener(Listener::SSL);
 	mThreadCount--;
 }
 
-void RTDS::mSSLhandshakeHandler(const asio::error_code& ec, SSLsocket* peerSocket)
+std::uint32_t RTDS::mAcquireQuota(const Listener listener, asio::ip::tcp::socket& peerSocket)
 {
+	asio::error_code ec;
+	auto peerEndpoint = peerSocket.remote_endpoint(ec);
 	if (ec)
+		return QUOTA_UNTRACKED;
+	auto quotaSlot = ConnectionQuota::acquire(listener, peerEndpoint.address());
+	if (quotaSlot == QUOTA_REJECTED)
+	{	DEBUG_LOG_AT(ACCEPT, Log::log("Connection over the source quota closed - ", peerEndpoint.address().to_string());)	}
+	return quotaSlot;
+}
+
+void RTDS::mWaitForHandshakeSlot(const std::atomic_int& pendingCount, const int maxPending)
+{
+	if (pendingCount < maxPending)
+		return;
+	std::unique_lock<std::mutex> lock(mAcceptLock);
+	mAcceptCondition.wait(lock, [&]() { return pendingCount < maxPending || !mServerRunning; });
+}
+
+void RTDS::mWaitForAdmission()
+{
+	if (!Admission::isShedding())
+		return;
+	Metrics::add(Metric::SHED_ACCEPTS);
+	std::unique_lock<std::mutex> lock(mAcceptLock);
+	mAcceptCondition.wait(lock, [this]() { return !Admission::isShedding() || !mServerRunning; });
+}
+
+void RTDS::mWakeAcceptRoutines()
+{
 	{
-		DEBUG_LOG(Log::log("SSL socket handshake failed");)
-		delete peerSocket;
+		std::lock_guard<std::mutex> lock(mAcceptLock);
 	}
-	else
+	mAcceptCondition.notify_all();
+}
+
+void RTDS::mTLSwatchRoutine()
+{
+	mThreadCount++;
+	while (mServerRunning)
 	{
-		try {
-			new SSLpeer(peerSocket);
-		}
-		catch (const std::runtime_error& ec)
+		std::this_thread::sleep_for(std::chrono::seconds(TLS_WATCH_INTERVAL));
+		if (mServerRunning && TLScontext::filesChanged())
 		{
-			LOG(Log::log("Cannot allocate SSL peer - ", ec.what());)
-			delete peerSocket;
+			LOG_AT(TLS, Log::log("TLS certificate files changed, reloading...");)
+			TLScontext::load();
 		}
-		DEBUG_LOG(Log::log("SSL peer created");)
 	}
+	mThreadCount--;
 }
 
-void RTDS::mCCMhandshakeHandler(const asio::error_code& ec, SSLsocket* peerSocket)
+void RTDS::mIOprobeRoutine()
+{
+	mThreadCount++;
+	while (mServerRunning)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(IO_PROBE_INTERVAL));
+		Admission::update(IOmonitor::lag(), Metrics::value(Metric::PENDING_DELIVERIES));
+		if (!Admission::isShedding())
+			mWakeAcceptRoutines();
+		IOmonitor::probe(mIOcontext);
+	}
+	mThreadCount--;
+}
+
+void RTDS::mSSLhandshakeHandler(const asio::error_code& ec, SSLsocket* peerSocket, const std::uint32_t quotaSlot)
 {
 	if (ec)
 	{
-		DEBUG_LOG(Log::log("CCM socket handshake failed");)
-		delete peerSocket;
+		DEBUG_LOG_AT(TLS, Log::log("SSL socket handshake failed");)
+		FlightRecorder::record(FlightEvent::FAILURE, ec.value(), "ssl handshake");
+		ObjectPool<SSLsocket>::destroy(peerSocket);
+		ConnectionQuota::release(quotaSlot);
 	}
 	else
 	{
-		try	{	
-			new SSLccm(peerSocket);
-		}
-		catch (const std::runtime_error& ec)
+		TLSsession::countHandshake(*peerSocket);
+		asio::post(mIOcontext, std::bind(&RTDS::mMakeSSLpeer, this, peerSocket, quotaSlot));
+	}
+}
+
+void RTDS::mCCMhandshakeHandler(const asio::error_code& ec, SSLsocket* peerSocket, const std::uint32_t quotaSlot)
+{
+	if (ec)
+	{
+		DEBUG_LOG_AT(TLS, Log::log("CCM socket handshake failed");)
+		FlightRecorder::record(FlightEvent::FAILURE, ec.value(), "ccm handshake");
+		ObjectPool<SSLsocket>::destroy(peerSocket);
+		ConnectionQuota::release(quotaSlot);
+	}
+	else
+	{
+		TLSsession::countHandshake(*peerSocket);
+		asio::post(mIOcontext, std::bind(&RTDS::mMakeCCMpeer, this, peerSocket, quotaSlot));
+	}
+}
+
+void RTDS::mMakeSSLpeer(SSLsocket* peerSocket, const std::uint32_t quotaSlot)
+{
+	try {
+		new SSLpeer(peerSocket, quotaSlot);
+	}
+	catch (const std::runtime_error& ec)
+	{
+		LOG_AT(ACCEPT, Log::log("Cannot allocate SSL peer - ", ec.what());)
+		FlightRecorder::record(FlightEvent::FAILURE, 0, ec.what());
+		ObjectPool<SSLsocket>::destroy(peerSocket);
+		ConnectionQuota::release(quotaSlot);
+	}
+	DEBUG_LOG_AT(ACCEPT, Log::log("SSL peer created");)
+}
+
+void RTDS::mMakeCCMpeer(SSLsocket* peerSocket, const std::uint32_t quotaSlot)
+{
+	try	{	
+		new SSLccm(peerSocket, quotaSlot);
+	}
+	catch (const std::runtime_error& ec)
+	{
+		LOG_AT(ACCEPT, Log::log("Cannot allocate CCM peer - ", ec.what());)
+		FlightRecorder::record(FlightEvent::FAILURE, 0, ec.what());
+		ObjectPool<SSLsocket>::destroy(peerSocket);
+		ConnectionQuota::release(quotaSlot);
+	}
+	DEBUG_LOG_AT(ACCEPT, Log::log("CCM peer created");)
+}
+
+void RTDS::mEnterListener(const Listener listener)
+{
+#ifdef RTDS_HANDOVER
+	std::lock_guard<std::mutex> lock(mListenerLock);
+	mListenerThreads[(short)listener] = ::pthread_self();
+	mListenerRunning[(short)listener] = true;
+#endif
+}
+
+void RTDS::mLeaveListener(const Listener listener)
+{
+#ifdef RTDS_HANDOVER
+	std::lock_guard<std::mutex> lock(mListenerLock);
+	mListenerRunning[(short)listener] = false;
+#endif
+}
+
+void RTDS::mWakeListeners()
+{
+#ifdef RTDS_HANDOVER
+	for (auto attempt = 0; attempt < HANDOVER_WAKE_ATTEMPTS; attempt++)
+	{
 		{
-			LOG(Log::log("Cannot allocate CCM peer - ", ec.what());)
-			delete peerSocket;
+			std::lock_guard<std::mutex> lock(mListenerLock);
+			auto listenersRunning = false;
+			for (std::size_t index = 0; index < LISTENER_COUNT; index++)
+			{
+				if (!mListenerRunning[index])
+					continue;
+				listenersRunning = true;
+				::pthread_kill(mListenerThreads[index], HANDOVER_WAKE_SIGNAL);
+			}
+			if (!listenersRunning)
+				return;
 		}
-		DEBUG_LOG(Log::log("CCM peer created");)
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
 	}
+	LOG(Log::log("Listener threads did not stop after the wake signal");)
+#endif
+}
+
+void RTDS::mTakeOverListeners()
+{
+#ifdef RTDS_HANDOVER
+	if (mHandoverPath.empty())
+		return;
+	DEBUG_LOG(Log::log("Looking for RTDS to take over from...");)
+	if (Handover::receiveListeners(mHandoverPath, mInheritedFDs))
+	{	LOG(Log::log("Listening sockets taken over from the running RTDS");)	}
+	else
+		mInheritedFDs.fill(-1);
+#endif
+}
+
+void RTDS::mHandoverRoutine()
+{
+#ifdef RTDS_HANDOVER
+	mThreadCount++;
+	ListenerFDs listenerFDs;
+	listenerFDs[(short)Listener::TCP] = mTCPacceptor.native_handle();
+	listenerFDs[(short)Listener::UDP] = mUDPsock.native_handle();
+	listenerFDs[(short)Listener::SSL] = mSSLacceptor.native_handle();
+	listenerFDs[(short)Listener::CCM] = mCCMacceptor.native_handle();
+
+	bool handedOver = false;
+	while (mServerRunning && !handedOver)
+	{
+		auto listenFD = Handover::openListener(mHandoverPath);
+		if (listenFD == -1)
+			break;
+		handedOver = Handover::sendListeners(listenFD, mHandoverPath, listenerFDs);
+	}
+
+	if (handedOver)
+	{
+		LOG(Log::log("Listening sockets handed over, draining ", StreamPeer::globalPeerCount(), " peers");)
+		mStopServer();
+		auto drainStart = std::chrono::steady_clock::now();
+		while (StreamPeer::globalPeerCount() > 0 &&
+			std::chrono::steady_clock::now() - drainStart < std::chrono::seconds(MAX_DRAIN_TIME))
+			std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+		LOG(Log::log("Peers drained, ", StreamPeer::globalPeerCount(), " peers left");)
+		SIGNAL_ABORT
+	}
+	mThreadCount--;
+#endif
 }
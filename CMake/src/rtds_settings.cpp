@@ -1,10 +1,50 @@
 #include "rtds_settings.h"
 #include "cmd_processor.h"
+#include "tls_session.h"
+#include "io_monitor.h"
+#include "latency.h"
+#include "admission.h"
+#include "connection_quota.h"
+#include "runtime_limits.h"
+#include "log.h"
+#include <asio/ip/address.hpp>
+#include <fstream>
 #include <iostream>
 
 unsigned short Settings::mRTDSportNo = RDTS_DEF_PORT;
 unsigned short Settings::mRTDSccmPortNo = RTDS_DEF_CCM_PORT;
+unsigned short Settings::mRTDSmetricsPortNo = 0;
+std::string Settings::mMetricsAddress = DEF_METRICS_ADDRESS;
 short Settings::mRTDSthreadCount = MIN_THREAD_COUNT;
+std::string Settings::mHandoverPath;
+unsigned int Settings::mWarmPoolSize = DEF_WARM_POOL_SIZE;
+std::string Settings::mCapturePath;
+std::atomic<unsigned int> Settings::mMaxLoopLag(DEF_MAX_LOOP_LAG);
+std::atomic<unsigned int> Settings::mMaxPending(DEF_MAX_PENDING);
+std::atomic<unsigned int> Settings::mMaxSourceConnections(DEF_MAX_SOURCE_CONNECTIONS);
+std::atomic<unsigned int> Settings::mSourceConnectRate(DEF_SOURCE_CONNECT_RATE);
+unsigned int Settings::mUDPpingRate = DEF_UDP_PING_RATE;
+unsigned int Settings::mUDPfanoutRate = DEF_UDP_FANOUT_RATE;
+std::string Settings::mConfigPath;
+std::mutex Settings::mReloadLock;
+
+const Settings::Option Settings::OPTION[] =
+{
+	{ "port", 'p' },
+	{ "ccm_port", 'c' },
+	{ "metrics_port", 'm' },
+	{ "metrics_address", 'a' },
+	{ "threads", 't' },
+	{ "handover_path", 'u' },
+	{ "warm_pool", 'w' },
+	{ "capture_path", 'x' },
+	{ "max_loop_lag", 'l' },
+	{ "max_pending", 'q' },
+	{ "max_source_connections", 's' },
+	{ "source_connect_rate", 'r' },
+	{ "udp_ping_rate", 'i' },
+	{ "udp_fanout_rate", 'b' }
+};
 bool Settings::mNeedToAbort = false;
 
 void Settings::mFindPortNumber(std::string portNStr)
@@ -25,15 +65,152 @@ void Settings::mFindccmPortNumber(std::string portNStr)
 	}
 }
 
+void Settings::mFindMetricsPortNumber(std::string portNStr)
+{
+	if (!CmdProcessor::isPortNumber(portNStr, mRTDSmetricsPortNo) || mRTDSmetricsPortNo == 0)
+	{
+		std::cerr << "Invalid Port Number as argument";
+		exit(0);
+	}
+}
+
+void Settings::mFindMetricsAddress(std::string addressStr)
+{
+	asio::error_code ec;
+	asio::ip::make_address(addressStr, ec);
+	if (ec)
+	{
+		std::cerr << "Invalid metrics address as argument";
+		exit(0);
+	}
+	mMetricsAddress = addressStr;
+}
+
 void Settings::mFindThreadCount(std::string threadCStr)
 {
 	if (!CmdProcessor::isThreadCount(threadCStr, mRTDSthreadCount))
 	{
-		std::cerr << "Invalid Thread count as argument (Must be [4-28])";
+		std::cerr << "Invalid Thread count as argument (Must be [" << MIN_THREAD_COUNT << "-" << RuntimeLimits::get(Limit::MAX_THREAD_COUNT) << "])";
+		exit(0);
+	}
+}
+
+void Settings::mFindHandoverPath(std::string pathStr)
+{
+#ifdef RTDS_HANDOVER
+	if (pathStr.empty())
+	{
+		std::cerr << "Invalid handover path as argument";
+		exit(0);
+	}
+	mHandoverPath = pathStr;
+#else
+	std::cerr << "Handover is not supported on this platform";
+	exit(0);
+#endif
+}
+
+void Settings::mFindWarmPoolSize(std::string poolSStr)
+{
+	if (!CmdProcessor::isPoolSize(poolSStr, mWarmPoolSize))
+	{
+		std::cerr << "Invalid warm pool size as argument";
+		exit(0);
+	}
+}
+
+void Settings::mFindCapturePath(std::string pathStr)
+{
+	if (pathStr.empty())
+	{
+		std::cerr << "Invalid capture path as argument";
+		exit(0);
+	}
+	mCapturePath = pathStr;
+}
+
+void Settings::mFindLimit(std::string limitStr, unsigned int& limit)
+{
+	if (!CmdProcessor::isLimit(limitStr, limit))
+	{
+		std::cerr << "Invalid limit as argument";
 		exit(0);
 	}
 }
 
+void Settings::mFindLimit(std::string limitStr, std::atomic<unsigned int>& limit)
+{
+	unsigned int value;
+	mFindLimit(limitStr, value);
+	limit = value;
+}
+
+void Settings::mFindConfigFile(std::string pathStr)
+{
+	std::vector<std::pair<std::string, std::string>> entries;
+	if (pathStr.empty() || !mReadConfigFile(pathStr, entries))
+	{
+		std::cerr << "Invalid config file as argument";
+		exit(0);
+	}
+	std::vector<std::string> rejectedKeys;
+	if (!RuntimeLimits::load(entries, false, rejectedKeys))
+	{
+		std::cerr << "Invalid limit in config file " << rejectedKeys.front();
+		exit(0);
+	}
+	for (auto& entry : entries)
+	{
+		if (RuntimeLimits::isLimit(entry.first))
+			continue;
+		auto option = mFindOption(entry.first);
+		if (option == nullptr)
+		{
+			std::cerr << "Invalid key in config file " << entry.first;
+			exit(0);
+		}
+		processArgument(std::string("-") + option->flag + entry.second);
+	}
+	mConfigPath = pathStr;
+}
+
+bool Settings::mReadConfigFile(const std::string& path, std::vector<std::pair<std::string, std::string>>& entries)
+{
+	std::ifstream configFile(path);
+	if (!configFile)
+		return false;
+
+	auto trim = [](const std::string& str)
+	{
+		auto start = str.find_first_not_of(" \t\r");
+		if (start == std::string::npos)
+			return std::string();
+		return str.substr(start, str.find_last_not_of(" \t\r") - start + 1);
+	};
+	std::string line;
+	while (std::getline(configFile, line))
+	{
+		line = trim(line);
+		if (line.empty() || line[0] == '#')
+			continue;
+		auto separator = line.find('=');
+		if (separator == std::string::npos)
+			return false;
+		entries.emplace_back(trim(line.substr(0, separator)), trim(line.substr(separator + 1)));
+	}
+	return true;
+}
+
+const Settings::Option* Settings::mFindOption(const std::string& key)
+{
+	for (auto& option : OPTION)
+	{
+		if (key == option.key)
+			return &option;
+	}
+	return nullptr;
+}
+
 void Settings::processArgument(std::string arg)
 {
 	if (arg.rfind("-p", 0) == 0)
@@ -42,6 +219,30 @@ void Settings::processArgument(std::string arg)
 		mFindThreadCount(arg.substr(2));
 	else if (arg.rfind("-c", 0) == 0)
 		mFindccmPortNumber(arg.substr(2));
+	else if (arg.rfind("-u", 0) == 0)
+		mFindHandoverPath(arg.substr(2));
+	else if (arg.rfind("-w", 0) == 0)
+		mFindWarmPoolSize(arg.substr(2));
+	else if (arg.rfind("-m", 0) == 0)
+		mFindMetricsPortNumber(arg.substr(2));
+	else if (arg.rfind("-a", 0) == 0)
+		mFindMetricsAddress(arg.substr(2));
+	else if (arg.rfind("-x", 0) == 0)
+		mFindCapturePath(arg.substr(2));
+	else if (arg.rfind("-l", 0) == 0)
+		mFindLimit(arg.substr(2), mMaxLoopLag);
+	else if (arg.rfind("-q", 0) == 0)
+		mFindLimit(arg.substr(2), mMaxPending);
+	else if (arg.rfind("-s", 0) == 0)
+		mFindLimit(arg.substr(2), mMaxSourceConnections);
+	else if (arg.rfind("-r", 0) == 0)
+		mFindLimit(arg.substr(2), mSourceConnectRate);
+	else if (arg.rfind("-i", 0) == 0)
+		mFindLimit(arg.substr(2), mUDPpingRate);
+	else if (arg.rfind("-b", 0) == 0)
+		mFindLimit(arg.substr(2), mUDPfanoutRate);
+	else if (arg.rfind("-f", 0) == 0)
+		mFindConfigFile(arg.substr(2));
 	else
 	{
 		std::cerr << "Invalid argument";
@@ -49,11 +250,102 @@ void Settings::processArgument(std::string arg)
 	}
 }
 
+bool Settings::reloadConfig(std::string& report)
+{
+	std::lock_guard<std::mutex> lock(mReloadLock);
+	std::vector<std::pair<std::string, std::string>> entries;
+	report.clear();
+	if (mConfigPath.empty() || !mReadConfigFile(mConfigPath, entries))
+	{
+		LOG(Log::log("Config reload failed, cannot read the config file");)
+		return false;
+	}
+
+	auto maxLoopLag = mMaxLoopLag.load();
+	auto maxPending = mMaxPending.load();
+	auto maxSourceConnections = mMaxSourceConnections.load();
+	auto sourceConnectRate = mSourceConnectRate.load();
+	std::vector<std::string> rejectedKeys, ignoredKeys;
+	for (auto& entry : entries)
+	{
+		unsigned int* limit = nullptr;
+		if (entry.first == "max_loop_lag")
+			limit = &maxLoopLag;
+		else if (entry.first == "max_pending")
+			limit = &maxPending;
+		else if (entry.first == "max_source_connections")
+			limit = &maxSourceConnections;
+		else if (entry.first == "source_connect_rate")
+			limit = &sourceConnectRate;
+		else if (RuntimeLimits::isLimit(entry.first))
+		{
+			if (!RuntimeLimits::isReloadable(entry.first))
+				ignoredKeys.push_back(entry.first);
+		}
+		else if (mFindOption(entry.first) != nullptr)
+			ignoredKeys.push_back(entry.first);
+		else
+			rejectedKeys.push_back(entry.first);
+		if (limit != nullptr && !CmdProcessor::isLimit(entry.second, *limit))
+			rejectedKeys.push_back(entry.first);
+	}
+	auto isLoaded = RuntimeLimits::load(entries, true, rejectedKeys);
+
+	auto joinKeys = [](const std::vector<std::string>& keys)
+	{
+		std::string keysStr;
+		for (auto& key : keys)
+			keysStr += (keysStr.empty() ? "" : ",") + key;
+		return keysStr;
+	};
+	if (!rejectedKeys.empty())
+		report = "rejected=" + joinKeys(rejectedKeys);
+	if (!ignoredKeys.empty())
+		report += (report.empty() ? "ignored=" : "\tignored=") + joinKeys(ignoredKeys);
+	LOG(Log::log("Config reload ", (isLoaded ? "applied" : "failed"), (report.empty() ? "" : ", "), report);)
+	if (!isLoaded)
+		return false;
+
+	mMaxLoopLag = maxLoopLag;
+	mMaxPending = maxPending;
+	mMaxSourceConnections = maxSourceConnections;
+	mSourceConnectRate = sourceConnectRate;
+	Admission::setLimits(maxLoopLag, maxPending);
+	ConnectionQuota::setLimits(maxSourceConnections, sourceConnectRate);
+	return true;
+}
+
+ServerConfig Settings::serverConfig()
+{
+	ServerConfig config;
+	config.portNumber = mRTDSportNo;
+	config.ccmPort = mRTDSccmPortNo;
+	config.threadCount = mRTDSthreadCount;
+	config.handoverPath = mHandoverPath;
+	config.warmPoolSize = mWarmPoolSize;
+	config.metricsPort = mRTDSmetricsPortNo;
+	config.metricsAddress = mMetricsAddress;
+	config.capturePath = mCapturePath;
+	config.maxLoopLag = mMaxLoopLag;
+	config.maxPending = mMaxPending;
+	config.maxSourceConnections = mMaxSourceConnections;
+	config.sourceConnectRate = mSourceConnectRate;
+	config.udpPingRate = mUDPpingRate;
+	config.udpFanoutRate = mUDPfanoutRate;
+	return config;
+}
+
 std::string Settings::generateStatus()
 {
 	std::string statusStr;
 	statusStr = std::to_string(RTDS_MAJOR) + "." + std::to_string(RTDS_MINOR) + "." + std::to_string(RTDS_PATCH) + "\t";
 	statusStr += std::to_string(mRTDSportNo) + "\t";
 	statusStr += std::to_string(mRTDSccmPortNo) + "\t";
+	statusStr += std::to_string(TLSsession::fullCount()) + "\t";
+	statusStr += std::to_string(TLSsession::resumedCount()) + "\t";
+	statusStr += IOmonitor::generateReport();
+	statusStr += Latency::summary(LatencyKind::LOOP_LAG) + "\t";
+	statusStr += "shedding=" + std::to_string(Admission::isShedding()) + "\t";
+	statusStr += RuntimeLimits::generateReport();
 	return statusStr;
 }
@@ -0,0 +1,106 @@
+#include "runtime_limits.h"
+#include "cmd_processor.h"
+
+const RuntimeLimits::Spec RuntimeLimits::SPEC[] =
+{
+	{ "max_broadcast_size", 1, MAX_BUFF_SIZE, true },
+	{ "min_tag_size", DEF_MIN_TAG_SIZE, MAX_BUFF_SIZE, true },
+	{ "max_tag_size", DEF_MIN_TAG_SIZE, MAX_BUFF_SIZE, true },
+	{ "min_bgid_size", 1, MAX_BUFF_SIZE, true },
+	{ "max_bgid_size", 1, MAX_BUFF_SIZE, true },
+	{ "msg_cache_size", 0, MAX_LIMIT_VALUE, true },
+	{ "msg_keep_time", 0, MAX_LIMIT_VALUE, true },
+	{ "buffer_size", MIN_BUFF_SIZE, MAX_BUFF_SIZE, false },
+	{ "max_threads", MIN_THREAD_COUNT, MAX_THREAD_LIMIT, false }
+};
+
+RuntimeLimits::Values RuntimeLimits::mValues =
+{
+	{
+		DEF_MAX_BROADCAST_SIZE,
+		DEF_MIN_TAG_SIZE,
+		DEF_MAX_TAG_SIZE,
+		DEF_MIN_BGID_SIZE,
+		DEF_MAX_BGID_SIZE,
+		DEF_MSG_CACHE_SIZE,
+		DEF_MSG_KEEP_TIME,
+		DEF_BUFF_SIZE,
+		DEF_MAX_THREAD_COUNT
+	}
+};
+
+bool RuntimeLimits::mIsConsistent(const unsigned int (&values)[LIMIT_COUNT])
+{
+	auto commandSize = (unsigned long long)values[(std::size_t)Limit::MAX_BROADCAST_SIZE] +
+		values[(std::size_t)Limit::MAX_BGID_SIZE] + values[(std::size_t)Limit::MAX_TAG_SIZE] +
+		CmdProcessor::COMM[(short)Command::BROADCAST].size() + 4;
+	return values[(std::size_t)Limit::MIN_TAG_SIZE] <= values[(std::size_t)Limit::MAX_TAG_SIZE] &&
+		values[(std::size_t)Limit::MIN_BGID_SIZE] <= values[(std::size_t)Limit::MAX_BGID_SIZE] &&
+		commandSize <= values[(std::size_t)Limit::BUFF_SIZE];
+}
+
+bool RuntimeLimits::isLimit(const std::string& key)
+{
+	for (auto& spec : SPEC)
+	{
+		if (key == spec.name)
+			return true;
+	}
+	return false;
+}
+
+bool RuntimeLimits::isReloadable(const std::string& key)
+{
+	for (auto& spec : SPEC)
+	{
+		if (key == spec.name)
+			return spec.reloadable;
+	}
+	return false;
+}
+
+bool RuntimeLimits::load(const std::vector<std::pair<std::string, std::string>>& entries, const bool reload, std::vector<std::string>& rejectedKeys)
+{
+	unsigned int values[LIMIT_COUNT];
+	for (std::size_t index = 0; index < LIMIT_COUNT; index++)
+		values[index] = get((Limit)index);
+
+	auto rejectedCount = rejectedKeys.size();
+	for (auto& entry : entries)
+	{
+		for (std::size_t index = 0; index < LIMIT_COUNT; index++)
+		{
+			if (entry.first != SPEC[index].name)
+				continue;
+			unsigned int value;
+			if (!CmdProcessor::isLimit(entry.second, value) || value < SPEC[index].minValue || value > SPEC[index].maxValue)
+				rejectedKeys.push_back(entry.first);
+			else if (!reload || SPEC[index].reloadable)
+				values[index] = value;
+		}
+	}
+	if (rejectedKeys.size() == rejectedCount && !mIsConsistent(values))
+	{
+		for (auto& entry : entries)
+		{
+			if (isLimit(entry.first))
+				rejectedKeys.push_back(entry.first);
+		}
+	}
+	if (!rejectedKeys.empty())
+		return false;
+
+	for (std::size_t index = 0; index < LIMIT_COUNT; index++)
+		mValues.value[index].store(values[index], std::memory_order_relaxed);
+	return true;
+}
+
+std::string RuntimeLimits::generateReport()
+{
+	static_assert(sizeof(SPEC) / sizeof(Spec) == LIMIT_COUNT, "Limit spec missing");
+
+	std::string reportStr;
+	for (std::size_t index = 0; index < LIMIT_COUNT; index++)
+		reportStr += SPEC[index].name + "=" + std::to_string(get((Limit)index)) + "\t";
+	return reportStr;
+}
@@ -2,22 +2,34 @@
 #include "cmd_processor.h"
 #include "rtds_settings.h"
 #include <functional>
+#include <system_error>
+#include <thread>
+#include <asio/post.hpp>
+#include "handler_allocator.h"
+#include "object_pool.h"
+#include "tls_context.h"
+#include "metrics.h"
+#include "latency.h"
+#include "flight_recorder.h"
+#include "connection_quota.h"
 #include "log.h"
 
-SSLccm::SSLccm(SSLsocket* socketPtr)
+SSLccm::SSLccm(SSLsocket* socketPtr, const std::uint32_t quotaSlot)
 {
 	mPeerSocket = socketPtr;
+	mQuotaSlot = quotaSlot;
 	mIsAdmin = false;
 	mPeerIsActive = true;
 
-	DEBUG_LOG(Log::log("CCM Peer Connected");)
+	DEBUG_LOG_AT(CCM, Log::log("CCM Peer Connected");)
 	mPeerReceiveData();
 }
 
 SSLccm::~SSLccm()
 {
-	delete mPeerSocket;
-	DEBUG_LOG(Log::log("CCM Peer Disconnected");)
+	ObjectPool<SSLsocket>::destroy(mPeerSocket);
+	ConnectionQuota::release(mQuotaSlot);
+	DEBUG_LOG_AT(CCM, Log::log("CCM Peer Disconnected");)
 }
 
 
@@ -25,7 +37,7 @@ void SSLccm::mSendFuncFeedbk(const asio::error_code& ec)
 {
 	if (ec)
 	{
-		DEBUG_LOG(Log::log( "CCM Peer socket sendPeerBufferData() failed", ec.message());)
+		DEBUG_LOG_AT(CCM, Log::log( "CCM Peer socket sendPeerBufferData() failed", ec.message());)
 		delete this;
 	}
 	else
@@ -35,8 +47,9 @@ void SSLccm::mSendFuncFeedbk(const asio::error_code& ec)
 
 void SSLccm::mSendPeerBufferData()
 {
-	mPeerSocket->async_write_some(mDataBuffer.getSendBuffer(), 
-		std::bind(&SSLccm::mSendFuncFeedbk, this, std::placeholders::_1));
+	Metrics::add(Metric::BYTES_OUT, mResponse.size());
+	asio::async_write(*mPeerSocket, asio::buffer(mResponse), 
+		makeAllocHandler(std::bind(&SSLccm::mSendFuncFeedbk, this, std::placeholders::_1)));
 }
 
 void SSLccm::mPeerReceiveData()
@@ -44,7 +57,7 @@ void SSLccm::mPeerReceiveData()
 	if (mPeerIsActive)
 	{
 		mPeerSocket->async_read_some(mDataBuffer.getReadBuffer(), 
-			std::bind(&SSLccm::mProcessData, this, std::placeholders::_1, std::placeholders::_2));
+			makeAllocHandler(std::bind(&SSLccm::mProcessData, this, std::placeholders::_1, std::placeholders::_2)));
 	}
 	else
 		delete this;
@@ -54,41 +67,68 @@ void SSLccm::mProcessData(const asio::error_code& ec, std::size_t dataSize)
 {
 	if (ec)
 	{
-		DEBUG_LOG(Log::log("CCM Peer socket processData() failed ", ec.message());)
+		DEBUG_LOG_AT(CCM, Log::log("CCM Peer socket processData() failed ", ec.message());)
 		delete this;
 	}
 	else
 	{
+		Metrics::add(Metric::BYTES_IN, dataSize);
 		if (mDataBuffer.cookString(dataSize))
 			CmdProcessor::processCommand(*this);
 		else
 			respondWith(Response::BAD_COMMAND);
 
-		if (mPeerIsActive)
+		if (mDeferredJob)
+			mRunDeferredJob();
+		else if (mPeerIsActive)
 			mSendPeerBufferData();
 		else
 			delete this;
 	}
 }
 
+void SSLccm::mRunDeferredJob()
+{
+	auto job = std::move(mDeferredJob);
+	mDeferredJob = nullptr;
+	try {
+		std::thread jobThread([this, job]()
+		{
+			auto response = "[R]\t" + job() + "\n";
+			asio::post(mPeerSocket->get_executor(), [this, response]()
+			{
+				mResponse = response;
+				mSendPeerBufferData();
+			});
+		});
+		jobThread.detach();
+	}
+	catch (const std::system_error&)
+	{
+		respondWith(Response::WAIT_RETRY);
+		mSendPeerBufferData();
+	}
+}
 
 void SSLccm::abort()
 {
 	std::string response = "[R]\t";
 	if (mIsAdmin)
 	{
-		DEBUG_LOG(Log::log("RTDS aborted");)
+		DEBUG_LOG_AT(CCM, Log::log("RTDS aborted");)
+		FlightRecorder::record(FlightEvent::ABORT);
+		FlightRecorder::dump();
 		SIGNAL_ABORT
 	}
 	else
 		response += CmdProcessor::RESP[(short)Response::BAD_COMMAND];
 	response += "\n";
-	mDataBuffer = response;
+	mResponse = response;
 }
 
 void SSLccm::disconnect()
 {
-	DEBUG_LOG(Log::log("CCM Peer Disconnecting");)
+	DEBUG_LOG_AT(CCM, Log::log("CCM Peer Disconnecting");)
 	mPeerIsActive = false;
 }
 
@@ -97,14 +137,42 @@ void SSLccm::status()
 	std::string response = "[R]\t";
 	if (mIsAdmin)
 	{
-		DEBUG_LOG(Log::log("CCM requesting status");)
+		DEBUG_LOG_AT(CCM, Log::log("CCM requesting status");)
 		response += Settings::generateStatus();
 	}
 	else
 		response += CmdProcessor::RESP[(short)Response::NOT_ALLOWED];
 	response += "\n";
-	mDataBuffer = response;
+	mResponse = response;
+
+}
+
+void SSLccm::stats()
+{
+	std::string response = "[R]\t";
+	if (mIsAdmin)
+	{
+		DEBUG_LOG_AT(CCM, Log::log("CCM requesting stats");)
+		response += Metrics::generateStats();
+	}
+	else
+		response += CmdProcessor::RESP[(short)Response::NOT_ALLOWED];
+	response += "\n";
+	mResponse = response;
+}
 
+void SSLccm::latency()
+{
+	std::string response = "[R]\t";
+	if (mIsAdmin)
+	{
+		DEBUG_LOG_AT(CCM, Log::log("CCM requesting latency");)
+		response += Latency::generateReport();
+	}
+	else
+		response += CmdProcessor::RESP[(short)Response::NOT_ALLOWED];
+	response += "\n";
+	mResponse = response;
 }
 
 void SSLccm::login(const std::string_view& usr, const std::string_view& pass)
@@ -114,19 +182,87 @@ void SSLccm::login(const std::string_view& usr, const std::string_view& pass)
 	{
 		mIsAdmin = true;
 		response += CmdProcessor::RESP[(short)Response::SUCCESS];
-		DEBUG_LOG(Log::log("CCM peer authenticated");)
+		DEBUG_LOG_AT(CCM, Log::log("CCM peer authenticated");)
+	}
+	else
+		response += CmdProcessor::RESP[(short)Response::NOT_ALLOWED];
+	response += "\n";
+	mResponse = response;
+}
+
+void SSLccm::reloadTLS()
+{
+	if (!mIsAdmin)
+	{
+		respondWith(Response::NOT_ALLOWED);
+		return;
+	}
+	DEBUG_LOG_AT(CCM, Log::log("CCM requesting TLS reload");)
+	mDeferredJob = []()
+	{
+		return CmdProcessor::RESP[(short)(TLScontext::load() ? Response::SUCCESS : Response::BAD_PARAM)];
+	};
+}
+
+void SSLccm::reloadConfig()
+{
+	if (!mIsAdmin)
+	{
+		respondWith(Response::NOT_ALLOWED);
+		return;
+	}
+	DEBUG_LOG_AT(CCM, Log::log("CCM requesting config reload");)
+	mDeferredJob = []()
+	{
+		std::string report;
+		auto response = CmdProcessor::RESP[(short)(Settings::reloadConfig(report) ? Response::SUCCESS : Response::BAD_PARAM)];
+		if (!report.empty())
+			response += "\t" + report;
+		return response;
+	};
+}
+
+void SSLccm::logLevel(const std::string_view& level, const std::string_view& category)
+{
+	std::string response = "[R]\t";
+	if (mIsAdmin)
+	{
+		DEBUG_LOG_AT(CCM, Log::log("CCM requesting log level ", level, " ", category);)
+		if (level.empty())
+			response += Log::generateLevels();
+		else if (Log::setLevel(level, category))
+			response += CmdProcessor::RESP[(short)Response::SUCCESS];
+		else
+			response += CmdProcessor::RESP[(short)Response::BAD_PARAM];
+	}
+	else
+		response += CmdProcessor::RESP[(short)Response::NOT_ALLOWED];
+	response += "\n";
+	mResponse = response;
+}
+
+void SSLccm::dumpFlight()
+{
+	std::string response = "[R]\t";
+	if (mIsAdmin)
+	{
+		DEBUG_LOG_AT(CCM, Log::log("CCM requesting flight recorder dump");)
+		if (FlightRecorder::dump())
+			response += CmdProcessor::RESP[(short)Response::SUCCESS];
+		else
+			response += CmdProcessor::RESP[(short)Response::WAIT_RETRY];
 	}
 	else
 		response += CmdProcessor::RESP[(short)Response::NOT_ALLOWED];
 	response += "\n";
-	mDataBuffer = response;
+	mResponse = response;
 }
 
 void SSLccm::respondWith(const Response resp)
 {
 	std::string response = "[R]\t";
-	DEBUG_LOG(Log::log("CCM Peer responding: ", CmdProcessor::RESP[(short)resp]);)
+	DEBUG_LOG_AT(CCM, Log::log("CCM Peer responding: ", CmdProcessor::RESP[(short)resp]);)
 	response += CmdProcessor::RESP[(short)resp];
 	response += "\n";
-	mDataBuffer = response;
+	mResponse = response;
 }
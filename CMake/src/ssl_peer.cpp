@@ -1,82 +1,256 @@
 #include "ssl_peer.h"
+#include <asio/bind_executor.hpp>
+#include <asio/post.hpp>
 #include <functional>
+#include "handler_allocator.h"
+#include "object_pool.h"
 #include "cmd_processor.h"
+#include "metrics.h"
+#include "flight_recorder.h"
+#include "ktls.h"
 #include "log.h"
+#include "trace.h"
 
-SSLpeer::SSLpeer(SSLsocket* socketPtr)
+SSLpeer::SSLpeer(SSLsocket* socketPtr, const std::uint32_t quotaSlot) : mStrand(asio::make_strand(socketPtr->get_executor())),
+mFlushTimer(mStrand)
 {
 	mPeerSocket = socketPtr;
+	mWriteInProgress = false;
+	mFlushTimerArmed = false;
+	mFlushPosted = false;
+	mResponseQueued = false;
+	mResponseWriting = false;
+	mIsReleased = false;
 	mSApair = CmdProcessor::getSAPstring(socketPtr->lowest_layer().remote_endpoint());
 	mPeerType = PeerType::SSL;
+#ifdef RTDS_KTLS
+	mKernelTLS = KernelTLS::enableTX(*socketPtr);
+#else
+	mKernelTLS = false;
+#endif
+	mQuotaSlot = quotaSlot;
 
-	DEBUG_LOG(Log::log(mSApair," SSL Peer Connected");)
-	mPeerReceiveData();
+	FlightRecorder::record(FlightEvent::ACCEPT, (short)mPeerType, mSApair);
+	DEBUG_LOG_AT(ACCEPT, Log::log(mSApair," SSL Peer Connected");)
+	asio::post(mStrand, makeAllocHandler(std::bind(&SSLpeer::mPeerReceiveData, this)));
+}
+
+void* SSLpeer::operator new(std::size_t)
+{
+	return ObjectPool<SSLpeer>::allocate();
+}
+
+void SSLpeer::operator delete(void* peerPtr)
+{
+	ObjectPool<SSLpeer>::deallocate(peerPtr);
 }
 
 SSLpeer::~SSLpeer()
 {
+	Metrics::add(Metric::PENDING_DELIVERIES, -(std::int64_t)mPendingTicks.size());
 	leaveBG();
-	delete mPeerSocket;
-	DEBUG_LOG(Log::log(mSApair, " SSL Peer socket Disconnected");)
+	ObjectPool<SSLsocket>::destroy(mPeerSocket);
+	DEBUG_LOG_AT(ACCEPT, Log::log(mSApair, " SSL Peer socket Disconnected");)
 }
 
 
-void SSLpeer::mSendFuncFeedbk(const asio::error_code& ec)
+bool SSLpeer::mHasPendingHandlers() const
+{
+	return mWriteInProgress || mFlushTimerArmed || mFlushPosted;
+}
+
+void SSLpeer::mRelease()
 {
-	if (ec)
 	{
-		DEBUG_LOG(Log::log(mSApair, " Peer socket sendPeerBufferData() failed", ec.message());)
-		delete this;
+		std::lock_guard<std::mutex> sendLock(mSendLock);
+		mIsReleased = true;
+		if (mHasPendingHandlers())
+		{
+			asio::error_code ec;
+			mFlushTimer.cancel();
+			mPeerSocket->lowest_layer().cancel(ec);
+			return;
+		}
+	}
+	delete this;
+}
+
+void SSLpeer::mFlushPending()
+{
+	mWritingData.swap(mPendingData);
+	mPendingData.clear();
+	mWritingTicks.swap(mPendingTicks);
+	mPendingTicks.clear();
+	mResponseWriting = mResponseQueued;
+	mResponseQueued = false;
+	mWriteInProgress = true;
+	mWrite(asio::buffer(mWritingData), asio::bind_executor(mStrand,
+		makeAllocHandler(std::bind(&SSLpeer::mWriteFuncFeedbk, this, std::placeholders::_1))));
+}
+
+void SSLpeer::mFlushRequest()
+{
+	std::unique_lock<std::mutex> sendLock(mSendLock);
+	mFlushPosted = false;
+	if (mIsReleased)
+	{
+		if (!mHasPendingHandlers())
+		{
+			sendLock.unlock();
+			delete this;
+		}
+		return;
+	}
+	if (!mPeerIsActive)
+	{
+		asio::error_code ec;
+		mPeerSocket->lowest_layer().shutdown(asio::socket_base::shutdown_both, ec);
+		return;
+	}
+	if (mWriteInProgress || mPendingData.empty())
+		return;
+
+	if (mPendingData.size() >= SSL_COALESCE_SIZE || SSL_FLUSH_DELAY == 0)
+		mFlushPending();
+	else if (!mFlushTimerArmed)
+	{
+		mFlushTimerArmed = true;
+		mFlushTimer.expires_after(std::chrono::microseconds(SSL_FLUSH_DELAY));
+		mFlushTimer.async_wait(asio::bind_executor(mStrand,
+			makeAllocHandler(std::bind(&SSLpeer::mFlushTimerFeedbk, this, std::placeholders::_1))));
 	}
-	else
-		mPeerReceiveData();
 }
 
-void SSLpeer::mSendMssgFuncFeedbk(const asio::error_code& ec)
+void SSLpeer::mWriteFuncFeedbk(const asio::error_code& ec)
 {
+	std::unique_lock<std::mutex> sendLock(mSendLock);
+	Metrics::add(Metric::PENDING_DELIVERIES, -(std::int64_t)mWritingTicks.size());
+	mWriteInProgress = false;
+	auto responseWritten = mResponseWriting;
+	mResponseWriting = false;
+	if (mWritingData.capacity() > SSL_COALESCE_SIZE)
+		std::string().swap(mWritingData);
+
+	if (mIsReleased)
+	{
+		if (!mHasPendingHandlers())
+		{
+			sendLock.unlock();
+			delete this;
+		}
+		return;
+	}
+
 	if (ec)
 	{
-		DEBUG_LOG(Log::log(mSApair, " Peer socket sendMessage() failed", ec.message());)
+		DEBUG_LOG_AT(FANOUT, Log::log(mSApair, " Peer socket write failed ", ec.message());)
+		Metrics::add(Metric::DELIVERY_FAILS);
+		FlightRecorder::record(FlightEvent::DROP, ec.value(), mSApair);
+		RTDS_TRACE3(send_done, mPeerID, mWritingTicks.empty() ? 0 : mWritingTicks.front(), ec.value());
 		mPeerIsActive = false;
+		responseWritten = responseWritten || mResponseQueued;
+		mResponseQueued = false;
+		mPendingData.clear();
+		Metrics::add(Metric::PENDING_DELIVERIES, -(std::int64_t)mPendingTicks.size());
+		mPendingTicks.clear();
 	}
+	else
+	{
+		for (auto createdTick : mWritingTicks)
+		{
+			RTDS_TRACE3(send_done, mPeerID, createdTick, 0);
+			Latency::record(LatencyKind::FANOUT, createdTick);
+		}
+		if (!mPendingData.empty())
+			mFlushPending();
+	}
+	sendLock.unlock();
+
+	if (responseWritten)
+		mPeerReceiveData();
 }
 
+void SSLpeer::mFlushTimerFeedbk(const asio::error_code&)
+{
+	std::unique_lock<std::mutex> sendLock(mSendLock);
+	mFlushTimerArmed = false;
+	if (mIsReleased)
+	{
+		if (!mHasPendingHandlers())
+		{
+			sendLock.unlock();
+			delete this;
+		}
+	}
+	else if (!mWriteInProgress && !mPendingData.empty())
+		mFlushPending();
+}
 
 void SSLpeer::mSendPeerBufferData()
 {
-	mPeerSocket->async_write_some(mDataBuffer.getSendBuffer(), 
-		std::bind(&SSLpeer::mSendFuncFeedbk, this, std::placeholders::_1));
+	std::lock_guard<std::mutex> sendLock(mSendLock);
+	auto sendBuffer = mDataBuffer.getSendBuffer();
+	Metrics::add(Metric::BYTES_OUT, sendBuffer.size());
+	mPendingData.append(static_cast<const char*>(sendBuffer.data()), sendBuffer.size());
+	mResponseQueued = true;
+	if (!mWriteInProgress)
+		mFlushPending();
 }
 
 void SSLpeer::mPeerReceiveData()
 {
 	if (mPeerIsActive)
 	{
-		mPeerSocket->async_read_some(mDataBuffer.getReadBuffer(), 
-			std::bind(&SSLpeer::mProcessData, this, std::placeholders::_1, std::placeholders::_2));
+		mDataBuffer.release();
+		auto sslHandle = mPeerSocket->native_handle();
+		if (::SSL_pending(sslHandle) > 0 || ::BIO_ctrl_pending(::SSL_get_rbio(sslHandle)) > 0)
+			mReceiveReadyData(asio::error_code());
+		else
+		{
+			mPeerSocket->lowest_layer().async_wait(asio::ip::tcp::socket::wait_read, asio::bind_executor(mStrand,
+				makeAllocHandler(std::bind(&SSLpeer::mReceiveReadyData, this, std::placeholders::_1))));
+		}
 	}
 	else
-		delete this;
+		mRelease();
+}
+
+void SSLpeer::mReceiveReadyData(const asio::error_code& ec)
+{
+	if (ec)
+		mProcessData(ec, 0);
+	else
+	{
+		mPeerSocket->async_read_some(mDataBuffer.getReadBuffer(), asio::bind_executor(mStrand,
+			makeAllocHandler(std::bind(&SSLpeer::mProcessData, this, std::placeholders::_1, std::placeholders::_2))));
+	}
 }
 
 void SSLpeer::mProcessData(const asio::error_code& ec, std::size_t dataSize)
 {
 	if (ec)
 	{
-		DEBUG_LOG(Log::log(mSApair, " Peer socket processData() failed ", ec.message());)
-		delete this;
+		DEBUG_LOG_AT(ACCEPT, Log::log(mSApair, " Peer socket processData() failed ", ec.message());)
+		if (ec != asio::error::eof && ec != asio::ssl::error::stream_truncated)
+			FlightRecorder::record(FlightEvent::FAILURE, ec.value(), mSApair);
+		mRelease();
 	}
 	else
 	{
+		auto receivedTick = Latency::now();
+		Metrics::add(Metric::BYTES_IN, dataSize);
 		if (mDataBuffer.cookString(dataSize))
 			CmdProcessor::processCommand(*this);
 		else
 			respondWith(Response::BAD_COMMAND);
 
 		if (mPeerIsActive)
+		{
 			mSendPeerBufferData();
+			Latency::record(LatencyKind::SSL_COMMAND, receivedTick);
+		}
 		else
-			delete this;
+			mRelease();
 	}
 }
 
@@ -85,7 +259,34 @@ void SSLpeer::sendMessage(const Message* message)
 	std::shared_lock<std::shared_mutex> readLock(mPeerResourceMtx);
 	if (mPeerIsActive && (message->recverTag == ALL_TAG || message->recverTag == mBgTag))
 	{
-		mPeerSocket->async_write_some(message->asioBuffer, 
-			std::bind(&SSLpeer::mSendMssgFuncFeedbk, this, std::placeholders::_1));
+		std::lock_guard<std::mutex> sendLock(mSendLock);
+		if (mIsReleased)
+			return;
+		if (mPendingData.size() + message->messageBuf.size() > SSL_MAX_PENDING_SIZE)
+		{
+			DEBUG_LOG_AT(FANOUT, Log::log(mSApair, " Peer too slow, disconnected with ", mPendingData.size(), " bytes pending");)
+			Metrics::add(Metric::DELIVERY_FAILS);
+			FlightRecorder::record(FlightEvent::DROP, (std::int64_t)mPendingData.size(), mSApair);
+			mPeerIsActive = false;
+			if (!mFlushPosted)
+			{
+				mFlushPosted = true;
+				asio::post(mStrand, makeAllocHandler(std::bind(&SSLpeer::mFlushRequest, this)));
+			}
+			return;
+		}
+		Metrics::add(Metric::DELIVERIES);
+		Metrics::add(Metric::PENDING_DELIVERIES);
+		Metrics::add(Metric::BYTES_OUT, message->messageBuf.size());
+		mPendingData += message->messageBuf;
+		mPendingTicks.push_back(message->createdTick);
+		if (mWriteInProgress || mFlushPosted)
+			return;
+
+		if (!mFlushTimerArmed || mPendingData.size() >= SSL_COALESCE_SIZE || SSL_FLUSH_DELAY == 0)
+		{
+			mFlushPosted = true;
+			asio::post(mStrand, makeAllocHandler(std::bind(&SSLpeer::mFlushRequest, this)));
+		}
 	}
 }
@@ -1,9 +1,12 @@
 #include "stream_peer.h"
 #include "cmd_processor.h"
 #include "bg_controller.h"
+#include "flight_recorder.h"
+#include "connection_quota.h"
 #include "log.h"
 
 std::atomic_int StreamPeer::mGlobalPeerCount;
+std::atomic<std::uint32_t> StreamPeer::mLastPeerID;
 
 
 StreamPeer::StreamPeer()
@@ -11,11 +14,14 @@ StreamPeer::StreamPeer()
 	mPeerIsActive = true;
 	mBgPtr = nullptr;
 	mIsInBG = false;
+	mPeerID = ++mLastPeerID;
+	mQuotaSlot = QUOTA_UNTRACKED;
 	mGlobalPeerCount++;
 }
 
 StreamPeer::~StreamPeer()
 {
+	ConnectionQuota::release(mQuotaSlot);
 	mGlobalPeerCount--;
 }
 
@@ -25,15 +31,25 @@ const PeerType StreamPeer::peerType() const
 	return mPeerType;
 }
 
+std::uint32_t StreamPeer::peerID() const
+{
+	return mPeerID;
+}
+
 int StreamPeer::getPeerCount() const
 {
 	return mGlobalPeerCount;
 }
 
+int StreamPeer::globalPeerCount()
+{
+	return mGlobalPeerCount;
+}
+
 
 void StreamPeer::disconnect()
 {
-	DEBUG_LOG(Log::log(mSApair, " Peer Disconnecting");)
+	DEBUG_LOG_AT(ACCEPT, Log::log(mSApair, " Peer Disconnecting");)
 	mPeerIsActive = false;
 }
 
@@ -48,7 +64,7 @@ void StreamPeer::changeTag(const std::string_view& bgTag)
 		mBgTag = bgTag;
 
 		response += CmdProcessor::RESP[(short)Response::SUCCESS];
-		DEBUG_LOG(Log::log(mSApair, " Changed Tag to: ", mBgTag);)
+		DEBUG_LOG_AT(BG, Log::log(mSApair, " Changed Tag to: ", mBgTag);)
 	}
 	response += "\n";
 	mDataBuffer = response;
@@ -93,12 +109,13 @@ void StreamPeer::listenTo(const std::string_view& bgID, const std::string_view&
 				mBgPtr->broadcast(this, message);
 
 			response += CmdProcessor::RESP[(short)Response::SUCCESS];
-			DEBUG_LOG(Log::log(mSApair, " Listening to Tag: ", mBgTag, " BG: ", mBgID);)
+			FlightRecorder::record(FlightEvent::JOIN, 0, mBgID);
+			DEBUG_LOG_AT(BG, Log::log(mSApair, " Listening to Tag: ", mBgTag, " BG: ", mBgID);)
 		}
 		else
 		{
 			response += CmdProcessor::RESP[(short)Response::WAIT_RETRY];
-			LOG(Log::log(mSApair, " Failed to create joining message!");)
+			LOG_AT(BG, Log::log(mSApair, " Failed to create joining message!");)
 		}
 	}
 	response += "\n";
@@ -110,7 +127,8 @@ void StreamPeer::leaveBG()
 	std::string response = "[R]\t";
 	if (mIsInBG)
 	{
-		DEBUG_LOG(Log::log(mSApair, " Peer leavig BG ", mBgID);)
+		FlightRecorder::record(FlightEvent::LEAVE, 0, mBgID);
+		DEBUG_LOG_AT(BG, Log::log(mSApair, " Peer leavig BG ", mBgID);)
 		BGcontroller::removeFromBG(this, mBgID);
 
 		if (mPeerMode == PeerMode::LISTEN)
@@ -119,7 +137,7 @@ void StreamPeer::leaveBG()
 			if (message != nullptr)
 				mBgPtr->broadcast(this, message);
 			else
-			{	LOG(Log::log(mSApair, " Failed to create leaving message!");)	}
+			{	LOG_AT(BG, Log::log(mSApair, " Failed to create leaving message!");)	}
 		}
 
 		mIsInBG = false;
@@ -153,12 +171,12 @@ void StreamPeer::broadcastTo(const std::string_view& messageStr, const std::stri
 			{
 				mBgPtr->broadcast(this, message);
 				response += CmdProcessor::RESP[(short)Response::SUCCESS];
-				DEBUG_LOG(Log::log(mSApair, " Peer broadcasting: ", messageStr);)
+				DEBUG_LOG_AT(FANOUT, Log::log(mSApair, " Peer broadcasting: ", messageStr);)
 			}
 			else
 			{
 				response += CmdProcessor::RESP[(short)Response::WAIT_RETRY];
-				LOG(Log::log(mSApair, " Failed to create message!");)
+				LOG_AT(FANOUT, Log::log(mSApair, " Failed to create message!");)
 			}
 		}
 	}
@@ -190,12 +208,12 @@ void StreamPeer::messageTo(const std::string_view& messageStr, const std::string
 			{
 				mBgPtr->broadcast(this, message);
 				response += CmdProcessor::RESP[(short)Response::SUCCESS];
-				DEBUG_LOG(Log::log(mSApair, " Peer broadcasting: ", messageStr);)
+				DEBUG_LOG_AT(FANOUT, Log::log(mSApair, " Peer broadcasting: ", messageStr);)
 			}
 			else
 			{
 				response += CmdProcessor::RESP[(short)Response::WAIT_RETRY];
-				LOG(Log::log(mSApair, " Failed to create message!");)
+				LOG_AT(FANOUT, Log::log(mSApair, " Failed to create message!");)
 			}
 		}
 	}
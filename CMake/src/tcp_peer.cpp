@@ -1,23 +1,41 @@
 #include "tcp_peer.h"
 #include <functional>
+#include "handler_allocator.h"
+#include "object_pool.h"
 #include "cmd_processor.h"
+#include "metrics.h"
+#include "flight_recorder.h"
 #include "log.h"
+#include "trace.h"
 
-TCPpeer::TCPpeer(asio::ip::tcp::socket* socketPtr)
+TCPpeer::TCPpeer(asio::ip::tcp::socket* socketPtr, const std::uint32_t quotaSlot)
 {
 	mPeerSocket = socketPtr;
 	mSApair = CmdProcessor::getSAPstring(socketPtr->remote_endpoint());
 	mPeerType = PeerType::TCP;
+	mPeerSocket->non_blocking(true);
+	mQuotaSlot = quotaSlot;
 
-	DEBUG_LOG(Log::log(mSApair," TCP Peer Connected");)
+	FlightRecorder::record(FlightEvent::ACCEPT, (short)mPeerType, mSApair);
+	DEBUG_LOG_AT(ACCEPT, Log::log(mSApair," TCP Peer Connected");)
 	mPeerReceiveData();
 }
 
+void* TCPpeer::operator new(std::size_t)
+{
+	return ObjectPool<TCPpeer>::allocate();
+}
+
+void TCPpeer::operator delete(void* peerPtr)
+{
+	ObjectPool<TCPpeer>::deallocate(peerPtr);
+}
+
 TCPpeer::~TCPpeer()
 {
 	leaveBG();
-	delete mPeerSocket;
-	DEBUG_LOG(Log::log(mSApair, " TCP Peer socket Disconnected");)
+	ObjectPool<asio::ip::tcp::socket>::destroy(mPeerSocket);
+	DEBUG_LOG_AT(ACCEPT, Log::log(mSApair, " TCP Peer socket Disconnected");)
 }
 
 
@@ -25,56 +43,87 @@ void TCPpeer::mSendFuncFeedbk(const asio::error_code& ec)
 {
 	if (ec)
 	{
-		DEBUG_LOG(Log::log(mSApair, " Peer socket sendPeerBufferData() failed", ec.message());)
+		DEBUG_LOG_AT(FANOUT, Log::log(mSApair, " Peer socket sendPeerBufferData() failed", ec.message());)
 		delete this;
 	}
 	else
 		mPeerReceiveData();
 }
 
-void TCPpeer::mSendMssgFuncFeedbk(const asio::error_code& ec)
+void TCPpeer::mSendMssgFuncFeedbk(const asio::error_code& ec, const LatencyTick createdTick)
 {
+	RTDS_TRACE3(send_done, mPeerID, createdTick, ec.value());
+	Metrics::add(Metric::PENDING_DELIVERIES, -1);
 	if (ec)
 	{
-		DEBUG_LOG(Log::log(mSApair, " Peer socket sendMessage() failed", ec.message());)
+		DEBUG_LOG_AT(FANOUT, Log::log(mSApair, " Peer socket sendMessage() failed", ec.message());)
+		Metrics::add(Metric::DELIVERY_FAILS);
+		FlightRecorder::record(FlightEvent::DROP, ec.value(), mSApair);
 		mPeerIsActive = false;
 	}
+	else
+		Latency::record(LatencyKind::FANOUT, createdTick);
 }
 
 
 void TCPpeer::mSendPeerBufferData()
 {
-	mPeerSocket->async_send(mDataBuffer.getSendBuffer(), 
-		std::bind(&TCPpeer::mSendFuncFeedbk, this, std::placeholders::_1));
+	auto sendBuffer = mDataBuffer.getSendBuffer();
+	Metrics::add(Metric::BYTES_OUT, sendBuffer.size());
+	mPeerSocket->async_send(sendBuffer, 
+		makeAllocHandler(std::bind(&TCPpeer::mSendFuncFeedbk, this, std::placeholders::_1)));
 }
 
 void TCPpeer::mPeerReceiveData()
 {
 	if (mPeerIsActive)
 	{
-		mPeerSocket->async_receive(mDataBuffer.getReadBuffer(), 0, 
-			std::bind(&TCPpeer::mProcessData, this, std::placeholders::_1, std::placeholders::_2));
+		mDataBuffer.release();
+		mPeerSocket->async_wait(asio::ip::tcp::socket::wait_read, 
+			makeAllocHandler(std::bind(&TCPpeer::mReceiveReadyData, this, std::placeholders::_1)));
 	}
 	else
 		delete this;
 }
 
+void TCPpeer::mReceiveReadyData(const asio::error_code& ec)
+{
+	if (ec)
+		mProcessData(ec, 0);
+	else
+	{
+		asio::error_code readEc;
+		auto dataSize = mPeerSocket->receive(mDataBuffer.getReadBuffer(), 0, readEc);
+		if (readEc == asio::error::would_block)
+			mPeerReceiveData();
+		else
+			mProcessData(readEc, dataSize);
+	}
+}
+
 void TCPpeer::mProcessData(const asio::error_code& ec, std::size_t dataSize)
 {
 	if (ec)
 	{
-		DEBUG_LOG(Log::log(mSApair, " Peer socket processData() failed ", ec.message());)
+		DEBUG_LOG_AT(ACCEPT, Log::log(mSApair, " Peer socket processData() failed ", ec.message());)
+		if (ec != asio::error::eof)
+			FlightRecorder::record(FlightEvent::FAILURE, ec.value(), mSApair);
 		delete this;
 	}
 	else
 	{
+		auto receivedTick = Latency::now();
+		Metrics::add(Metric::BYTES_IN, dataSize);
 		if (mDataBuffer.cookString(dataSize))
 			CmdProcessor::processCommand(*this);
 		else
 			respondWith(Response::BAD_COMMAND);
 
 		if (mPeerIsActive)
+		{
 			mSendPeerBufferData();
+			Latency::record(LatencyKind::TCP_COMMAND, receivedTick);
+		}
 		else
 			delete this;
 	}
@@ -85,7 +134,10 @@ void TCPpeer::sendMessage(const Message* message)
 	std::shared_lock<std::shared_mutex> readLock(mPeerResourceMtx);
 	if (mPeerIsActive && (message->recverTag == ALL_TAG || message->recverTag == mBgTag))
 	{
+		Metrics::add(Metric::DELIVERIES);
+		Metrics::add(Metric::PENDING_DELIVERIES);
+		Metrics::add(Metric::BYTES_OUT, message->messageBuf.size());
 		mPeerSocket->async_send(message->asioBuffer, 
-			std::bind(&TCPpeer::mSendMssgFuncFeedbk, this, std::placeholders::_1));
+			makeAllocHandler(std::bind(&TCPpeer::mSendMssgFuncFeedbk, this, std::placeholders::_1, message->createdTick)));
 	}
 }
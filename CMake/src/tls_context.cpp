@@ -0,0 +1,108 @@
+#include "tls_context.h"
+#include "tls_session.h"
+#include "ktls.h"
+#include "log.h"
+
+SSLcontextPtr TLScontext::mSSLcontext;
+SSLcontextPtr TLScontext::mCCMcontext;
+std::mutex TLScontext::mReloadLock;
+std::filesystem::file_time_type TLScontext::mCertTime;
+std::filesystem::file_time_type TLScontext::mDHTime;
+
+SSLcontextPtr TLScontext::mMakeContext(const std::string& sessionIdContext, [[maybe_unused]] const bool kernelTLS)
+{
+	SSLcontextPtr sslContext;
+	try {
+		sslContext = std::make_shared<asio::ssl::context>(asio::ssl::context::sslv23);
+	}
+	catch (const std::bad_alloc& ec)
+	{
+		LOG_AT(TLS, Log::log("Cannot allocate SSL context - ", ec.what());)
+		return nullptr;
+	}
+
+	asio::error_code ec;
+	sslContext->set_options(asio::ssl::context::default_workarounds
+		| asio::ssl::context::no_sslv2 | asio::ssl::context::single_dh_use, ec);
+	if (!ec)
+		sslContext->use_certificate_file(TLS_CERT_FILE, asio::ssl::context::pem, ec);
+	if (!ec)
+		sslContext->use_private_key_file(TLS_CERT_FILE, asio::ssl::context::pem, ec);
+	if (!ec)
+		sslContext->use_tmp_dh_file(TLS_DH_FILE, ec);
+	if (ec)
+	{
+		LOG_AT(TLS, Log::log("Failed to load ", sessionIdContext, " certificate - ", ec.message());)
+		return nullptr;
+	}
+	if (::SSL_CTX_check_private_key(sslContext->native_handle()) != 1)
+	{
+		LOG_AT(TLS, Log::log("Private key does not match the ", sessionIdContext, " certificate");)
+		return nullptr;
+	}
+
+	try {
+		TLSsession::configure(*sslContext, sessionIdContext);
+#ifdef RTDS_KTLS
+		if (kernelTLS)
+			KernelTLS::configure(*sslContext);
+#endif
+	}
+	catch (const asio::error_code& ec)
+	{
+		LOG_AT(TLS, Log::log("Failed to configure ", sessionIdContext, " sessions - ", ec.message());)
+		return nullptr;
+	}
+	return sslContext;
+}
+
+bool TLScontext::mFileTimes(std::filesystem::file_time_type& certTime, std::filesystem::file_time_type& dhTime)
+{
+	std::error_code ec;
+	certTime = std::filesystem::last_write_time(TLS_CERT_FILE, ec);
+	if (ec)
+		return false;
+	dhTime = std::filesystem::last_write_time(TLS_DH_FILE, ec);
+	return !ec;
+}
+
+bool TLScontext::load()
+{
+	std::lock_guard<std::mutex> reloadLock(mReloadLock);
+	std::filesystem::file_time_type certTime, dhTime;
+	auto haveTimes = mFileTimes(certTime, dhTime);
+
+	auto sslContext = mMakeContext("RTDS-SSL", true);
+	auto ccmContext = mMakeContext("RTDS-CCM", false);
+	if (sslContext == nullptr || ccmContext == nullptr)
+		return false;
+
+	std::atomic_store(&mSSLcontext, sslContext);
+	std::atomic_store(&mCCMcontext, ccmContext);
+	if (haveTimes)
+	{
+		mCertTime = certTime;
+		mDHTime = dhTime;
+	}
+	LOG_AT(TLS, Log::log("TLS certificate loaded");)
+	return true;
+}
+
+bool TLScontext::filesChanged()
+{
+	std::filesystem::file_time_type certTime, dhTime;
+	if (!mFileTimes(certTime, dhTime))
+		return false;
+	std::lock_guard<std::mutex> reloadLock(mReloadLock);
+	return certTime != mCertTime || dhTime != mDHTime;
+}
+
+SSLcontextPtr TLScontext::sslContext()
+{
+	return std::atomic_load(&mSSLcontext);
+}
+
+SSLcontextPtr TLScontext::ccmContext()
+{
+	return std::atomic_load(&mCCMcontext);
+}
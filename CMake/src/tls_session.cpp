@@ -0,0 +1,149 @@
+#include "tls_session.h"
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <openssl/rand.h>
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+#include <openssl/core_names.h>
+#endif
+#include "log.h"
+
+TLSsession::TicketKey TLSsession::mKeys[TICKET_KEY_COUNT];
+std::size_t TLSsession::mKeyCount = 0;
+std::chrono::steady_clock::time_point TLSsession::mKeyCreatedTime;
+std::shared_mutex TLSsession::mKeyLock;
+std::atomic_uint TLSsession::mFullCount;
+std::atomic_uint TLSsession::mResumedCount;
+
+bool TLSsession::mMakeKey(TicketKey& ticketKey)
+{
+	if (::RAND_bytes(ticketKey.name, sizeof(ticketKey.name)) != 1 ||
+		::RAND_bytes(ticketKey.aesKey, sizeof(ticketKey.aesKey)) != 1 ||
+		::RAND_bytes(ticketKey.hmacKey, sizeof(ticketKey.hmacKey)) != 1)
+		return false;
+	return true;
+}
+
+void TLSsession::mRotateKeys()
+{
+	auto timeNow = std::chrono::steady_clock::now();
+	{
+		std::shared_lock<std::shared_mutex> readLock(mKeyLock);
+		if (timeNow - mKeyCreatedTime < std::chrono::seconds(TICKET_KEY_LIFETIME))
+			return;
+	}
+
+	std::lock_guard<std::shared_mutex> writeLock(mKeyLock);
+	if (timeNow - mKeyCreatedTime < std::chrono::seconds(TICKET_KEY_LIFETIME))
+		return;
+	TicketKey newKey;
+	if (!mMakeKey(newKey))
+	{
+		LOG_AT(TLS, Log::log("Failed to rotate ticket key");)
+		return;
+	}
+	mKeyCount = std::min<std::size_t>(mKeyCount + 1, TICKET_KEY_COUNT);
+	std::copy_backward(mKeys, mKeys + mKeyCount - 1, mKeys + mKeyCount);
+	mKeys[0] = newKey;
+	mKeyCreatedTime = timeNow;
+	DEBUG_LOG_AT(TLS, Log::log("Ticket key rotated");)
+}
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+int TLSsession::mTicketKeyCallback(SSL*, unsigned char* keyName, unsigned char* iv,
+	EVP_CIPHER_CTX* cipherCtx, EVP_MAC_CTX* macCtx, int encrypt)
+#else
+int TLSsession::mTicketKeyCallback(SSL*, unsigned char* keyName, unsigned char* iv,
+	EVP_CIPHER_CTX* cipherCtx, HMAC_CTX* macCtx, int encrypt)
+#endif
+{
+	mRotateKeys();
+	std::shared_lock<std::shared_mutex> readLock(mKeyLock);
+	const TicketKey* ticketKey = nullptr;
+	int result = 1;
+
+	if (encrypt)
+	{
+		ticketKey = &mKeys[0];
+		std::memcpy(keyName, ticketKey->name, TICKET_KEY_NAME_SIZE);
+		if (::RAND_bytes(iv, EVP_CIPHER_iv_length(EVP_aes_256_cbc())) != 1 ||
+			::EVP_EncryptInit_ex(cipherCtx, EVP_aes_256_cbc(), nullptr, ticketKey->aesKey, iv) != 1)
+			return -1;
+	}
+	else
+	{
+		for (std::size_t index = 0; index < mKeyCount; index++)
+		{
+			if (std::memcmp(keyName, mKeys[index].name, TICKET_KEY_NAME_SIZE) == 0)
+			{
+				ticketKey = &mKeys[index];
+				result = (index == 0) ? 1 : 2;
+				break;
+			}
+		}
+		if (ticketKey == nullptr)
+			return 0;
+		if (::EVP_DecryptInit_ex(cipherCtx, EVP_aes_256_cbc(), nullptr, ticketKey->aesKey, iv) != 1)
+			return -1;
+	}
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+	OSSL_PARAM macParams[] = {
+		OSSL_PARAM_construct_octet_string(OSSL_MAC_PARAM_KEY, (void*)ticketKey->hmacKey, TICKET_KEY_SIZE),
+		OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, (char*)"SHA256", 0),
+		OSSL_PARAM_construct_end()
+	};
+	if (::EVP_MAC_CTX_set_params(macCtx, macParams) != 1)
+		return -1;
+#else
+	if (::HMAC_Init_ex(macCtx, ticketKey->hmacKey, TICKET_KEY_SIZE, EVP_sha256(), nullptr) != 1)
+		return -1;
+#endif
+	return result;
+}
+
+void TLSsession::configure(asio::ssl::context& sslContext, const std::string& sessionIdContext)
+{
+	{
+		std::lock_guard<std::shared_mutex> writeLock(mKeyLock);
+		if (mKeyCreatedTime == std::chrono::steady_clock::time_point())
+		{
+			if (!mMakeKey(mKeys[0]))
+				throw asio::error_code(asio::error::no_memory);
+			mKeyCount = 1;
+			mKeyCreatedTime = std::chrono::steady_clock::now();
+		}
+	}
+
+	auto ctxHandle = sslContext.native_handle();
+	::SSL_CTX_set_session_cache_mode(ctxHandle, SSL_SESS_CACHE_SERVER);
+	::SSL_CTX_sess_set_cache_size(ctxHandle, SSL_SESSION_CACHE_SIZE);
+	::SSL_CTX_set_timeout(ctxHandle, SSL_SESSION_TIMEOUT);
+	if (::SSL_CTX_set_session_id_context(ctxHandle, (const unsigned char*)sessionIdContext.data(),
+		(unsigned int)sessionIdContext.size()) != 1)
+		throw asio::error_code(asio::error::invalid_argument);
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+	::SSL_CTX_set_tlsext_ticket_key_evp_cb(ctxHandle, &TLSsession::mTicketKeyCallback);
+#else
+	::SSL_CTX_set_tlsext_ticket_key_cb(ctxHandle, &TLSsession::mTicketKeyCallback);
+#endif
+}
+
+void TLSsession::countHandshake(SSLsocket& sslSocket)
+{
+	if (::SSL_session_reused(sslSocket.native_handle()))
+		mResumedCount++;
+	else
+		mFullCount++;
+}
+
+unsigned int TLSsession::fullCount()
+{
+	return mFullCount;
+}
+
+unsigned int TLSsession::resumedCount()
+{
+	return mResumedCount;
+}
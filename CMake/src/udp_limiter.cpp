@@ -0,0 +1,75 @@
+#include "udp_limiter.h"
+#include <algorithm>
+#include "connection_quota.h"
+#include "metrics.h"
+
+std::vector<UDPlimiter::Entry> UDPlimiter::mTable;
+std::uint64_t UDPlimiter::mHashSeed = 0;
+LatencyTick UDPlimiter::mInterval[UDP_BUDGET_COUNT] = {};
+LatencyTick UDPlimiter::mTolerance[UDP_BUDGET_COUNT] = {};
+
+void UDPlimiter::setLimits(const unsigned int pingRate, const unsigned int fanoutRate)
+{
+	const unsigned int rates[UDP_BUDGET_COUNT] = { pingRate, fanoutRate };
+	for (std::size_t budget = 0; budget < UDP_BUDGET_COUNT; budget++)
+	{
+		mInterval[budget] = (rates[budget] > 0) ? 1000000000 / (LatencyTick)rates[budget] : 0;
+		mTolerance[budget] = (rates[budget] > 0) ? mInterval[budget] * (rates[budget] - 1) : 0;
+	}
+	if ((pingRate > 0 || fanoutRate > 0) && mTable.empty())
+	{
+		mHashSeed = ConnectionQuota::randomSeed();
+		mTable.assign(std::size_t(1) << UDP_LIMIT_TABLE_BITS, Entry());
+	}
+}
+
+bool UDPlimiter::allow(const asio::ip::udp::endpoint& endpoint, const short command)
+{
+	auto budget = (command == (short)Command::BROADCAST || command == (short)Command::MESSAGE) ?
+		UDPbudget::FANOUT : UDPbudget::PING;
+	if (mInterval[(std::size_t)budget] == 0)
+		return true;
+
+	auto source = ConnectionQuota::sourceHash(ConnectionQuota::sourceBytes(endpoint.address()), mHashSeed);
+	if (source == 0)
+		source = 1;
+	auto now = Latency::now();
+
+	auto mask = (std::uint32_t)mTable.size() - 1;
+	auto firstSlot = (std::uint32_t)(source >> (64 - UDP_LIMIT_TABLE_BITS));
+	Entry* sourceEntry = nullptr;
+	Entry* stalestEntry = nullptr;
+	for (std::uint32_t probe = 0; probe < UDP_LIMIT_PROBE; probe++)
+	{
+		auto& entry = mTable[(firstSlot + probe) & mask];
+		if (entry.source == source)
+		{
+			sourceEntry = &entry;
+			break;
+		}
+		if (entry.source == 0)
+		{
+			stalestEntry = &entry;
+			break;
+		}
+		if (stalestEntry == nullptr || std::max(entry.fullTick[0], entry.fullTick[1]) <
+			std::max(stalestEntry->fullTick[0], stalestEntry->fullTick[1]))
+			stalestEntry = &entry;
+	}
+	if (sourceEntry == nullptr)
+	{
+		sourceEntry = stalestEntry;
+		sourceEntry->source = source;
+		std::fill(std::begin(sourceEntry->fullTick), std::end(sourceEntry->fullTick), now);
+	}
+
+	auto& fullTick = sourceEntry->fullTick[(std::size_t)budget];
+	auto nextFullTick = std::max(fullTick, now);
+	if (nextFullTick - now > mTolerance[(std::size_t)budget])
+	{
+		Metrics::add(budget == UDPbudget::FANOUT ? Metric::UDP_FANOUT_LIMITED : Metric::UDP_PING_LIMITED);
+		return false;
+	}
+	fullTick = nextFullTick + mInterval[(std::size_t)budget];
+	return true;
+}
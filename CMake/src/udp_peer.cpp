@@ -7,7 +7,9 @@ asio::ip::udp::socket* UDPpeer::mPeerSocket;
 
 void UDPpeer::mSendPeerBufferData()
 {
-	mPeerSocket->send_to(getSendBuffer(), mUDPep);
+	auto sendBuffer = getSendBuffer();
+	Metrics::add(Metric::BYTES_OUT, sendBuffer.size());
+	mPeerSocket->send_to(sendBuffer, mUDPep);
 }
 
 asio::ip::udp::endpoint& UDPpeer::getRefToEndpoint()
@@ -15,6 +17,15 @@ asio::ip::udp::endpoint& UDPpeer::getRefToEndpoint()
 	return mUDPep;
 }
 
+std::uint32_t UDPpeer::peerID() const
+{
+	auto endpointBytes = reinterpret_cast<const unsigned char*>(mUDPep.data());
+	std::uint32_t hash = 2166136261u;			// FNV-1a
+	for (std::size_t byte = 0; byte < mUDPep.size(); byte++)
+		hash = (hash ^ endpointBytes[byte]) * 16777619u;
+	return hash;
+}
+
 UDPpeer::UDPpeer(asio::ip::udp::socket* udpSocket)
 {
 	mPeerSocket = udpSocket;
@@ -28,7 +39,7 @@ void UDPpeer::printPingInfo()
 	response += "\n";
 	mDataBuffer = response;
 
-	DEBUG_LOG(Log::log("UDP Peer pinging");)
+	DEBUG_LOG_AT(UDP, Log::log("UDP Peer pinging");)
 	mSendPeerBufferData();
 }
 
@@ -39,7 +50,7 @@ void UDPpeer::respondWith(const Response resp)
 	response += "\n";
 	mDataBuffer = response;
 
-	DEBUG_LOG(Log::log("UDP Peer responding: ", CmdProcessor::RESP[(short)resp]);)
+	DEBUG_LOG_AT(UDP, Log::log("UDP Peer responding: ", CmdProcessor::RESP[(short)resp]);)
 	mSendPeerBufferData();
 }
 
@@ -62,12 +73,12 @@ void UDPpeer::broadcastTo(const std::string_view& messageStr, const std::string_
 		{
 			BGcontroller::broadcast(message, std::string(bgID));
 			response += CmdProcessor::RESP[(short)Response::SUCCESS];
-			DEBUG_LOG(Log::log("Peer broadcasting: ", messageStr);)
+			DEBUG_LOG_AT(UDP, Log::log("Peer broadcasting: ", messageStr);)
 		}
 		else
 		{
 			response += CmdProcessor::RESP[(short)Response::WAIT_RETRY];
-			LOG(Log::log("Failed to create UDP message!");)
+			LOG_AT(UDP, Log::log("Failed to create UDP message!");)
 		}
 	}
 
@@ -95,12 +106,12 @@ void UDPpeer::messageTo(const std::string_view& messageStr, const std::string_vi
 		{
 			BGcontroller::broadcast(message, std::string(bgID));
 			response += CmdProcessor::RESP[(short)Response::SUCCESS];
-			DEBUG_LOG(Log::log("Peer broadcasting: ", messageStr);)
+			DEBUG_LOG_AT(UDP, Log::log("Peer broadcasting: ", messageStr);)
 		}
 		else
 		{
 			response += CmdProcessor::RESP[(short)Response::WAIT_RETRY];
-			LOG(Log::log("Failed to create UDP message!");)
+			LOG_AT(UDP, Log::log("Failed to create UDP message!");)
 		}
 	}
 
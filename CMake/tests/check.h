@@ -0,0 +1,41 @@
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <cstdio>
+#include <vector>
+
+/*******************************************************************************************
+* @brief Unit test registered with TEST_CASE
+********************************************************************************************/
+struct TestCase
+{
+	const char* name;						// Name of the test function
+	void (*function)();						// Test function
+};
+
+/*******************************************************************************************
+* @brief Get all the registered unit tests
+********************************************************************************************/
+std::vector<TestCase>& testCases();
+extern int failedCheckCount;				// Number of failed CHECKs of all tests
+
+struct TestRegistrar
+{
+	TestRegistrar(const char* name, void (*function)())
+	{
+		testCases().push_back({ name, function });
+	}
+};
+
+/*******************************************************************************************
+* @brief Define and register a unit test
+*
+* @details
+* TEST_CASE(nameOfTest) { CHECK(condition); ... }. A failed CHECK prints the file, line and
+* condition and the test goes on; rtds-tests fails if any CHECK failed.
+********************************************************************************************/
+#define TEST_CASE(name) static void name(); static TestRegistrar name##Registrar(#name, &name); static void name()
+#define CHECK(condition) do { if (!(condition)) { failedCheckCount++; \
+	std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); } } while (false)
+
+#endif
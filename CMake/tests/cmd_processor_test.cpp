@@ -0,0 +1,82 @@
+#include "check.h"
+#include "cmd_processor.h"
+
+TEST_CASE(portNumberArgumentIsValidated)
+{
+	unsigned short portNumber = 0;
+	CHECK(CmdProcessor::isPortNumber("321", portNumber) && portNumber == 321);
+	CHECK(CmdProcessor::isPortNumber("65535", portNumber) && portNumber == 65535);
+	CHECK(!CmdProcessor::isPortNumber("65536", portNumber));
+	CHECK(!CmdProcessor::isPortNumber("123456", portNumber));
+	CHECK(!CmdProcessor::isPortNumber("32a", portNumber));
+	CHECK(!CmdProcessor::isPortNumber("", portNumber));
+	CHECK(portNumber == 65535);
+}
+
+TEST_CASE(threadCountArgumentIsValidated)
+{
+	short threadCount = 0;
+	CHECK(CmdProcessor::isThreadCount("2", threadCount) && threadCount == MIN_THREAD_COUNT);
+	CHECK(!CmdProcessor::isThreadCount("1", threadCount));
+	CHECK(!CmdProcessor::isThreadCount("99999", threadCount));
+	CHECK(!CmdProcessor::isThreadCount("-4", threadCount));
+	CHECK(threadCount == MIN_THREAD_COUNT);
+}
+
+TEST_CASE(extractElementSplitsAtTabs)
+{
+	std::string_view command("listen\tgroup1\ttag1");
+	CHECK(CmdProcessor::extractElement(command) == "listen");
+	CHECK(CmdProcessor::extractElement(command) == "group1");
+	CHECK(CmdProcessor::extractElement(command) == "tag1");
+	CHECK(command.empty());
+
+	std::string_view emptyTag("leave\t");
+	CHECK(CmdProcessor::extractElement(emptyTag) == "leave");
+	CHECK(emptyTag == "\t");
+	CHECK(CmdProcessor::extractElement(emptyTag).empty());
+}
+
+TEST_CASE(bgidAndTagAreValidated)
+{
+	CHECK(CmdProcessor::isBGID("group1"));
+	CHECK(!CmdProcessor::isBGID("g"));
+	CHECK(!CmdProcessor::isBGID("group 1"));
+	CHECK(!CmdProcessor::isBGID(std::string(1000, 'g')));
+	CHECK(CmdProcessor::isTag("tag1"));
+	CHECK(CmdProcessor::isTag(""));
+	CHECK(!CmdProcessor::isTag("tag\x7F"));
+	CHECK(!CmdProcessor::isTag(std::string(1000, 't')));
+}
+
+TEST_CASE(findCommandFindsPeerCommands)
+{
+	CHECK(CmdProcessor::findCommand("broadcast") == (short)Command::BROADCAST);
+	CHECK(CmdProcessor::findCommand("message") == (short)Command::MESSAGE);
+	CHECK(CmdProcessor::findCommand("ping") == (short)Command::PING);
+	CHECK(CmdProcessor::findCommand("listen") == (short)Command::LISTEN);
+	CHECK(CmdProcessor::findCommand("leave") == (short)Command::LEAVE);
+	CHECK(CmdProcessor::findCommand("change") == (short)Command::CHANGE);
+	CHECK(CmdProcessor::findCommand("exit") == (short)Command::EXIT);
+}
+
+TEST_CASE(findCommandFindsCCMcommands)
+{
+	CHECK(CmdProcessor::findCommand("login") == (short)Command::LOGIN);
+	CHECK(CmdProcessor::findCommand("abort") == (short)Command::ABORT);
+	CHECK(CmdProcessor::findCommand("status") == (short)Command::STATUS);
+	CHECK(CmdProcessor::findCommand("reload") == (short)Command::RELOAD);
+	CHECK(CmdProcessor::findCommand("stats") == (short)Command::STATS);
+	CHECK(CmdProcessor::findCommand("latency") == (short)Command::LATENCY);
+	CHECK(CmdProcessor::findCommand("loglevel") == (short)Command::LOGLEVEL);
+	CHECK(CmdProcessor::findCommand("dump") == (short)Command::DUMP);
+}
+
+TEST_CASE(findCommandRejectsUnknownCommands)
+{
+	CHECK(CmdProcessor::findCommand("") == COMMAND_COUNT);
+	CHECK(CmdProcessor::findCommand("pin") == COMMAND_COUNT);
+	CHECK(CmdProcessor::findCommand("pings") == COMMAND_COUNT);
+	CHECK(CmdProcessor::findCommand("PING") == COMMAND_COUNT);
+	CHECK(CmdProcessor::findCommand(std::string_view("ping\tgroup", 4)) == (short)Command::PING);
+}
@@ -0,0 +1,95 @@
+#include "check.h"
+#include "rtds_settings.h"
+#include "runtime_limits.h"
+#include <fstream>
+
+#define TEST_CONFIG_FILE "rtds-tests.conf"	// Configuration file written by the tests
+
+/*******************************************************************************************
+* @brief Write the test configuration file
+********************************************************************************************/
+static void writeConfig(const std::string& content)
+{
+	std::ofstream configFile(TEST_CONFIG_FILE, std::ios::trunc);
+	configFile << content;
+}
+
+TEST_CASE(configFileSetsLimitsAndSettings)
+{
+	writeConfig("# RTDS test configuration\n\n  max_broadcast_size = 300  \nmax_loop_lag=250\r\n"
+		"\tudp_ping_rate = 7\nmax_threads = 32\n");
+	Settings::processArgument("-f" TEST_CONFIG_FILE);
+	CHECK(Settings::mConfigPath == TEST_CONFIG_FILE);
+	CHECK(RuntimeLimits::get(Limit::MAX_BROADCAST_SIZE) == 300);
+	CHECK(RuntimeLimits::get(Limit::MAX_THREAD_COUNT) == 32);
+	CHECK(Settings::mMaxLoopLag == 250);
+	CHECK(Settings::mUDPpingRate == 7);
+	Settings::mUDPpingRate = DEF_UDP_PING_RATE;
+}
+
+TEST_CASE(configReloadAppliesReloadableKeys)
+{
+	Settings::mConfigPath = TEST_CONFIG_FILE;
+	auto portNumber = Settings::mRTDSportNo;
+	auto bufferSize = RuntimeLimits::get(Limit::BUFF_SIZE);
+	writeConfig("max_broadcast_size = 200\nmax_source_connections = 4\nport = 999\nbuffer_size = 1024\n");
+	std::string report;
+	CHECK(Settings::reloadConfig(report));
+	CHECK(report == "ignored=port,buffer_size");
+	CHECK(RuntimeLimits::get(Limit::MAX_BROADCAST_SIZE) == 200);
+	CHECK(RuntimeLimits::get(Limit::BUFF_SIZE) == bufferSize);
+	CHECK(Settings::mMaxSourceConnections == 4);
+	CHECK(Settings::mRTDSportNo == portNumber);
+}
+
+TEST_CASE(configReloadRejectsBadKeysAndChangesNothing)
+{
+	Settings::mConfigPath = TEST_CONFIG_FILE;
+	writeConfig("max_broadcast_size = 200\nmax_source_connections = 4\n");
+	std::string report;
+	CHECK(Settings::reloadConfig(report));
+	auto maxPending = Settings::mMaxPending.load();
+
+	writeConfig("max_broadcast_size = 100\nmax_pending = abc\nunknown_key = 1\nmax_threads = 4\nmax_source_connections = 8\n");
+	CHECK(!Settings::reloadConfig(report));
+	CHECK(report == "rejected=max_pending,unknown_key\tignored=max_threads");
+	CHECK(RuntimeLimits::get(Limit::MAX_BROADCAST_SIZE) == 200);
+	CHECK(Settings::mMaxPending == maxPending);
+	CHECK(Settings::mMaxSourceConnections == 4);
+
+	writeConfig("max_tag_size = 0\n");
+	CHECK(!Settings::reloadConfig(report));
+	CHECK(report == "rejected=max_tag_size");
+}
+
+TEST_CASE(configReloadRejectsInconsistentLimits)
+{
+	Settings::mConfigPath = TEST_CONFIG_FILE;
+	auto maxTagSize = RuntimeLimits::get(Limit::MAX_TAG_SIZE);
+	writeConfig("min_tag_size = 20\nmax_tag_size = 10\nmax_loop_lag = 50\n");
+	std::string report;
+	CHECK(!Settings::reloadConfig(report));
+	CHECK(report == "rejected=min_tag_size,max_tag_size");
+	CHECK(RuntimeLimits::get(Limit::MAX_TAG_SIZE) == maxTagSize);
+	CHECK(Settings::mMaxLoopLag != 50);
+}
+
+TEST_CASE(configReloadFailsOnUnreadableFile)
+{
+	Settings::mConfigPath = TEST_CONFIG_FILE;
+	writeConfig("max_broadcast_size 100\n");
+	std::string report = "old";
+	CHECK(!Settings::reloadConfig(report));
+	CHECK(report.empty());
+
+	Settings::mConfigPath = "rtds-tests-missing.conf";
+	CHECK(!Settings::reloadConfig(report));
+
+	Settings::mConfigPath = TEST_CONFIG_FILE;
+	writeConfig("max_broadcast_size = " + std::to_string(DEF_MAX_BROADCAST_SIZE) +
+		"\nmax_loop_lag = " + std::to_string(DEF_MAX_LOOP_LAG) +
+		"\nmax_source_connections = " + std::to_string(DEF_MAX_SOURCE_CONNECTIONS) + "\n");
+	CHECK(Settings::reloadConfig(report));
+	Settings::mConfigPath.clear();
+	std::remove(TEST_CONFIG_FILE);
+}
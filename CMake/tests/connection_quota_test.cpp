@@ -0,0 +1,105 @@
+#include "check.h"
+#include "connection_quota.h"
+#include "metrics.h"
+#include <vector>
+
+/*******************************************************************************************
+* @brief Make the IPv4 address 10.x.y.z of a source number
+********************************************************************************************/
+static asio::ip::address sourceAddress(const std::uint32_t source)
+{
+	return asio::ip::address_v4((10u << 24) | (source & 0xFFFFFF));
+}
+
+TEST_CASE(quotaLimitsOpenConnectionsPerSource)
+{
+	ConnectionQuota::setLimits(2, 0);
+	auto source = asio::ip::make_address("10.200.0.1");
+	auto first = ConnectionQuota::acquire(Listener::TCP, source);
+	auto second = ConnectionQuota::acquire(Listener::TCP, source);
+	CHECK(first != QUOTA_REJECTED && first != QUOTA_UNTRACKED);
+	CHECK(second != QUOTA_REJECTED && second != QUOTA_UNTRACKED);
+	CHECK(ConnectionQuota::acquire(Listener::TCP, source) == QUOTA_REJECTED);
+
+	auto otherSource = ConnectionQuota::acquire(Listener::TCP, asio::ip::make_address("10.200.0.2"));
+	auto otherListener = ConnectionQuota::acquire(Listener::SSL, source);
+	CHECK(otherSource != QUOTA_REJECTED);
+	CHECK(otherListener != QUOTA_REJECTED);
+
+	ConnectionQuota::release(first);
+	auto third = ConnectionQuota::acquire(Listener::TCP, source);
+	CHECK(third != QUOTA_REJECTED);
+	for (auto slot : { second, third, otherSource, otherListener })
+		ConnectionQuota::release(slot);
+	ConnectionQuota::setLimits(0, 0);
+}
+
+TEST_CASE(quotaCountsSourcesByAddressPrefix)
+{
+	ConnectionQuota::setLimits(1, 0);
+	auto v6slot = ConnectionQuota::acquire(Listener::TCP, asio::ip::make_address("2001:db8::1"));
+	CHECK(v6slot != QUOTA_REJECTED);
+	CHECK(ConnectionQuota::acquire(Listener::TCP, asio::ip::make_address("2001:db8::2")) == QUOTA_REJECTED);
+	auto otherPrefix = ConnectionQuota::acquire(Listener::TCP, asio::ip::make_address("2001:db8:0:1::1"));
+	CHECK(otherPrefix != QUOTA_REJECTED);
+
+	auto v4slot = ConnectionQuota::acquire(Listener::TCP, asio::ip::make_address("10.200.0.3"));
+	CHECK(v4slot != QUOTA_REJECTED);
+	CHECK(ConnectionQuota::acquire(Listener::TCP, asio::ip::make_address("::ffff:10.200.0.3")) == QUOTA_REJECTED);
+	CHECK(ConnectionQuota::acquire(Listener::TCP, asio::ip::make_address("10.200.0.4")) != QUOTA_REJECTED);
+	for (auto slot : { v6slot, otherPrefix, v4slot })
+		ConnectionQuota::release(slot);
+	ConnectionQuota::setLimits(0, 0);
+}
+
+TEST_CASE(quotaLimitsConnectRatePerSource)
+{
+	const unsigned int connectRate = 5;
+	ConnectionQuota::setLimits(0, connectRate);
+	auto source = asio::ip::make_address("10.201.0.1");
+	std::vector<std::uint32_t> slots;
+	for (unsigned int connect = 0; connect < connectRate; connect++)
+		slots.push_back(ConnectionQuota::acquire(Listener::TCP, source));
+	for (auto slot : slots)
+		CHECK(slot != QUOTA_REJECTED);
+	CHECK(ConnectionQuota::acquire(Listener::TCP, source) == QUOTA_REJECTED);
+	CHECK(ConnectionQuota::acquire(Listener::TCP, asio::ip::make_address("10.201.0.2")) != QUOTA_REJECTED);
+	for (auto slot : slots)
+		ConnectionQuota::release(slot);
+	ConnectionQuota::setLimits(0, 0);
+}
+
+TEST_CASE(quotaEvictsSourcesWhenTableIsFull)
+{
+	ConnectionQuota::setLimits(1, 0);
+	const std::uint32_t sourceCount = (std::uint32_t(1) << QUOTA_TABLE_BITS) + 4096;
+	std::vector<std::uint32_t> slots;
+	auto evictingSource = sourceCount;
+	int rejectedCount = 0;
+	for (std::uint32_t source = 0; source < sourceCount; source++)
+	{
+		auto evictionCount = Metrics::value(Metric::QUOTA_EVICTIONS);
+		slots.push_back(ConnectionQuota::acquire(Listener::TCP, sourceAddress(source)));
+		if (slots.back() == QUOTA_REJECTED)
+			rejectedCount++;
+		if (Metrics::value(Metric::QUOTA_EVICTIONS) > evictionCount)
+			evictingSource = source;
+	}
+	CHECK(rejectedCount == 0);
+	CHECK(evictingSource < sourceCount);
+	if (evictingSource == sourceCount)
+		return;
+
+	// The slot of the evicted source must not release the connection of the source that took its entry
+	for (std::uint32_t source = 0; source < sourceCount; source++)
+	{
+		if (source != evictingSource)
+			ConnectionQuota::release(slots[source]);
+	}
+	CHECK(ConnectionQuota::acquire(Listener::TCP, sourceAddress(evictingSource)) == QUOTA_REJECTED);
+	ConnectionQuota::release(slots[evictingSource]);
+	auto slot = ConnectionQuota::acquire(Listener::TCP, sourceAddress(evictingSource));
+	CHECK(slot != QUOTA_REJECTED);
+	ConnectionQuota::release(slot);
+	ConnectionQuota::setLimits(0, 0);
+}
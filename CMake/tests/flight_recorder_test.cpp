@@ -0,0 +1,101 @@
+#include "check.h"
+#include "flight_recorder.h"
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*******************************************************************************************
+* @brief Dump the flight recorder and read FLIGHT_DUMP_FILE back
+*
+* @return				Fields of each line
+********************************************************************************************/
+static std::vector<std::vector<std::string>> dumpEvents()
+{
+	std::vector<std::vector<std::string>> lines;
+	if (!FlightRecorder::dump())
+		return lines;
+	FlightRecorder::waitForDump();
+	std::ifstream dumpFile(FLIGHT_DUMP_FILE);
+	std::string line;
+	while (std::getline(dumpFile, line))
+	{
+		std::vector<std::string> fields;
+		std::stringstream lineStream(line);
+		std::string field;
+		while (std::getline(lineStream, field, '\t'))
+			fields.push_back(field);
+		if (!line.empty() && line.back() == '\t')
+			fields.emplace_back();
+		lines.push_back(fields);
+	}
+	return lines;
+}
+
+/*******************************************************************************************
+* @brief Find the last dumped event with the value
+********************************************************************************************/
+static const std::vector<std::string>* findEvent(const std::vector<std::vector<std::string>>& lines, const std::string& value)
+{
+	const std::vector<std::string>* found = nullptr;
+	for (auto& fields : lines)
+	{
+		if (fields.size() == 5 && fields[3] == value)
+			found = &fields;
+	}
+	return found;
+}
+
+TEST_CASE(flightRecorderFormatsEvents)
+{
+	FlightRecorder::record(FlightEvent::ACCEPT, 4001, "127.0.0.1:5000");
+	FlightRecorder::record(FlightEvent::FAILURE, -4002, "reset\tby\npeer");
+	FlightRecorder::record(FlightEvent::DROP, 4003, std::string(FLIGHT_DETAIL_SIZE + 10, 'x'));
+	FlightRecorder::record(FlightEvent::ABORT, 4004);
+	auto lines = dumpEvents();
+	CHECK(!lines.empty());
+	if (lines.empty())
+		return;
+	CHECK((lines[0] == std::vector<std::string>{ "thread", "time", "event", "value", "detail" }));
+
+	auto accept = findEvent(lines, "4001");
+	CHECK(accept != nullptr);
+	if (accept != nullptr)
+	{
+		CHECK((*accept)[2] == "ACCEPT");
+		CHECK((*accept)[4] == "127.0.0.1:5000");
+		auto& time = (*accept)[1];
+		auto separator = time.find('.');
+		CHECK(separator != std::string::npos && separator > 0 && time.size() - separator - 1 == 6);
+		CHECK(time.find_first_not_of("0123456789.") == std::string::npos);
+	}
+	auto failure = findEvent(lines, "-4002");
+	CHECK(failure != nullptr && (*failure)[2] == "FAILURE" && (*failure)[4] == "reset by peer");
+	auto drop = findEvent(lines, "4003");
+	CHECK(drop != nullptr && (*drop)[2] == "DROP" && (*drop)[4] == std::string(FLIGHT_DETAIL_SIZE, 'x'));
+	auto abortEvent = findEvent(lines, "4004");
+	CHECK(abortEvent != nullptr && (*abortEvent)[2] == "ABORT" && (*abortEvent)[4].empty());
+}
+
+TEST_CASE(flightRecorderKeepsEventsPerThread)
+{
+	FlightRecorder::record(FlightEvent::JOIN, 4101, "group1");
+	std::thread recordThread([]() { FlightRecorder::record(FlightEvent::LEAVE, 4102, "group1"); });
+	recordThread.join();
+	auto lines = dumpEvents();
+	auto join = findEvent(lines, "4101");
+	auto leave = findEvent(lines, "4102");
+	CHECK(join != nullptr && leave != nullptr);
+	if (join != nullptr && leave != nullptr)
+		CHECK((*join)[0] != (*leave)[0]);
+}
+
+TEST_CASE(flightRecorderKeepsLastEvents)
+{
+	for (int index = 0; index < FLIGHT_RING_SIZE + 10; index++)
+		FlightRecorder::record(FlightEvent::SLOW, 4200000 + index, "command");
+	auto lines = dumpEvents();
+	CHECK(findEvent(lines, std::to_string(4200000)) == nullptr);
+	CHECK(findEvent(lines, std::to_string(4200000 + FLIGHT_RING_SIZE + 9)) != nullptr);
+}
@@ -0,0 +1,31 @@
+#include "check.h"
+#include <cstring>
+
+int failedCheckCount = 0;
+
+std::vector<TestCase>& testCases()
+{
+	static std::vector<TestCase> cases;
+	return cases;
+}
+
+/*******************************************************************************************
+* @brief Run the unit tests (all, or those whose name contains the first argument)
+*
+* @return				0 if every CHECK passed
+********************************************************************************************/
+int main(int argCount, const char* args[])
+{
+	int runCount = 0;
+	for (auto& testCase : testCases())
+	{
+		if (argCount > 1 && std::strstr(testCase.name, args[1]) == nullptr)
+			continue;
+		auto failedBefore = failedCheckCount;
+		testCase.function();
+		std::printf("%s %s\n", (failedCheckCount == failedBefore) ? "PASS" : "FAIL", testCase.name);
+		runCount++;
+	}
+	std::printf("%d tests, %d failed checks\n", runCount, failedCheckCount);
+	return (failedCheckCount == 0 && runCount > 0) ? 0 : 1;
+}
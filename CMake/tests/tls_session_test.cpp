@@ -0,0 +1,92 @@
+#include "check.h"
+#include "tls_session.h"
+#include <cstring>
+#include <mutex>
+
+struct TLSsessionTest
+{
+/*******************************************************************************************
+* @brief Create the ticket keys (once) as the SSL contexts do
+********************************************************************************************/
+	static void configure()
+	{
+		asio::ssl::context sslContext(asio::ssl::context::tls_server);
+		TLSsession::configure(sslContext, "rtds-tests");
+	}
+/*******************************************************************************************
+* @brief Make the current key TICKET_KEY_LIFETIME old, so the next ticket rotates it
+********************************************************************************************/
+	static void ageCurrentKey()
+	{
+		std::lock_guard<std::shared_mutex> writeLock(TLSsession::mKeyLock);
+		TLSsession::mKeyCreatedTime -= std::chrono::seconds(TICKET_KEY_LIFETIME);
+	}
+/*******************************************************************************************
+* @brief Run the ticket key callback as OpenSSL does for a new or a received ticket
+*
+* @param[in,out]		Key name (set when encrypting)
+* @param[in]			True to issue a ticket, false to decrypt one
+* @return				Callback result
+********************************************************************************************/
+	static int ticketKey(unsigned char* keyName, const bool encrypt)
+	{
+		unsigned char iv[EVP_MAX_IV_LENGTH] = {};
+		auto cipherCtx = ::EVP_CIPHER_CTX_new();
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+		auto mac = ::EVP_MAC_fetch(nullptr, "HMAC", nullptr);
+		auto macCtx = ::EVP_MAC_CTX_new(mac);
+#else
+		auto macCtx = ::HMAC_CTX_new();
+#endif
+		auto result = TLSsession::mTicketKeyCallback(nullptr, keyName, iv, cipherCtx, macCtx, encrypt ? 1 : 0);
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+		::EVP_MAC_CTX_free(macCtx);
+		::EVP_MAC_free(mac);
+#else
+		::HMAC_CTX_free(macCtx);
+#endif
+		::EVP_CIPHER_CTX_free(cipherCtx);
+		return result;
+	}
+};
+
+TEST_CASE(ticketOfCurrentKeyIsAccepted)
+{
+	TLSsessionTest::configure();
+	unsigned char keyName[TICKET_KEY_NAME_SIZE];
+	CHECK(TLSsessionTest::ticketKey(keyName, true) == 1);
+	CHECK(TLSsessionTest::ticketKey(keyName, false) == 1);
+
+	unsigned char unknownName[TICKET_KEY_NAME_SIZE];
+	std::memcpy(unknownName, keyName, TICKET_KEY_NAME_SIZE);
+	unknownName[0] ^= 0xFF;
+	CHECK(TLSsessionTest::ticketKey(unknownName, false) == 0);
+}
+
+TEST_CASE(ticketOfRotatedKeyIsRenewed)
+{
+	TLSsessionTest::configure();
+	unsigned char oldName[TICKET_KEY_NAME_SIZE], newName[TICKET_KEY_NAME_SIZE];
+	CHECK(TLSsessionTest::ticketKey(oldName, true) == 1);
+	TLSsessionTest::ageCurrentKey();
+	CHECK(TLSsessionTest::ticketKey(newName, true) == 1);
+	CHECK(std::memcmp(oldName, newName, TICKET_KEY_NAME_SIZE) != 0);
+	CHECK(TLSsessionTest::ticketKey(oldName, false) == 2);
+	CHECK(TLSsessionTest::ticketKey(newName, false) == 1);
+}
+
+TEST_CASE(ticketKeyIsDroppedAfterSessionTimeout)
+{
+	TLSsessionTest::configure();
+	unsigned char oldName[TICKET_KEY_NAME_SIZE], newName[TICKET_KEY_NAME_SIZE];
+	CHECK(TLSsessionTest::ticketKey(oldName, true) == 1);
+	for (int rotation = 1; rotation < TICKET_KEY_COUNT; rotation++)
+	{
+		TLSsessionTest::ageCurrentKey();
+		CHECK(TLSsessionTest::ticketKey(newName, true) == 1);
+	}
+	CHECK(TLSsessionTest::ticketKey(oldName, false) == 2);
+	TLSsessionTest::ageCurrentKey();
+	CHECK(TLSsessionTest::ticketKey(newName, true) == 1);
+	CHECK(TLSsessionTest::ticketKey(oldName, false) == 0);
+}
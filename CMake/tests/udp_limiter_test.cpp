@@ -0,0 +1,64 @@
+#include "check.h"
+#include "udp_limiter.h"
+#include "metrics.h"
+#include <chrono>
+#include <thread>
+
+/*******************************************************************************************
+* @brief Send commands from a source until its budget refuses one
+*
+* @return				Number of commands allowed (at most maxCount)
+********************************************************************************************/
+static int allowedCount(const asio::ip::udp::endpoint& endpoint, const Command command, const int maxCount)
+{
+	int count = 0;
+	while (count < maxCount && UDPlimiter::allow(endpoint, (short)command))
+		count++;
+	return count;
+}
+
+TEST_CASE(udpLimiterAllowsAllWithoutRate)
+{
+	UDPlimiter::setLimits(0, 0);
+	asio::ip::udp::endpoint source(asio::ip::make_address("10.210.0.1"), 5000);
+	CHECK(allowedCount(source, Command::PING, 1000) == 1000);
+	CHECK(allowedCount(source, Command::BROADCAST, 1000) == 1000);
+}
+
+TEST_CASE(udpLimiterLimitsPingsPerSource)
+{
+	UDPlimiter::setLimits(3, 0);
+	asio::ip::udp::endpoint source(asio::ip::make_address("10.211.0.1"), 5000);
+	auto limitedBefore = Metrics::value(Metric::UDP_PING_LIMITED);
+	CHECK(allowedCount(source, Command::PING, 10) == 3);
+	CHECK(Metrics::value(Metric::UDP_PING_LIMITED) == limitedBefore + 1);
+	CHECK(!UDPlimiter::allow(asio::ip::udp::endpoint(source.address(), 5001), (short)Command::PING));
+	CHECK(!UDPlimiter::allow(source, (short)Command::LISTEN));
+	CHECK(allowedCount(source, Command::BROADCAST, 10) == 10);
+	CHECK(allowedCount(asio::ip::udp::endpoint(asio::ip::make_address("10.211.0.2"), 5000), Command::PING, 10) == 3);
+	UDPlimiter::setLimits(0, 0);
+}
+
+TEST_CASE(udpLimiterKeepsSeparateBudgets)
+{
+	UDPlimiter::setLimits(2, 4);
+	asio::ip::udp::endpoint source(asio::ip::make_address("10.212.0.1"), 5000);
+	auto limitedBefore = Metrics::value(Metric::UDP_FANOUT_LIMITED);
+	CHECK(allowedCount(source, Command::BROADCAST, 2) == 2);
+	CHECK(allowedCount(source, Command::MESSAGE, 10) == 2);
+	CHECK(Metrics::value(Metric::UDP_FANOUT_LIMITED) == limitedBefore + 1);
+	CHECK(allowedCount(source, Command::PING, 10) == 2);
+	UDPlimiter::setLimits(0, 0);
+}
+
+TEST_CASE(udpLimiterRefillsBudget)
+{
+	const int pingRate = 100;
+	UDPlimiter::setLimits(pingRate, 0);
+	asio::ip::udp::endpoint source(asio::ip::make_address("10.213.0.1"), 5000);
+	CHECK(allowedCount(source, Command::PING, pingRate * 2) == pingRate);
+	std::this_thread::sleep_for(std::chrono::milliseconds(1000 / pingRate * 3));
+	auto refilledCount = allowedCount(source, Command::PING, pingRate);
+	CHECK(refilledCount >= 2 && refilledCount < pingRate);
+	UDPlimiter::setLimits(0, 0);
+}